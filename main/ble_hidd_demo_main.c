@@ -28,6 +28,7 @@
 #include "driver/gpio.h"
 #include "hid_dev.h"
 #include "hid_actions.h"
+#include "hid_link.h"
 #include "network_server.h"
 
 /**
@@ -51,8 +52,6 @@
 
 #define HID_DEMO_TAG "HID_DEMO"
 
-static uint16_t hid_conn_id = 0;
-static bool sec_conn = false;
 #define CHAR_DECLARATION_SIZE (sizeof(uint8_t))
 
 static void hidd_event_callback(esp_hidd_cb_event_t event, esp_hidd_cb_param_t *param);
@@ -129,15 +128,18 @@ static void hidd_event_callback(esp_hidd_cb_event_t event, esp_hidd_cb_param_t *
     case ESP_HIDD_EVENT_BLE_CONNECT:
     {
         ESP_LOGI(HID_DEMO_TAG, "ESP_HIDD_EVENT_BLE_CONNECT");
-        hid_conn_id = param->connect.conn_id;
-        network_server_set_hid_conn_id(hid_conn_id);
+        hid_link_on_connect(param->connect.conn_id, param->connect.remote_bda);
+        // Keep advertising so further hosts can connect
+        if (esp_hidd_get_links(NULL, 0) < HID_MAX_LINKS)
+        {
+            esp_ble_gap_start_advertising(&hidd_adv_params);
+        }
         break;
     }
     case ESP_HIDD_EVENT_BLE_DISCONNECT:
     {
-        sec_conn = false;
-        network_server_set_hid_conn_id(UINT16_MAX);
-        ESP_LOGI(HID_DEMO_TAG, "ESP_HIDD_EVENT_BLE_DISCONNECT");
+        hid_link_on_disconnect(param->disconnect.conn_id);
+        ESP_LOGI(HID_DEMO_TAG, "ESP_HIDD_EVENT_BLE_DISCONNECT, conn_id %u", param->disconnect.conn_id);
         esp_ble_gap_start_advertising(&hidd_adv_params);
         break;
     }
@@ -181,8 +183,9 @@ static void gap_event_handler(esp_gap_ble_cb_event_t event, esp_ble_gap_cb_param
         ESP_LOGI(HID_DEMO_TAG, "pair status = %s", param->ble_security.auth_cmpl.success ? "success" : "fail");
         if (param->ble_security.auth_cmpl.success)
         {
-            sec_conn = true;
             ESP_LOGI(HID_DEMO_TAG, "secure connection established.");
+            esp_hidd_set_link_secured(bd_addr, true);
+            hid_link_on_secured(bd_addr);
         }
         else
         {
@@ -190,6 +193,9 @@ static void gap_event_handler(esp_gap_ble_cb_event_t event, esp_ble_gap_cb_param
                      param->ble_security.auth_cmpl.fail_reason);
         }
         break;
+    case ESP_GAP_BLE_UPDATE_CONN_PARAMS_EVT:
+        hid_link_on_conn_params(param);
+        break;
     default:
         break;
     }
@@ -208,6 +214,7 @@ void app_main(void)
     }
     ESP_ERROR_CHECK(ret);
 
+    ESP_ERROR_CHECK(hid_link_init());
     ESP_ERROR_CHECK(network_server_start());
 
     ESP_ERROR_CHECK(esp_bt_controller_mem_release(ESP_BT_MODE_CLASSIC_BT));
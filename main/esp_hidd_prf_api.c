@@ -11,21 +11,6 @@
 #include <string.h>
 #include "esp_log.h"
 
-// HID keyboard input report length
-#define HID_KEYBOARD_IN_RPT_LEN     8
-
-// HID LED output report length
-#define HID_LED_OUT_RPT_LEN         1
-
-// HID mouse input report length
-#define HID_MOUSE_IN_RPT_LEN        5
-
-// HID touch input report length
-#define HID_TOUCH_IN_RPT_LEN        7
-
-// HID consumer control input report length
-#define HID_CC_IN_RPT_LEN           2
-
 esp_err_t esp_hidd_register_callbacks(esp_hidd_event_cb_t callbacks)
 {
     esp_err_t hidd_status;
@@ -87,73 +72,124 @@ uint16_t esp_hidd_get_version(void)
 	return HIDD_VERSION;
 }
 
+uint8_t esp_hidd_get_links(esp_hidd_link_info_t *links, uint8_t max)
+{
+    const hidd_clcb_t *order[HID_MAX_APPS];
+    uint8_t count = 0;
+
+    for (int i = 0; i < HID_MAX_APPS; i++) {
+        const hidd_clcb_t *p_clcb = &hidd_le_env.hidd_clcb[i];
+        if (!p_clcb->in_use) {
+            continue;
+        }
+        // Insert by connection order; there are only a handful of links
+        int j = count++;
+        while (j > 0 && order[j - 1]->seq > p_clcb->seq) {
+            order[j] = order[j - 1];
+            j--;
+        }
+        order[j] = p_clcb;
+    }
+
+    if (links != NULL) {
+        for (uint8_t i = 0; i < count && i < max; i++) {
+            links[i].conn_id = order[i]->conn_id;
+            memcpy(links[i].remote_bda, order[i]->remote_bda, sizeof(esp_bd_addr_t));
+            links[i].secured = order[i]->secured;
+            links[i].notify_mask = order[i]->notify_mask;
+        }
+    }
+    return count;
+}
+
+void esp_hidd_set_link_secured(const esp_bd_addr_t remote_bda, bool secured)
+{
+    for (int i = 0; i < HID_MAX_APPS; i++) {
+        hidd_clcb_t *p_clcb = &hidd_le_env.hidd_clcb[i];
+        if (p_clcb->in_use && memcmp(p_clcb->remote_bda, remote_bda, sizeof(esp_bd_addr_t)) == 0) {
+            p_clcb->secured = secured;
+        }
+    }
+}
+
 void esp_hidd_send_consumer_value(uint16_t conn_id, uint16_t key_cmd, bool key_pressed)
 {
-    uint8_t buffer[HID_CC_IN_RPT_LEN] = {0, 0};
+    uint8_t buffer[HID_RPT_LEN_CC_IN] = {0, 0};
     if (key_pressed) {
         ESP_LOGD(HID_LE_PRF_TAG, "hid_consumer_build_report");
         hid_consumer_build_report(buffer, key_cmd);
     }
     ESP_LOGD(HID_LE_PRF_TAG, "buffer[0] = %x, buffer[1] = %x", buffer[0], buffer[1]);
     hid_dev_send_report(hidd_le_env.gatt_if, conn_id,
-                        HID_RPT_ID_CC_IN, HID_REPORT_TYPE_INPUT, HID_CC_IN_RPT_LEN, buffer);
+                        HID_RPT_ID_CC_IN, HID_REPORT_TYPE_INPUT, HID_RPT_LEN_CC_IN, buffer);
     return;
 }
 
 void esp_hidd_send_keyboard_value(uint16_t conn_id, key_mask_t special_key_mask, uint8_t *keyboard_cmd, uint8_t num_key)
 {
-    if (num_key > HID_KEYBOARD_IN_RPT_LEN - 2) {
-        ESP_LOGE(HID_LE_PRF_TAG, "%s(), the number key should not be more than %d", __func__, HID_KEYBOARD_IN_RPT_LEN);
+    if (num_key > HID_KEYBOARD_KEY_SLOTS) {
+        ESP_LOGE(HID_LE_PRF_TAG, "%s(), the number key should not be more than %d", __func__, HID_KEYBOARD_KEY_SLOTS);
         return;
     }
 
-    uint8_t buffer[HID_KEYBOARD_IN_RPT_LEN] = {0};
-
-    buffer[0] = special_key_mask;
-
-    for (int i = 0; i < num_key; i++) {
-        buffer[i+2] = keyboard_cmd[i];
-    }
+    uint8_t buffer[HID_RPT_LEN_KEY_IN] = {0};
+    hid_pack_keyboard(buffer, special_key_mask, keyboard_cmd, num_key);
 
     ESP_LOGD(HID_LE_PRF_TAG, "the key vaule = %d,%d,%d, %d, %d, %d,%d, %d", buffer[0], buffer[1], buffer[2], buffer[3], buffer[4], buffer[5], buffer[6], buffer[7]);
     hid_dev_send_report(hidd_le_env.gatt_if, conn_id,
-                        HID_RPT_ID_KEY_IN, HID_REPORT_TYPE_INPUT, HID_KEYBOARD_IN_RPT_LEN, buffer);
+                        HID_RPT_ID_KEY_IN, HID_REPORT_TYPE_INPUT, HID_RPT_LEN_KEY_IN, buffer);
     return;
 }
 
 void esp_hidd_send_mouse_value(uint16_t conn_id, uint8_t mouse_button, int8_t mickeys_x, int8_t mickeys_y)
 {
-    uint8_t buffer[HID_MOUSE_IN_RPT_LEN];
+    uint8_t buffer[HID_RPT_LEN_MOUSE_IN];
 
-    buffer[0] = mouse_button;   // 按键
-    buffer[1] = mickeys_x;      // X 位移
-    buffer[2] = mickeys_y;      // Y 位移
-    buffer[3] = 0;              // 滚轮
-    buffer[4] = 0;              // AC Pan
+    hid_pack_mouse(buffer, mouse_button, mickeys_x, mickeys_y, 0);
 
     hid_dev_send_report(hidd_le_env.gatt_if, conn_id,
-                        HID_RPT_ID_MOUSE_IN, HID_REPORT_TYPE_INPUT, HID_MOUSE_IN_RPT_LEN, buffer);
+                        HID_RPT_ID_MOUSE_IN, HID_REPORT_TYPE_INPUT, HID_RPT_LEN_MOUSE_IN, buffer);
     return;
 }
 
 void esp_hidd_send_touch_value(uint16_t conn_id, bool touch_down, uint16_t coord_x, uint16_t coord_y)
 {
-    uint8_t buffer[HID_TOUCH_IN_RPT_LEN] = {0};
-
-    buffer[1] = 0x00; // 单指触点编号固定为 0
+    const esp_hidd_touch_contact_t contact = {
+        .id = 0,
+        .tip = touch_down,
+        .x = coord_x,
+        .y = coord_y,
+    };
+    esp_hidd_send_touch_frame(conn_id, &contact, 1);
+}
 
-    if (touch_down)
-    {
-        buffer[0] |= 0x01; // Tip Switch
-        buffer[0] |= 0x02; // In Range
-        buffer[6] = 0x01;  // 当前接触点数量
+esp_err_t esp_hidd_send_touch_frame(uint16_t conn_id, const esp_hidd_touch_contact_t *contacts, uint8_t count)
+{
+    if (count > HID_TOUCH_MAX_CONTACTS || (count > 0 && !contacts)) {
+        ESP_LOGE(HID_LE_PRF_TAG, "%s(), the contact count should not be more than %d", __func__, HID_TOUCH_MAX_CONTACTS);
+        return ESP_ERR_INVALID_ARG;
     }
 
-    buffer[2] = (uint8_t)(coord_x & 0xFF);
-    buffer[3] = (uint8_t)((coord_x >> 8) & 0xFF);
-    buffer[4] = (uint8_t)(coord_y & 0xFF);
-    buffer[5] = (uint8_t)((coord_y >> 8) & 0xFF);
+    // Hybrid mode: the first report carries the frame's contact count, the following ones 0
+    uint8_t sent = 0;
+    do {
+        uint8_t buffer[HID_RPT_LEN_TOUCH_IN] = {0};
 
-    hid_dev_send_report(hidd_le_env.gatt_if, conn_id,
-                        HID_RPT_ID_TOUCH_IN, HID_REPORT_TYPE_INPUT, HID_TOUCH_IN_RPT_LEN, buffer);
+        for (int slot = 0; slot < HID_TOUCH_CONTACTS_PER_REPORT && sent < count; slot++) {
+            hid_pack_touch_contact(&buffer[slot * HID_TOUCH_CONTACT_LEN], &contacts[sent++]);
+        }
+
+        if (sent <= HID_TOUCH_CONTACTS_PER_REPORT) {
+            buffer[HID_RPT_LEN_TOUCH_IN - 1] = count;
+        }
+
+        // A hybrid frame missing its first report would be misread, so stop at the first failure
+        esp_err_t err = hid_dev_send_report(hidd_le_env.gatt_if, conn_id,
+                            HID_RPT_ID_TOUCH_IN, HID_REPORT_TYPE_INPUT, HID_RPT_LEN_TOUCH_IN, buffer);
+        if (err != ESP_OK) {
+            return err;
+        }
+    } while (sent < count);
+
+    return ESP_OK;
 }
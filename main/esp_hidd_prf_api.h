@@ -7,6 +7,7 @@
 #ifndef __ESP_HIDD_API_H__
 #define __ESP_HIDD_API_H__
 
+#include "sdkconfig.h"
 #include "esp_bt_defs.h"
 #include "esp_gatt_defs.h"
 #include "esp_err.h"
@@ -53,6 +54,32 @@ typedef enum {
 #define RIGHT_GUI_KEY_MASK           (1 << 7)
 
 typedef uint8_t key_mask_t;
+
+#define HID_TOUCH_MAX_CONTACTS          10  // Contact Count Maximum of the touch screen
+#define HID_TOUCH_CONTACTS_PER_REPORT   3   // Keeps one touch report within a default-MTU notification
+
+// Hosts connected at once, one per ACL link the controller is configured for
+#ifdef CONFIG_BT_ACL_CONNECTIONS
+#define HID_MAX_LINKS                   CONFIG_BT_ACL_CONNECTIONS
+#else
+#define HID_MAX_LINKS                   4
+#endif
+
+/// One connected host
+typedef struct {
+    uint16_t conn_id;
+    esp_bd_addr_t remote_bda;
+    bool secured;                               /*!< Pairing or bonded encryption completed */
+    uint16_t notify_mask;                       /*!< Bit per input report ID whose CCCD enables notifications */
+} esp_hidd_link_info_t;
+
+/// One contact of a touch frame
+typedef struct {
+    uint8_t id;                                 /*!< Contact identifier, 0..HID_TOUCH_MAX_CONTACTS-1 */
+    bool tip;                                   /*!< false reports the lift of this contact */
+    uint16_t x;
+    uint16_t y;
+} esp_hidd_touch_contact_t;
 /**
  * @brief HIDD callback parameters union
  */
@@ -84,6 +111,7 @@ typedef union {
      * @brief ESP_HIDD_EVENT_DISCONNECT
 	 */
     struct hidd_disconnect_evt_param {
+        uint16_t conn_id;
         esp_bd_addr_t remote_bda;                   /*!< HID Remote bluetooth device address */
     } disconnect;									/*!< HID callback param of ESP_HIDD_EVENT_DISCONNECT */
 
@@ -147,6 +175,24 @@ esp_err_t esp_hidd_profile_init(void);
  */
 esp_err_t esp_hidd_profile_deinit(void);
 
+/**
+ *
+ * @brief           Copy the connected hosts, in connection order
+ *
+ * @param[out]      links: up to max entries, may be NULL to only count
+ *
+ * @return          number of connected hosts
+ *
+ */
+uint8_t esp_hidd_get_links(esp_hidd_link_info_t *links, uint8_t max);
+
+/**
+ *
+ * @brief           Record the outcome of pairing or bonded encryption with a host
+ *
+ */
+void esp_hidd_set_link_secured(const esp_bd_addr_t remote_bda, bool secured);
+
 /**
  *
  * @brief           Get hidd profile version
@@ -163,6 +209,20 @@ void esp_hidd_send_keyboard_value(uint16_t conn_id, key_mask_t special_key_mask,
 void esp_hidd_send_mouse_value(uint16_t conn_id, uint8_t mouse_button, int8_t mickeys_x, int8_t mickeys_y);
 void esp_hidd_send_touch_value(uint16_t conn_id, bool touch_down, uint16_t coord_x, uint16_t coord_y);
 
+/**
+ *
+ * @brief           Send every contact of one touch frame. Contacts that are still down must be
+ *                  repeated in each frame until a frame reports their lift.
+ *
+ * @param[in]       contacts: contacts of the frame, lifted ones included
+ * @param[in]       count: number of contacts, at most HID_TOUCH_MAX_CONTACTS
+ *
+ * @return          ESP_OK, or the error of the first report that could not be sent; the
+ *                  rest of the frame is not sent then
+ *
+ */
+esp_err_t esp_hidd_send_touch_frame(uint16_t conn_id, const esp_hidd_touch_contact_t *contacts, uint8_t count);
+
 #ifdef __cplusplus
 }
 #endif
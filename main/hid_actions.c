@@ -4,62 +4,128 @@
 
 #include "hid_actions.h"
 
-#include <math.h>
 #include <stdbool.h>
+#include <string.h>
 
-#include "esp_hidd_prf_api.h"
-#include "hid_dev.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
-#define HID_TOUCH_INTERVAL_MS 16
+
+#include "esp_log.h"
+#include "esp_timer.h"
+
+#include "esp_hidd_prf_api.h"
+#include "hid_dev.h"
+#include "hid_gesture.h"
+#include "hid_keyboard.h"
+#include "hid_link.h"
+#include "hid_pacer.h"
+#include "hid_replay.h"
+
 #define HID_TAP_HOLD_MS 50
 #define HID_LONG_PRESS_MIN_MS 20
 #define HID_KEY_HOLD_MS 60
 #define HID_CONSUMER_HOLD_MS 80
+#define HID_TEXT_MIN_INTERVAL_US 7500 // Shortest BLE connection interval
+#define HID_TOUCH_TAKE_WAIT_MS 500    // How long a gesture waits for a live stroke to lift
+#define HID_TOUCH_TAKE_POLL_MS 10
 
-#define HID_PI 3.1415926f
+static const char *TAG = "HID_ACTIONS";
 
-static inline int16_t hid_clamp_coord(int32_t coord)
+static hid_pacer_stats_t s_last_timing;
+
+static bool hid_touch_begin(uint16_t conn_id, hid_gesture_t *gesture)
 {
-    if (coord < HID_ABS_MIN_COORD)
+    if (hid_gesture_acquire(gesture) != ESP_OK)
     {
-        return HID_ABS_MIN_COORD;
+        ESP_LOGW(TAG, "No free gesture buffer, dropping touch action");
+        return false;
     }
-    if (coord > HID_ABS_MAX_COORD)
+    gesture->interval_us = hid_link_interval_us(conn_id);
+    return true;
+}
+
+// HID_LINK_ALL fans out to every connected host; a single conn_id is used as given
+static uint8_t hid_action_hosts(uint16_t conn_id, uint16_t *conn_ids)
+{
+    if (conn_id != HID_LINK_ALL)
     {
-        return HID_ABS_MAX_COORD;
+        conn_ids[0] = conn_id;
+        return 1;
     }
-    return (int16_t)coord;
+    return hid_link_hosts(conn_id, conn_ids);
 }
 
-static uint16_t hid_map_normalized(float value)
+/*
+ * Take the touch report of every host for the executor, waiting up to HID_TOUCH_TAKE_WAIT_MS
+ * for live strokes to lift. Hosts still held by one are dropped from conn_ids.
+ */
+static uint8_t hid_touch_take_hosts(uint16_t *conn_ids, uint8_t count)
 {
-    if (value < 0.0f)
+    const void *owner = xTaskGetCurrentTaskHandle();
+    const int64_t deadline_us = esp_timer_get_time() + HID_TOUCH_TAKE_WAIT_MS * 1000LL;
+    uint8_t taken = 0;
+    while (taken < count)
     {
-        value = 0.0f;
+        // Taken hosts are moved to the front, the rest are retried
+        for (uint8_t i = taken; i < count; ++i)
+        {
+            if (hid_link_touch_take(conn_ids[i], owner))
+            {
+                const uint16_t id = conn_ids[taken];
+                conn_ids[taken++] = conn_ids[i];
+                conn_ids[i] = id;
+            }
+        }
+        if (taken == count || esp_timer_get_time() >= deadline_us)
+        {
+            break;
+        }
+        vTaskDelay(pdMS_TO_TICKS(HID_TOUCH_TAKE_POLL_MS));
     }
-    else if (value > 1.0f)
+
+    for (uint8_t i = taken; i < count; ++i)
     {
-        value = 1.0f;
+        ESP_LOGW(TAG, "Device %u is busy with live touch input, skipping it", conn_ids[i]);
     }
+    return taken;
+}
 
-    int32_t scaled = (int32_t)(value * HID_ABS_MAX_COORD + 0.5f);
-    return (uint16_t)hid_clamp_coord(scaled);
+static void hid_touch_give_hosts(const uint16_t *conn_ids, uint8_t count)
+{
+    for (uint8_t i = 0; i < count; ++i)
+    {
+        hid_link_touch_give(conn_ids[i], xTaskGetCurrentTaskHandle());
+    }
 }
 
-static void hid_touch_update(uint16_t conn_id, bool touch_down, float norm_x, float norm_y)
+static void hid_touch_play(uint16_t conn_id, hid_gesture_t *gesture)
 {
-    uint16_t mapped_x = hid_map_normalized(norm_x);
-    uint16_t mapped_y = hid_map_normalized(norm_y);
+    uint16_t conn_ids[HID_MAX_LINKS];
+    uint8_t count = hid_touch_take_hosts(conn_ids, hid_action_hosts(conn_id, conn_ids));
+    hid_gesture_play_hosts(conn_ids, count, gesture, &s_last_timing);
+    hid_touch_give_hosts(conn_ids, count);
+    hid_gesture_release(gesture);
+}
 
-    esp_hidd_send_touch_value(conn_id, touch_down, mapped_x, mapped_y);
+void hid_actions_take_last_timing(hid_pacer_stats_t *out)
+{
+    if (out)
+    {
+        *out = s_last_timing;
+    }
+    memset(&s_last_timing, 0, sizeof(s_last_timing));
 }
 
 void hid_touch_tap(uint16_t conn_id, float norm_x, float norm_y)
 {
-    hid_touch_update(conn_id, true, norm_x, norm_y);
-    vTaskDelay(pdMS_TO_TICKS(HID_TAP_HOLD_MS));
-    hid_touch_update(conn_id, false, norm_x, norm_y);
+    hid_gesture_t gesture;
+    if (!hid_touch_begin(conn_id, &gesture))
+    {
+        return;
+    }
+
+    hid_gesture_plan_press(&gesture, 0, norm_x, norm_y, HID_TAP_HOLD_MS);
+    hid_touch_play(conn_id, &gesture);
 }
 
 void hid_touch_long_press(uint16_t conn_id, float norm_x, float norm_y, uint32_t press_ms)
@@ -69,76 +135,199 @@ void hid_touch_long_press(uint16_t conn_id, float norm_x, float norm_y, uint32_t
         press_ms = HID_LONG_PRESS_MIN_MS;
     }
 
-    hid_touch_update(conn_id, true, norm_x, norm_y);
-    vTaskDelay(pdMS_TO_TICKS(press_ms));
-    hid_touch_update(conn_id, false, norm_x, norm_y);
+    hid_gesture_t gesture;
+    if (!hid_touch_begin(conn_id, &gesture))
+    {
+        return;
+    }
+
+    hid_gesture_plan_press(&gesture, 0, norm_x, norm_y, press_ms);
+    hid_touch_play(conn_id, &gesture);
 }
 
 void hid_touch_swipe(uint16_t conn_id, float start_x, float start_y, float end_x, float end_y, uint32_t duration_ms)
 {
     if (duration_ms == 0)
     {
-        duration_ms = 600; // 榛樿鏀炬參婊戝姩閫熷害
+        duration_ms = 600; // 榛樿鏀炬參婊戝姩閫熷害
     }
 
-    if (duration_ms < HID_TOUCH_INTERVAL_MS * 4)
+    hid_gesture_t gesture;
+    if (!hid_touch_begin(conn_id, &gesture))
     {
-        duration_ms = HID_TOUCH_INTERVAL_MS * 4;
+        return;
     }
 
-    const uint32_t interval_ms = HID_TOUCH_INTERVAL_MS;
-    uint32_t steps = duration_ms / interval_ms;
-    if (steps < 5)
+    // The whole trajectory is planned before playback starts, so no math runs between reports
+    hid_gesture_plan_swipe(&gesture, 0, start_x, start_y, end_x, end_y, duration_ms);
+    hid_touch_play(conn_id, &gesture);
+}
+
+void hid_touch_fling(uint16_t conn_id, float start_x, float start_y, float angle_deg, float distance,
+                     float velocity, bool fling)
+{
+    hid_gesture_t gesture;
+    if (!hid_touch_begin(conn_id, &gesture))
     {
-        steps = 5;
+        return;
     }
 
-    hid_touch_update(conn_id, true, start_x, start_y);
+    if (hid_gesture_plan_fling(&gesture, 0, start_x, start_y, angle_deg, distance, velocity, fling) != ESP_OK)
+    {
+        ESP_LOGW(TAG, "Fling does not fit a gesture buffer, dropping touch action");
+        hid_gesture_release(&gesture);
+        return;
+    }
+    hid_touch_play(conn_id, &gesture);
+}
 
-    float dx = end_x - start_x;
-    float dy = end_y - start_y;
-    float path_len = sqrtf(dx * dx + dy * dy);
+void hid_touch_path(uint16_t conn_id, const hid_traj_path_t *path, uint32_t duration_ms)
+{
+    if (duration_ms == 0)
+    {
+        duration_ms = 600;
+    }
 
-    float perp_x = -dy;
-    float perp_y = dx;
-    float perp_len = sqrtf(perp_x * perp_x + perp_y * perp_y);
-    if (perp_len > 0.0001f)
+    hid_gesture_t gesture;
+    if (!hid_touch_begin(conn_id, &gesture))
     {
-        perp_x /= perp_len;
-        perp_y /= perp_len;
+        return;
     }
-    else
+
+    if (hid_gesture_plan_path(&gesture, 0, path, duration_ms) != ESP_OK)
     {
-        perp_x = 0.0f;
-        perp_y = 0.1f;
+        ESP_LOGW(TAG, "Invalid path, dropping touch action");
+        hid_gesture_release(&gesture);
+        return;
     }
+    hid_touch_play(conn_id, &gesture);
+}
 
-    float arc_offset = fmaxf(0.02f, path_len * 0.25f);
+void hid_touch_replay(uint16_t conn_id, int slot)
+{
+    if (conn_id == HID_LINK_ALL)
+    {
+        // Recordings are decoded while they play, so they go to one host
+        ESP_LOGW(TAG, "Replay needs a single device, dropping slot %d", slot);
+    }
+    else if (hid_touch_take_hosts(&conn_id, 1) == 1)
+    {
+        hid_replay_play(conn_id, slot, &s_last_timing);
+        hid_touch_give_hosts(&conn_id, 1);
+    }
+    hid_replay_release(slot);
+}
 
-    for (uint32_t i = 1; i <= steps; ++i)
+// One report per connection event; a shorter spacing only queues reports in the stack
+static uint32_t hid_key_interval_us(uint16_t conn_id)
+{
+    uint32_t interval_us = hid_link_interval_us(conn_id);
+    if (interval_us != 0 && interval_us < HID_TEXT_MIN_INTERVAL_US)
     {
-        vTaskDelay(pdMS_TO_TICKS(interval_ms));
+        interval_us = HID_TEXT_MIN_INTERVAL_US;
+    }
+    return interval_us;
+}
+
+static double hid_key_chars_per_s(uint32_t chars, int64_t us)
+{
+    return us > 0 ? chars * 1e6 / us : 0.0;
+}
+
+/*
+ * Planned is what the rollover packing allows at the link's interval, actual includes link
+ * stalls. test/host/bench_typing.c plans the same way off-device and compares with tapping.
+ */
+static void hid_key_log_text(const hid_text_stats_t *stats)
+{
+    const int64_t planned_us = s_last_timing.planned_us;
+    const int64_t actual_us = s_last_timing.actual_us;
+    ESP_LOGI(TAG, "Typed %u chars in %u reports, planned %lld us (%.1f chars/s), actual %lld us (%.1f chars/s)",
+             (unsigned)stats->chars, (unsigned)stats->reports, (long long)planned_us,
+             hid_key_chars_per_s(stats->chars, planned_us), (long long)actual_us,
+             hid_key_chars_per_s(stats->chars, actual_us));
+}
+
+void hid_key_type_text(uint16_t conn_id, int slot)
+{
+    uint16_t conn_ids[HID_MAX_LINKS];
+    uint8_t count = hid_action_hosts(conn_id, conn_ids);
 
-        float t = (float)i / (float)steps;
-        float eased = 0.5f - 0.5f * cosf(t * HID_PI); // ease-in-out to simulate acceleration
-        float along_x = start_x + dx * eased;
-        float along_y = start_y + dy * eased;
+    hid_text_stats_t stats;
+    hid_text_type(conn_ids, count, slot, hid_key_interval_us(conn_id), &s_last_timing, &stats);
+    hid_text_release(slot);
+    hid_key_log_text(&stats);
+}
+
+void hid_key_type_stream(uint16_t conn_id)
+{
+    uint16_t conn_ids[HID_MAX_LINKS];
+    uint8_t count = hid_action_hosts(conn_id, conn_ids);
 
-        float arc = sinf(eased * HID_PI); // create slight arc offset
-        float current_x = along_x + perp_x * arc * arc_offset;
-        float current_y = along_y + perp_y * arc * arc_offset;
+    hid_text_stats_t stats;
+    hid_text_stream_type(conn_ids, count, hid_key_interval_us(conn_id), &s_last_timing, &stats);
+    hid_key_log_text(&stats);
+}
 
-        hid_touch_update(conn_id, true, current_x, current_y);
+static void hid_touch_pair(uint16_t conn_id, float center_x, float center_y, float start_spread, float end_spread,
+                           float start_deg, float end_deg, uint32_t duration_ms)
+{
+    if (duration_ms == 0)
+    {
+        duration_ms = 600;
     }
 
-    hid_touch_update(conn_id, false, end_x, end_y);
+    hid_gesture_t gesture;
+    if (!hid_touch_begin(conn_id, &gesture))
+    {
+        return;
+    }
+
+    hid_gesture_plan_pair(&gesture, 0, center_x, center_y, start_spread, end_spread, start_deg, end_deg, duration_ms);
+    hid_touch_play(conn_id, &gesture);
+}
+
+void hid_touch_pinch(uint16_t conn_id, float center_x, float center_y, float start_spread, float end_spread,
+                     float angle_deg, uint32_t duration_ms)
+{
+    hid_touch_pair(conn_id, center_x, center_y, start_spread, end_spread, angle_deg, angle_deg, duration_ms);
+}
+
+void hid_touch_rotate(uint16_t conn_id, float center_x, float center_y, float spread, float start_deg,
+                      float end_deg, uint32_t duration_ms)
+{
+    hid_touch_pair(conn_id, center_x, center_y, spread, spread, start_deg, end_deg, duration_ms);
+}
+
+static void hid_consumer_send_hosts(hid_pacer_t *pacer, const uint16_t *conn_ids, uint8_t count, uint16_t usage,
+                                    bool pressed)
+{
+    int64_t first_us = esp_timer_get_time();
+    int64_t last_us = first_us;
+    for (uint8_t i = 0; i < count; ++i)
+    {
+        last_us = esp_timer_get_time();
+        esp_hidd_send_consumer_value(conn_ids[i], usage, pressed);
+    }
+    if (count > 1)
+    {
+        hid_pacer_skew(pacer, last_us - first_us);
+    }
 }
 
 static void hid_consumer_click(uint16_t conn_id, uint16_t usage)
 {
-    esp_hidd_send_consumer_value(conn_id, usage, true);
-    vTaskDelay(pdMS_TO_TICKS(HID_CONSUMER_HOLD_MS));
-    esp_hidd_send_consumer_value(conn_id, usage, false);
+    uint16_t conn_ids[HID_MAX_LINKS];
+    uint8_t count = hid_action_hosts(conn_id, conn_ids);
+
+    hid_pacer_t pacer;
+    hid_pacer_begin(&pacer);
+
+    hid_consumer_send_hosts(&pacer, conn_ids, count, usage, true);
+    hid_pacer_wait_until(&pacer, HID_CONSUMER_HOLD_MS * 1000LL);
+    hid_consumer_send_hosts(&pacer, conn_ids, count, usage, false);
+
+    hid_pacer_finish(&pacer, &s_last_timing);
 }
 
 void hid_touch_multi_tap(uint16_t conn_id, uint32_t count, const float *xs, const float *ys)
@@ -148,16 +337,20 @@ void hid_touch_multi_tap(uint16_t conn_id, uint32_t count, const float *xs, cons
         return;
     }
 
-    if (count > 5)
+    if (count > HID_TOUCH_MAX_CONTACTS)
     {
-        count = 5;
+        count = HID_TOUCH_MAX_CONTACTS;
     }
 
-    for (uint32_t i = 0; i < count; ++i)
+    hid_gesture_t gesture;
+    if (!hid_touch_begin(conn_id, &gesture))
     {
-        hid_touch_tap(conn_id, xs[i], ys[i]);
-        vTaskDelay(pdMS_TO_TICKS(100));
+        return;
     }
+
+    // All fingers go down and up in the same frames
+    hid_gesture_plan_multi_press(&gesture, 0, count, xs, ys, HID_TAP_HOLD_MS);
+    hid_touch_play(conn_id, &gesture);
 }
 
 void hid_touch_multi_long_press(uint16_t conn_id, uint32_t count, const float *xs, const float *ys, uint32_t press_ms)
@@ -167,17 +360,27 @@ void hid_touch_multi_long_press(uint16_t conn_id, uint32_t count, const float *x
         return;
     }
 
-    if (count > 5)
+    if (count > HID_TOUCH_MAX_CONTACTS)
+    {
+        count = HID_TOUCH_MAX_CONTACTS;
+    }
+
+    if (press_ms < HID_LONG_PRESS_MIN_MS)
     {
-        count = 5;
+        press_ms = HID_LONG_PRESS_MIN_MS;
     }
 
-    for (uint32_t i = 0; i < count; ++i)
+    hid_gesture_t gesture;
+    if (!hid_touch_begin(conn_id, &gesture))
     {
-        hid_touch_long_press(conn_id, xs[i], ys[i], press_ms);
-        vTaskDelay(pdMS_TO_TICKS(150));
+        return;
     }
+
+    hid_gesture_plan_multi_press(&gesture, 0, count, xs, ys, press_ms);
+
+    hid_touch_play(conn_id, &gesture);
 }
+
 void hid_press_volume_up(uint16_t conn_id)
 {
     hid_consumer_click(conn_id, HID_CONSUMER_VOLUME_UP);
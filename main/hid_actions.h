@@ -6,15 +6,41 @@
 #define HID_ACTIONS_H
 
 #include <stdint.h>
+#include <stdbool.h>
 
-#define HID_ABS_MIN_COORD 0
-#define HID_ABS_MAX_COORD 32767
+#include "hid_pacer.h"
+#include "hid_trajectory.h"
+
+/**
+ * @brief Copy the planned-vs-actual timing of the last paced action and reset it.
+ */
+void hid_actions_take_last_timing(hid_pacer_stats_t *out);
 
 void hid_touch_tap(uint16_t conn_id, float norm_x, float norm_y);
 void hid_touch_long_press(uint16_t conn_id, float norm_x, float norm_y, uint32_t press_ms);
 void hid_touch_swipe(uint16_t conn_id, float start_x, float start_y, float end_x, float end_y, uint32_t duration_ms);
 void hid_touch_multi_tap(uint16_t conn_id, uint32_t count, const float *xs, const float *ys);
 void hid_touch_multi_long_press(uint16_t conn_id, uint32_t count, const float *xs, const float *ys, uint32_t press_ms);
+void hid_touch_pinch(uint16_t conn_id, float center_x, float center_y, float start_spread, float end_spread,
+                     float angle_deg, uint32_t duration_ms);
+void hid_touch_fling(uint16_t conn_id, float start_x, float start_y, float angle_deg, float distance,
+                     float velocity, bool fling);
+void hid_touch_path(uint16_t conn_id, const hid_traj_path_t *path, uint32_t duration_ms);
+/**
+ * @brief Play a recording committed to a hid_replay slot, then release the slot.
+ */
+void hid_touch_replay(uint16_t conn_id, int slot);
+void hid_touch_rotate(uint16_t conn_id, float center_x, float center_y, float spread, float start_deg,
+                      float end_deg, uint32_t duration_ms);
+
+/**
+ * @brief Type a text committed to a hid_keyboard slot, then release the slot.
+ */
+void hid_key_type_text(uint16_t conn_id, int slot);
+/**
+ * @brief Type the open hid_keyboard text stream as it is received, then release it.
+ */
+void hid_key_type_stream(uint16_t conn_id);
 
 void hid_press_volume_up(uint16_t conn_id);
 void hid_press_volume_down(uint16_t conn_id);
@@ -0,0 +1,95 @@
+/*
+ * Touch frame coalescing implementation.
+ */
+
+#include "hid_coalesce.h"
+
+#include <string.h>
+
+#include "freertos/FreeRTOS.h"
+
+// Players run on the executor, httpd and UDP tasks, which can sit on different cores
+static hid_coalesce_stats_t s_stats;
+static portMUX_TYPE s_stats_lock = portMUX_INITIALIZER_UNLOCKED;
+
+static void hid_coalesce_count(uint32_t *counter)
+{
+    taskENTER_CRITICAL(&s_stats_lock);
+    (*counter)++;
+    taskEXIT_CRITICAL(&s_stats_lock);
+}
+
+void hid_coalesce_begin(hid_coalesce_t *co)
+{
+    co->last_count = 0;
+}
+
+// Same contacts in the same order with the same tip state, i.e. nothing went down or up
+static bool hid_coalesce_same_contacts(const hid_coalesce_t *co, const esp_hidd_touch_contact_t *frame, uint8_t count)
+{
+    if (count != co->last_count)
+    {
+        return false;
+    }
+    for (uint8_t i = 0; i < count; ++i)
+    {
+        if (frame[i].id != co->last[i].id || !frame[i].tip || !co->last[i].tip)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+static bool hid_coalesce_same_positions(const hid_coalesce_t *co, const esp_hidd_touch_contact_t *frame, uint8_t count)
+{
+    for (uint8_t i = 0; i < count; ++i)
+    {
+        if (frame[i].x != co->last[i].x || frame[i].y != co->last[i].y)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+esp_err_t hid_coalesce_send(hid_coalesce_t *co, uint16_t conn_id, const esp_hidd_touch_contact_t *frame,
+                            uint8_t count, bool superseded)
+{
+    const bool move = count > 0 && hid_coalesce_same_contacts(co, frame, count);
+    if (move && hid_coalesce_same_positions(co, frame, count))
+    {
+        hid_coalesce_count(&s_stats.duplicates);
+        return ESP_OK;
+    }
+    if (move && superseded)
+    {
+        hid_coalesce_count(&s_stats.superseded);
+        return ESP_OK;
+    }
+
+    esp_err_t err = esp_hidd_send_touch_frame(conn_id, frame, count);
+    if (err != ESP_OK && !move)
+    {
+        err = esp_hidd_send_touch_frame(conn_id, frame, count);
+    }
+    if (err != ESP_OK)
+    {
+        return err;
+    }
+
+    hid_coalesce_count(&s_stats.sent);
+    memcpy(co->last, frame, count * sizeof(frame[0]));
+    co->last_count = count;
+    return ESP_OK;
+}
+
+void hid_coalesce_get_stats(hid_coalesce_stats_t *out)
+{
+    if (out)
+    {
+        taskENTER_CRITICAL(&s_stats_lock);
+        *out = s_stats;
+        taskEXIT_CRITICAL(&s_stats_lock);
+    }
+}
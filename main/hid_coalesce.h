@@ -0,0 +1,46 @@
+/*
+ * Touch frame coalescing in front of esp_hidd_send_touch_frame().
+ *
+ * A move frame is skipped when it repeats the last frame sent, or when the player is
+ * behind and the next frame is already due. Frames where a contact goes down or up
+ * are always sent.
+ */
+
+#ifndef HID_COALESCE_H
+#define HID_COALESCE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "esp_err.h"
+
+#include "esp_hidd_prf_api.h"
+
+/// Last frame sent by one player
+typedef struct {
+    esp_hidd_touch_contact_t last[HID_TOUCH_MAX_CONTACTS];
+    uint8_t last_count;
+} hid_coalesce_t;
+
+/// Totals over all players since boot
+typedef struct {
+    uint32_t sent;             /*!< Frames handed to the sender */
+    uint32_t superseded;       /*!< Moves skipped because a later frame was already due */
+    uint32_t duplicates;       /*!< Moves identical to the last frame sent */
+} hid_coalesce_stats_t;
+
+void hid_coalesce_begin(hid_coalesce_t *co);
+
+/**
+ * @brief Send a frame unless it can be coalesced. A frame with a down or up transition
+ *        is retried once if the link drops it, since losing it would leave a finger down.
+ *
+ * @param superseded The caller's next frame is already due
+ *
+ * @return ESP_OK when the frame was sent or skipped, otherwise the send error
+ */
+esp_err_t hid_coalesce_send(hid_coalesce_t *co, uint16_t conn_id, const esp_hidd_touch_contact_t *frame,
+                            uint8_t count, bool superseded);
+
+void hid_coalesce_get_stats(hid_coalesce_stats_t *out);
+
+#endif /* HID_COALESCE_H */
@@ -11,42 +11,239 @@
 #include <stdio.h>
 #include "esp_log.h"
 
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "freertos/task.h"
+
 static hid_report_map_t *hid_dev_rpt_tbl;
 static uint8_t hid_dev_rpt_tbl_Len;
+static hid_report_stats_t hid_dev_rpt_stats[HID_NUM_REPORTS];
+// Senders run on the executor, httpd and UDP tasks, which can sit on different cores
+static portMUX_TYPE hid_dev_stats_lock = portMUX_INITIALIZER_UNLOCKED;
+
+// Table index + 1 of each (protocol mode, type - 1, id), 0 when not registered
+static uint8_t hid_dev_rpt_idx[2][3][HID_DEV_MAX_RPT_ID + 1];
+
+// Bit per conn_id, set between the congested and uncongested GATTS events
+static volatile uint32_t hid_dev_congested_mask;
+static SemaphoreHandle_t hid_dev_link_sem;
+
+static void hid_dev_count(uint32_t *counter)
+{
+    taskENTER_CRITICAL(&hid_dev_stats_lock);
+    (*counter)++;
+    taskEXIT_CRITICAL(&hid_dev_stats_lock);
+}
 
 static hid_report_map_t *hid_dev_rpt_by_id(uint8_t id, uint8_t type)
 {
-    hid_report_map_t *rpt = hid_dev_rpt_tbl;
+    const uint8_t t = type - 1;
 
-    for (uint8_t i = hid_dev_rpt_tbl_Len; i > 0; i--, rpt++) {
-        if (rpt->id == id && rpt->type == type && rpt->mode == hidProtocolMode) {
-            return rpt;
-        }
+    if (id > HID_DEV_MAX_RPT_ID || t > 2 || hidProtocolMode > HID_PROTOCOL_MODE_REPORT) {
+        return NULL;
     }
 
-    return NULL;
+    const uint8_t idx = hid_dev_rpt_idx[hidProtocolMode][t][id];
+    return idx ? &hid_dev_rpt_tbl[idx - 1] : NULL;
 }
 
-void hid_dev_register_reports(uint8_t num_reports, hid_report_map_t *p_report)
+esp_err_t hid_dev_register_reports(uint8_t num_reports, hid_report_map_t *p_report)
 {
+    esp_err_t ret = ESP_OK;
+
     hid_dev_rpt_tbl = p_report;
-    hid_dev_rpt_tbl_Len = num_reports;
-    return;
+    hid_dev_rpt_tbl_Len = num_reports > HID_NUM_REPORTS ? HID_NUM_REPORTS : num_reports;
+    memset(hid_dev_rpt_stats, 0, sizeof(hid_dev_rpt_stats));
+    memset(hid_dev_rpt_idx, 0, sizeof(hid_dev_rpt_idx));
+
+    for (uint8_t i = 0; i < hid_dev_rpt_tbl_Len; i++) {
+        const hid_report_map_t *rpt = &p_report[i];
+        const uint8_t t = rpt->type - 1;
+
+        if (rpt->id > HID_DEV_MAX_RPT_ID || t > 2 || rpt->mode > HID_PROTOCOL_MODE_REPORT ||
+            rpt->handle == 0 || rpt->len == 0) {
+            ESP_LOGE(HID_LE_PRF_TAG, "%s(), report %d (id %d, type %d, mode %d, handle %d, len %d) is invalid",
+                     __func__, i, rpt->id, rpt->type, rpt->mode, rpt->handle, rpt->len);
+            ret = ESP_ERR_INVALID_ARG;
+            continue;
+        }
+        if (hid_dev_rpt_idx[rpt->mode][t][rpt->id] != 0) {
+            ESP_LOGE(HID_LE_PRF_TAG, "%s(), report %d duplicates id %d, type %d, mode %d",
+                     __func__, i, rpt->id, rpt->type, rpt->mode);
+            ret = ESP_ERR_INVALID_ARG;
+            continue;
+        }
+        hid_dev_rpt_idx[rpt->mode][t][rpt->id] = i + 1;
+    }
+
+    if (hid_dev_link_sem == NULL) {
+        hid_dev_link_sem = xSemaphoreCreateBinary();
+    }
+    return ret;
 }
 
-void hid_dev_send_report(esp_gatt_if_t gatts_if, uint16_t conn_id,
+esp_err_t hid_dev_check_report_map(const uint8_t *map, uint16_t len)
+{
+    // Bits per (type - 1, report ID), summed over the main items
+    uint16_t bits[3][HID_DEV_MAX_RPT_ID + 1] = {0};
+    uint32_t report_size = 0;
+    uint32_t report_count = 0;
+    uint8_t report_id = 0;
+    esp_err_t ret = ESP_OK;
+
+    for (uint16_t pos = 0; pos < len;) {
+        const uint8_t prefix = map[pos++];
+        if (prefix == 0xFE) {
+            // Long item: data size, tag, data
+            if (pos >= len) {
+                break;
+            }
+            pos += 2 + map[pos];
+            continue;
+        }
+
+        const uint8_t size = (prefix & 0x03) == 3 ? 4 : (prefix & 0x03);
+        if (pos + size > len) {
+            ESP_LOGE(HID_LE_PRF_TAG, "%s(), item at %d runs past the end", __func__, pos - 1);
+            return ESP_ERR_INVALID_ARG;
+        }
+        uint32_t value = 0;
+        for (uint8_t i = 0; i < size; i++) {
+            value |= (uint32_t)map[pos + i] << (8 * i);
+        }
+        pos += size;
+
+        uint8_t type = 0;
+        switch (prefix & 0xFC) {
+            case 0x74: // Report Size
+                report_size = value;
+                break;
+            case 0x94: // Report Count
+                report_count = value;
+                break;
+            case 0x84: // Report ID
+                report_id = (uint8_t)value;
+                if (value == 0 || value > HID_DEV_MAX_RPT_ID) {
+                    ESP_LOGE(HID_LE_PRF_TAG, "%s(), report ID %lu out of range", __func__, (unsigned long)value);
+                    return ESP_ERR_INVALID_ARG;
+                }
+                break;
+            case 0x80:
+                type = HID_REPORT_TYPE_INPUT;
+                break;
+            case 0x90:
+                type = HID_REPORT_TYPE_OUTPUT;
+                break;
+            case 0xB0:
+                type = HID_REPORT_TYPE_FEATURE;
+                break;
+            default:
+                break;
+        }
+        if (type != 0) {
+            bits[type - 1][report_id] += (uint16_t)(report_size * report_count);
+        }
+    }
+
+    for (uint8_t t = 0; t < 3; t++) {
+        for (uint8_t id = 0; id <= HID_DEV_MAX_RPT_ID; id++) {
+            if (bits[t][id] == 0) {
+                continue;
+            }
+            const uint16_t bytes = (bits[t][id] + 7) / 8;
+            const uint8_t expected = hid_report_schema_len(id, t + 1);
+            if (bytes != expected) {
+                ESP_LOGE(HID_LE_PRF_TAG, "%s(), report %d type %d is %d bytes in the descriptor, %d in the schema",
+                         __func__, id, t + 1, bytes, expected);
+                ret = ESP_ERR_INVALID_ARG;
+            }
+        }
+    }
+    return ret;
+}
+
+void hid_dev_set_congested(uint16_t conn_id, bool congested)
+{
+    const uint32_t bit = 1u << (conn_id & 31);
+    if (congested) {
+        hid_dev_congested_mask |= bit;
+    } else {
+        hid_dev_congested_mask &= ~bit;
+        if (hid_dev_link_sem != NULL) {
+            xSemaphoreGive(hid_dev_link_sem);
+        }
+    }
+}
+
+static bool hid_dev_link_ready(uint16_t conn_id)
+{
+    return !(hid_dev_congested_mask & (1u << (conn_id & 31))) &&
+           esp_ble_get_cur_sendable_packets_num(conn_id) > 0;
+}
+
+// Sleeps a tick at a time, or until the congestion clears, while the link has no room
+static bool hid_dev_wait_link(uint16_t conn_id)
+{
+    const TickType_t start = xTaskGetTickCount();
+    const TickType_t budget = pdMS_TO_TICKS(HID_DEV_SEND_WAIT_MS);
+
+    while (!hid_dev_link_ready(conn_id)) {
+        if (xTaskGetTickCount() - start >= budget) {
+            return false;
+        }
+        if (hid_dev_link_sem != NULL) {
+            xSemaphoreTake(hid_dev_link_sem, 1);
+        } else {
+            vTaskDelay(1);
+        }
+    }
+    return true;
+}
+
+esp_err_t hid_dev_send_report(esp_gatt_if_t gatts_if, uint16_t conn_id,
                                     uint8_t id, uint8_t type, uint8_t length, uint8_t *data)
 {
     hid_report_map_t *p_rpt;
 
     // get att handle for report
-    if ((p_rpt = hid_dev_rpt_by_id(id, type)) != NULL) {
-        // if notifications are enabled
-        ESP_LOGD(HID_LE_PRF_TAG, "%s(), send the report, handle = %d", __func__, p_rpt->handle);
-        esp_ble_gatts_send_indicate(gatts_if, conn_id, p_rpt->handle, length, data, false);
+    if ((p_rpt = hid_dev_rpt_by_id(id, type)) == NULL) {
+        return ESP_ERR_NOT_FOUND;
+    }
+    if (length != p_rpt->len) {
+        ESP_LOGW(HID_LE_PRF_TAG, "%s(), report %d is %d bytes, not %d", __func__, id, length, p_rpt->len);
+        return ESP_ERR_INVALID_SIZE;
     }
+    hid_report_stats_t *stats = &hid_dev_rpt_stats[p_rpt - hid_dev_rpt_tbl];
 
-    return;
+    if (!hid_dev_link_ready(conn_id)) {
+        hid_dev_count(&stats->deferred);
+        if (!hid_dev_wait_link(conn_id)) {
+            hid_dev_count(&stats->dropped);
+            ESP_LOGW(HID_LE_PRF_TAG, "%s(), link busy, report %d dropped", __func__, id);
+            return ESP_ERR_TIMEOUT;
+        }
+    }
+
+    ESP_LOGD(HID_LE_PRF_TAG, "%s(), send the report, handle = %d", __func__, p_rpt->handle);
+    if (esp_ble_gatts_send_indicate(gatts_if, conn_id, p_rpt->handle, length, data, false) != ESP_OK) {
+        hid_dev_count(&stats->dropped);
+        return ESP_FAIL;
+    }
+    hid_dev_count(&stats->sent);
+    return ESP_OK;
+}
+
+esp_err_t hid_dev_get_report_stats(uint8_t id, uint8_t type, hid_report_stats_t *out)
+{
+    hid_report_map_t *p_rpt = hid_dev_rpt_by_id(id, type);
+    if (p_rpt == NULL || out == NULL) {
+        return ESP_ERR_NOT_FOUND;
+    }
+
+    taskENTER_CRITICAL(&hid_dev_stats_lock);
+    *out = hid_dev_rpt_stats[p_rpt - hid_dev_rpt_tbl];
+    taskEXIT_CRITICAL(&hid_dev_stats_lock);
+    return ESP_OK;
 }
 
 void hid_consumer_build_report(uint8_t *buffer, consumer_cmd_t cmd)
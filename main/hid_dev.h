@@ -226,8 +226,20 @@ typedef struct
   uint8_t     id;               // Report ID
   uint8_t     type;             // Report type
   uint8_t     mode;             // Protocol mode (report or boot)
+  uint8_t     len;              // Report length in bytes, without the report ID
 } hid_report_map_t;
 
+// Per-report send counters
+typedef struct
+{
+  uint32_t    sent;             // Handed to the stack
+  uint32_t    deferred;         // Had to wait for a free controller buffer first
+  uint32_t    dropped;          // No buffer within HID_DEV_SEND_WAIT_MS, or refused by the stack
+} hid_report_stats_t;
+
+#define HID_DEV_SEND_WAIT_MS  40  // Longest a report waits for the link before it is dropped
+#define HID_DEV_MAX_RPT_ID    15  // Highest report ID the direct lookup table holds
+
 // HID dev configuration structure
 typedef struct
 {
@@ -236,11 +248,33 @@ typedef struct
 
 } hid_dev_cfg_t;
 
-void hid_dev_register_reports(uint8_t num_reports, hid_report_map_t *p_report);
+/*
+ * Builds the lookup table from (protocol mode, type, id) to report. Entries with an ID above
+ * HID_DEV_MAX_RPT_ID, an unknown type or mode, no handle or length, or a key already taken
+ * are left out and make the call return ESP_ERR_INVALID_ARG; the others are still registered.
+ */
+esp_err_t hid_dev_register_reports(uint8_t num_reports, hid_report_map_t *p_report);
 
-void hid_dev_send_report(esp_gatt_if_t gatts_if, uint16_t conn_id,
+/*
+ * Walks a report map descriptor and checks that every report it declares is in the report
+ * schema with the same length. Returns ESP_ERR_INVALID_ARG, after logging each mismatch, if not.
+ */
+esp_err_t hid_dev_check_report_map(const uint8_t *map, uint16_t len);
+
+/*
+ * Blocks while the connection is congested or the controller has no free buffer, for at
+ * most HID_DEV_SEND_WAIT_MS. Returns ESP_ERR_TIMEOUT if the report was dropped for that,
+ * ESP_ERR_NOT_FOUND for an unknown report, ESP_ERR_INVALID_SIZE when length does not match the
+ * registered one and ESP_FAIL if the stack refused it.
+ */
+esp_err_t hid_dev_send_report(esp_gatt_if_t gatts_if, uint16_t conn_id,
                                     uint8_t id, uint8_t type, uint8_t length, uint8_t *data);
 
+// Called from the GATTS congestion event
+void hid_dev_set_congested(uint16_t conn_id, bool congested);
+
+esp_err_t hid_dev_get_report_stats(uint8_t id, uint8_t type, hid_report_stats_t *out);
+
 void hid_consumer_build_report(uint8_t *buffer, consumer_cmd_t cmd);
 
 void hid_keyboard_build_report(uint8_t *buffer, keyboard_cmd_t cmd);
@@ -26,13 +26,48 @@ struct prf_char_pres_fmt
 // HID report mapping table
 static hid_report_map_t hid_rpt_map[HID_NUM_REPORTS];
 
+/*
+ * One finger of the touch report (6 bytes): tip/in-range bits, contact id, X, Y.
+ * The report carries HID_TOUCH_CONTACTS_PER_REPORT of these, so the collection is
+ * listed that many times below; frames with more contacts use hybrid mode.
+ */
+#define HID_TOUCH_FINGER_COLLECTION \
+    0x05, 0x0D,        /*   Usage Page (Digitizers) */ \
+    0x09, 0x22,        /*   Usage (Finger) */ \
+    0xA1, 0x02,        /*   Collection (Logical) */ \
+    0x09, 0x42,        /*     Usage (Tip Switch) */ \
+    0x09, 0x32,        /*     Usage (In Range) */ \
+    0x15, 0x00,        /*     Logical Minimum (0) */ \
+    0x25, 0x01,        /*     Logical Maximum (1) */ \
+    0x75, 0x01,        /*     Report Size (1) */ \
+    0x95, 0x02,        /*     Report Count (2) */ \
+    0x81, 0x02,        /*     Input (Data, Variable, Absolute) */ \
+    0x95, 0x06,        /*     Report Count (6) */ \
+    0x81, 0x01,        /*     Input (Constant) */ \
+    0x09, 0x51,        /*     Usage (Contact Identifier) */ \
+    0x75, 0x08,        /*     Report Size (8) */ \
+    0x95, 0x01,        /*     Report Count (1) */ \
+    0x25, HID_TOUCH_MAX_CONTACTS - 1, /* Logical Maximum */ \
+    0x81, 0x02,        /*     Input (Data, Variable, Absolute) */ \
+    0x05, 0x01,        /*     Usage Page (Generic Desktop) */ \
+    0x09, 0x30,        /*     Usage (X) */ \
+    0x09, 0x31,        /*     Usage (Y) */ \
+    0x16, 0x00, 0x00,  /*     Logical Minimum (0) */ \
+    0x26, 0xFF, 0x7F,  /*     Logical Maximum (32767) */ \
+    0x36, 0x00, 0x00,  /*     Physical Minimum (0) */ \
+    0x46, 0xFF, 0x7F,  /*     Physical Maximum (32767) */ \
+    0x75, 0x10,        /*     Report Size (16) */ \
+    0x95, 0x02,        /*     Report Count (2) */ \
+    0x81, 0x02,        /*     Input (Data, Variable, Absolute) */ \
+    0xC0               /*   End Collection */
+
 // HID Report Map characteristic value
 // Keyboard report descriptor (using format for Boot interface descriptor)
 static const uint8_t hidReportMap[] = {
     0x05, 0x01,  // Usage Page (Generic Desktop)
     0x09, 0x02,  // Usage (Mouse)
     0xA1, 0x01,  // Collection (Application)
-    0x85, 0x01,  // Report Id (1)
+    0x85, HID_COLLECTION_ID_MOUSE,     // Report Id (1)
     0x09, 0x01,  //   Usage (Pointer)
     0xA1, 0x00,  //   Collection (Physical)
     0x05, 0x09,  //     Usage Page (Buttons)
@@ -61,50 +96,25 @@ static const uint8_t hidReportMap[] = {
     0x05, 0x0D,  // Usage Page (Digitizers)
     0x09, 0x04,  // Usage (Touch Screen)
     0xA1, 0x01,  // Collection (Application)
-    0x85, 0x04,  // Report Id (4)
-    0x09, 0x22,  //   Usage (Finger)
-    0xA1, 0x02,  //   Collection (Logical)
-    0x09, 0x42,  //     Usage (Tip Switch)
-    0x09, 0x32,  //     Usage (In Range)
-    0x15, 0x00,  //     Logical Minimum (0)
-    0x25, 0x01,  //     Logical Maximum (1)
-    0x75, 0x01,  //     Report Size (1)
-    0x95, 0x02,  //     Report Count (2)
-    0x81, 0x02,  //     Input (Data, Variable, Absolute) - 触摸状态
-    0x95, 0x06,  //     Report Count (6)
-    0x81, 0x01,  //     Input (Constant) - 填充
-    0x09, 0x51,  //     Usage (Contact Identifier)
-    0x75, 0x08,  //     Report Size (8)
-    0x95, 0x01,  //     Report Count (1)
-    0x15, 0x00,  //     Logical Minimum (0)
-    0x25, 0x01,  //     Logical Maximum (1)
-    0x81, 0x02,  //     Input (Data, Variable, Absolute) - 触点编号
-    0x05, 0x01,  //     Usage Page (Generic Desktop)
-    0x09, 0x30,  //     Usage (X)
-    0x09, 0x31,  //     Usage (Y)
-    0x16, 0x00, 0x00,  //     Logical Minimum (0)
-    0x26, 0xFF, 0x7F,  //     Logical Maximum (32767)
-    0x36, 0x00, 0x00,  //     Physical Minimum (0)
-    0x46, 0xFF, 0x7F,  //     Physical Maximum (32767)
-    0x75, 0x10,  //     Report Size (16)
-    0x95, 0x02,  //     Report Count (2)
-    0x81, 0x02,  //     Input (Data, Variable, Absolute) - 触摸坐标
-    0xC0,        //   End Collection
+    0x85, HID_COLLECTION_ID_TOUCH,     // Report Id (4)
+    HID_TOUCH_FINGER_COLLECTION,
+    HID_TOUCH_FINGER_COLLECTION,
+    HID_TOUCH_FINGER_COLLECTION,
+    0x05, 0x0D,  //   Usage Page (Digitizers)
     0x09, 0x54,  //   Usage (Contact count)
     0x95, 0x01,  //   Report Count (1)
     0x75, 0x08,  //   Report Size (8)
     0x15, 0x00,  //   Logical Minimum (0)
-    0x25, 0x01,  //   Logical Maximum (1)
-    0x81, 0x02,  //   Input (Data, Variable, Absolute) - 触点数量
+    0x25, HID_TOUCH_MAX_CONTACTS,  //   Logical Maximum - 整帧触点数量，只在首个报告中填写
+    0x81, 0x02,  //   Input (Data, Variable, Absolute)
     0x09, 0x55,  //   Usage (Contact count maximum)
-    0x25, 0x01,  //   Logical Maximum (1)
     0xB1, 0x02,  //   Feature (Data, Variable, Absolute)
     0xC0,        // End Collection
 
     0x05, 0x01,  // Usage Pg (Generic Desktop)
     0x09, 0x06,  // Usage (Keyboard)
     0xA1, 0x01,  // Collection: (Application)
-    0x85, 0x02,  // Report Id (2)
+    0x85, HID_COLLECTION_ID_KEYBOARD,  // Report Id (2)
     //
     0x05, 0x07,  //   Usage Pg (Key Codes)
     0x19, 0xE0,  //   Usage Min (224)
@@ -136,7 +146,7 @@ static const uint8_t hidReportMap[] = {
     0x91, 0x01,  //   Output: (Constant)
     //
     //   Key arrays (6 bytes)
-    0x95, 0x06,  //   Report Count (6)
+    0x95, HID_KEYBOARD_KEY_SLOTS,  //   Report Count (6)
     0x75, 0x08,  //   Report Size (8)
     0x15, 0x00,  //   Log Min (0)
     0x25, 0x65,  //   Log Max (101)
@@ -150,7 +160,7 @@ static const uint8_t hidReportMap[] = {
     0x05, 0x0C,   // Usage Pg (Consumer Devices)
     0x09, 0x01,   // Usage (Consumer Control)
     0xA1, 0x01,   // Collection (Application)
-    0x85, 0x03,   // Report Id (3)
+    0x85, HID_COLLECTION_ID_CONSUMER,  // Report Id (3)
     0x09, 0x02,   //   Usage (Numeric Key Pad)
     0xA1, 0x02,   //   Collection (Logical)
     0x05, 0x09,   //     Usage Pg (Button)
@@ -211,11 +221,11 @@ static const uint8_t hidReportMap[] = {
     0x06, 0xFF, 0xFF, // Usage Page(Vendor defined)
     0x09, 0xA5,       // Usage(Vendor Defined)
     0xA1, 0x01,       // Collection(Application)
-    0x85, 0x04,   // Report Id (4)
+    0x85, HID_COLLECTION_ID_VENDOR,    // Report Id (5)
     0x09, 0xA6,   // Usage(Vendor defined)
     0x09, 0xA9,   // Usage(Vendor defined)
     0x75, 0x08,   // Report Size
-    0x95, 0x7F,   // Report Count = 127 Btyes
+    0x95, HID_VENDOR_OUT_LEN,          // Report Count = 127 Btyes
     0x91, 0x02,   // Output(Data, Variable, Absolute)
     0xC0,         // End Collection
 #endif
@@ -250,7 +260,7 @@ struct gatts_profile_inst {
 hidd_le_env_t hidd_le_env;
 
 // HID report map length
-uint8_t hidReportMapLen = sizeof(hidReportMap);
+uint16_t hidReportMapLen = sizeof(hidReportMap);
 uint8_t hidProtocolMode = HID_PROTOCOL_MODE_REPORT;
 
 // HID report mapping table
@@ -294,6 +304,9 @@ static uint8_t hidReportRefVendorOut[HID_REPORT_REF_LEN] =
 static uint8_t hidReportRefFeature[HID_REPORT_REF_LEN] =
              { HID_RPT_ID_FEATURE, HID_REPORT_TYPE_FEATURE };
 
+// Touch feature report value: Contact Count Maximum
+static uint8_t hidTouchContactMax[] = { HID_TOUCH_MAX_CONTACTS };
+
 // HID Report Reference characteristic descriptor, consumer control input
 static uint8_t hidReportRefCCIn[HID_REPORT_REF_LEN] =
              { HID_RPT_ID_CC_IN, HID_REPORT_TYPE_INPUT };
@@ -549,7 +562,7 @@ static esp_gatts_attr_db_t hidd_le_gatt_db[HIDD_LE_IDX_NB] =
     // Boot Keyboard Input Report Characteristic Value
     [HIDD_LE_IDX_BOOT_KB_IN_REPORT_VAL]   = {{ESP_GATT_AUTO_RSP}, {ESP_UUID_LEN_16, (uint8_t *)&hid_kb_input_uuid,
                                                                         ESP_GATT_PERM_READ,
-                                                                        HIDD_LE_BOOT_REPORT_MAX_LEN, 0,
+                                                                        HID_RPT_LEN_BOOT_KB_IN, 0,
                                                                         NULL}},
     // Boot Keyboard Input Report Characteristic - Client Characteristic Configuration Descriptor
     [HIDD_LE_IDX_BOOT_KB_IN_REPORT_NTF_CFG]  = {{ESP_GATT_AUTO_RSP}, {ESP_UUID_LEN_16, (uint8_t *)&character_client_config_uuid,
@@ -565,7 +578,7 @@ static esp_gatts_attr_db_t hidd_le_gatt_db[HIDD_LE_IDX_NB] =
     // Boot Keyboard Output Report Characteristic Value
     [HIDD_LE_IDX_BOOT_KB_OUT_REPORT_VAL]      = {{ESP_GATT_AUTO_RSP}, {ESP_UUID_LEN_16, (uint8_t *)&hid_kb_output_uuid,
                                                                               (ESP_GATT_PERM_READ|ESP_GATT_PERM_WRITE),
-                                                                              HIDD_LE_BOOT_REPORT_MAX_LEN, 0,
+                                                                              HID_RPT_LEN_BOOT_KB_OUT, 0,
                                                                               NULL}},
 
     // Boot Mouse Input Report Characteristic Declaration
@@ -576,7 +589,7 @@ static esp_gatts_attr_db_t hidd_le_gatt_db[HIDD_LE_IDX_NB] =
     // Boot Mouse Input Report Characteristic Value
     [HIDD_LE_IDX_BOOT_MOUSE_IN_REPORT_VAL]   = {{ESP_GATT_AUTO_RSP}, {ESP_UUID_LEN_16, (uint8_t *)&hid_mouse_input_uuid,
                                                                               ESP_GATT_PERM_READ,
-                                                                              HIDD_LE_BOOT_REPORT_MAX_LEN, 0,
+                                                                              HID_RPT_LEN_BOOT_MOUSE_IN, 0,
                                                                               NULL}},
     // Boot Mouse Input Report Characteristic - Client Characteristic Configuration Descriptor
     [HIDD_LE_IDX_BOOT_MOUSE_IN_REPORT_NTF_CFG]    = {{ESP_GATT_AUTO_RSP}, {ESP_UUID_LEN_16, (uint8_t *)&character_client_config_uuid,
@@ -592,8 +605,8 @@ static esp_gatts_attr_db_t hidd_le_gatt_db[HIDD_LE_IDX_NB] =
     // Report Characteristic Value
     [HIDD_LE_IDX_REPORT_VAL]                      = {{ESP_GATT_AUTO_RSP}, {ESP_UUID_LEN_16, (uint8_t *)&hid_report_uuid,
                                                                        ESP_GATT_PERM_READ,
-                                                                       HIDD_LE_REPORT_MAX_LEN, 0,
-                                                                       NULL}},
+                                                                       HIDD_LE_REPORT_MAX_LEN, sizeof(hidTouchContactMax),
+                                                                       hidTouchContactMax}},
     // Report Characteristic - Report Reference Descriptor
     [HIDD_LE_IDX_REPORT_REP_REF]               = {{ESP_GATT_AUTO_RSP}, {ESP_UUID_LEN_16, (uint8_t *)&hid_report_ref_descr_uuid,
                                                                        ESP_GATT_PERM_READ,
@@ -602,6 +615,7 @@ static esp_gatts_attr_db_t hidd_le_gatt_db[HIDD_LE_IDX_NB] =
 };
 
 static void hid_add_id_tbl(void);
+static void hidd_clcb_update_cccd(uint16_t conn_id, uint16_t handle, uint16_t len, const uint8_t *value);
 
 void esp_hidd_prf_cb_hdl(esp_gatts_cb_event_t event, esp_gatt_if_t gatts_if,
 									esp_ble_gatts_cb_param_t *param)
@@ -647,16 +661,24 @@ void esp_hidd_prf_cb_hdl(esp_gatts_cb_event_t event, esp_gatt_if_t gatts_if,
             break;
         }
         case ESP_GATTS_DISCONNECT_EVT: {
+            esp_hidd_cb_param_t cb_param = {0};
+            cb_param.disconnect.conn_id = param->disconnect.conn_id;
+            memcpy(cb_param.disconnect.remote_bda, param->disconnect.remote_bda, sizeof(esp_bd_addr_t));
 			 if(hidd_le_env.hidd_cb != NULL) {
-                    (hidd_le_env.hidd_cb)(ESP_HIDD_EVENT_BLE_DISCONNECT, NULL);
+                    (hidd_le_env.hidd_cb)(ESP_HIDD_EVENT_BLE_DISCONNECT, &cb_param);
              }
+            hid_dev_set_congested(param->disconnect.conn_id, false);
             hidd_clcb_dealloc(param->disconnect.conn_id);
             break;
         }
+        case ESP_GATTS_CONGEST_EVT:
+            hid_dev_set_congested(param->congest.conn_id, param->congest.congested);
+            break;
         case ESP_GATTS_CLOSE_EVT:
             break;
         case ESP_GATTS_WRITE_EVT: {
             esp_hidd_cb_param_t cb_param = {0};
+            hidd_clcb_update_cccd(param->write.conn_id, param->write.handle, param->write.len, param->write.value);
             if (param->write.handle == hidd_le_env.hidd_inst.att_tbl[HIDD_LE_IDX_REPORT_LED_OUT_VAL]) {
                 cb_param.led_write.conn_id = param->write.conn_id;
                 cb_param.led_write.report_id = HID_RPT_ID_LED_OUT;
@@ -721,32 +743,70 @@ void hidd_le_init(void)
 
 void hidd_clcb_alloc (uint16_t conn_id, esp_bd_addr_t bda)
 {
+    static uint32_t       seq;
     uint8_t                   i_clcb = 0;
     hidd_clcb_t      *p_clcb = NULL;
 
     for (i_clcb = 0, p_clcb= hidd_le_env.hidd_clcb; i_clcb < HID_MAX_APPS; i_clcb++, p_clcb++) {
         if (!p_clcb->in_use) {
-            p_clcb->in_use      = true;
+            memset(p_clcb, 0, sizeof(hidd_clcb_t));
             p_clcb->conn_id     = conn_id;
             p_clcb->connected   = true;
+            p_clcb->seq         = ++seq;
             memcpy (p_clcb->remote_bda, bda, ESP_BD_ADDR_LEN);
-            break;
+            p_clcb->in_use      = true;
+            return;
         }
     }
+    ESP_LOGW(HID_LE_PRF_TAG, "%s(), no free link for conn_id %d", __func__, conn_id);
     return;
 }
 
 bool hidd_clcb_dealloc (uint16_t conn_id)
+{
+    hidd_clcb_t      *p_clcb = hidd_clcb_find(conn_id);
+
+    if (p_clcb != NULL) {
+        p_clcb->in_use = false;
+        memset(p_clcb, 0, sizeof(hidd_clcb_t));
+        return true;
+    }
+
+    return false;
+}
+
+hidd_clcb_t *hidd_clcb_find (uint16_t conn_id)
 {
     uint8_t              i_clcb = 0;
     hidd_clcb_t      *p_clcb = NULL;
 
     for (i_clcb = 0, p_clcb= hidd_le_env.hidd_clcb; i_clcb < HID_MAX_APPS; i_clcb++, p_clcb++) {
-            memset(p_clcb, 0, sizeof(hidd_clcb_t));
-            return true;
+        if (p_clcb->in_use && p_clcb->conn_id == conn_id) {
+            return p_clcb;
+        }
     }
 
-    return false;
+    return NULL;
+}
+
+// CCCD writes arrive per connection, while the attribute table keeps one shared value
+static void hidd_clcb_update_cccd(uint16_t conn_id, uint16_t handle, uint16_t len, const uint8_t *value)
+{
+    hidd_clcb_t *p_clcb = hidd_clcb_find(conn_id);
+    if (p_clcb == NULL || len < 1) {
+        return;
+    }
+
+    for (int i = 0; i < HID_NUM_REPORTS; i++) {
+        if (hid_rpt_map[i].cccdHandle != 0 && hid_rpt_map[i].cccdHandle == handle) {
+            if (value[0] & 0x01) {
+                p_clcb->notify_mask |= (uint16_t)(1u << (hid_rpt_map[i].id & 0x0F));
+            } else {
+                p_clcb->notify_mask &= (uint16_t)~(1u << (hid_rpt_map[i].id & 0x0F));
+            }
+            return;
+        }
+    }
 }
 
 static struct gatts_profile_inst heart_rate_profile_tab[PROFILE_NUM] = {
@@ -887,6 +947,19 @@ static void hid_add_id_tbl(void)
       hid_rpt_map[8].mode = HID_PROTOCOL_MODE_REPORT;
 
 
+  // Boot reports share the ID and type of their report-mode twins, but not always the length
+  for (int i = 0; i < HID_NUM_REPORTS; i++) {
+      hid_rpt_map[i].len = (hid_rpt_map[i].mode == HID_PROTOCOL_MODE_BOOT)
+                           ? hid_boot_report_schema_len(hid_rpt_map[i].id, hid_rpt_map[i].type)
+                           : hid_report_schema_len(hid_rpt_map[i].id, hid_rpt_map[i].type);
+  }
+
+  if (hid_dev_check_report_map(hidReportMap, sizeof(hidReportMap)) != ESP_OK) {
+      ESP_LOGE(HID_LE_PRF_TAG, "%s(), report map descriptor does not match the report schema", __func__);
+  }
+
   // Setup report ID map
-  hid_dev_register_reports(HID_NUM_REPORTS, hid_rpt_map);
+  if (hid_dev_register_reports(HID_NUM_REPORTS, hid_rpt_map) != ESP_OK) {
+      ESP_LOGE(HID_LE_PRF_TAG, "%s(), report map has invalid entries", __func__);
+  }
 }
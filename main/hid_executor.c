@@ -0,0 +1,431 @@
+/*
+ * HID action executor implementation.
+ *
+ * HTTP handlers validate a request, copy it into a job slot and return at once;
+ * the executor task drains the queue and runs the (blocking) gesture code.
+ */
+
+#include "hid_executor.h"
+
+#include <string.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
+#include "freertos/semphr.h"
+#include "freertos/task.h"
+
+#include "esp_log.h"
+#include "esp_timer.h"
+
+#include "hid_actions.h"
+#include "hid_link.h"
+
+#define HID_EXECUTOR_TASK_STACK 4096
+#define HID_EXECUTOR_TASK_PRIO 6 // Above the HTTP server (5) so playback is not preempted by parsing
+
+typedef struct
+{
+    hid_job_info_t info;
+    uint16_t conn_id;
+    hid_action_t action;
+} hid_job_t;
+
+typedef struct
+{
+    uint32_t job_id;                              /*!< Owning job, 0 = free */
+    uint32_t count;
+    hid_batch_step_t steps[HID_BATCH_MAX_STEPS];
+    hid_batch_step_result_t results[HID_BATCH_MAX_STEPS];
+} hid_batch_slot_t;
+
+static const char *TAG = "HID_EXEC";
+
+static hid_job_t s_jobs[HID_EXECUTOR_JOB_HISTORY];
+static QueueHandle_t s_job_queue;
+static SemaphoreHandle_t s_job_lock;
+static hid_batch_slot_t s_batches[HID_EXECUTOR_BATCH_SLOTS];
+static uint32_t s_next_job_id = 1;
+
+static hid_job_t *hid_job_slot(uint32_t job_id)
+{
+    return &s_jobs[job_id % HID_EXECUTOR_JOB_HISTORY];
+}
+
+static void hid_executor_run_batch(uint16_t conn_id, uint32_t slot, hid_pacer_stats_t *timing);
+
+static void hid_executor_run(uint16_t conn_id, const hid_action_t *action, hid_pacer_stats_t *timing)
+{
+    if (action->type == HID_ACTION_BATCH)
+    {
+        hid_executor_run_batch(conn_id, action->batch.slot, timing);
+        return;
+    }
+
+    hid_actions_take_last_timing(NULL);
+
+    switch (action->type)
+    {
+    case HID_ACTION_TAP:
+        hid_touch_tap(conn_id, action->touch.x, action->touch.y);
+        break;
+    case HID_ACTION_LONG_PRESS:
+        hid_touch_long_press(conn_id, action->touch.x, action->touch.y, action->touch.duration_ms);
+        break;
+    case HID_ACTION_SWIPE:
+        hid_touch_swipe(conn_id, action->swipe.start_x, action->swipe.start_y,
+                        action->swipe.end_x, action->swipe.end_y, action->swipe.duration_ms);
+        break;
+    case HID_ACTION_MULTI_TAP:
+        hid_touch_multi_tap(conn_id, action->multi.count, action->multi.xs, action->multi.ys);
+        break;
+    case HID_ACTION_MULTI_LONG_PRESS:
+        hid_touch_multi_long_press(conn_id, action->multi.count, action->multi.xs, action->multi.ys,
+                                   action->multi.duration_ms);
+        break;
+    case HID_ACTION_PINCH:
+        hid_touch_pinch(conn_id, action->pair.center_x, action->pair.center_y, action->pair.start_spread,
+                        action->pair.end_spread, action->pair.start_deg, action->pair.duration_ms);
+        break;
+    case HID_ACTION_ROTATE:
+        hid_touch_rotate(conn_id, action->pair.center_x, action->pair.center_y, action->pair.start_spread,
+                         action->pair.start_deg, action->pair.end_deg, action->pair.duration_ms);
+        break;
+    case HID_ACTION_PATH:
+        hid_touch_path(conn_id, &action->path.points, action->path.duration_ms);
+        break;
+    case HID_ACTION_FLING:
+        hid_touch_fling(conn_id, action->fling.start_x, action->fling.start_y, action->fling.angle_deg,
+                        action->fling.distance, action->fling.velocity, action->fling.fling);
+        break;
+    case HID_ACTION_REPLAY:
+        hid_touch_replay(conn_id, action->replay.slot);
+        break;
+    case HID_ACTION_TEXT:
+        hid_key_type_text(conn_id, action->text.slot);
+        break;
+    case HID_ACTION_TEXT_STREAM:
+        hid_key_type_stream(conn_id);
+        break;
+    case HID_ACTION_KEY:
+        if (action->key.press)
+        {
+            action->key.press(conn_id);
+        }
+        break;
+    default:
+        ESP_LOGW(TAG, "Unknown action type %d", action->type);
+        break;
+    }
+
+    hid_actions_take_last_timing(timing);
+}
+
+/*
+ * Steps run on one timeline: each start is paced against the previous step's actual end
+ * plus its delay, so the spacing does not depend on queueing or HTTP latency.
+ */
+static void hid_executor_run_batch(uint16_t conn_id, uint32_t slot, hid_pacer_stats_t *timing)
+{
+    hid_batch_slot_t *batch = &s_batches[slot % HID_EXECUTOR_BATCH_SLOTS];
+
+    // The slot is not reclaimed while its job is queued or running, so the steps are stable
+    const uint32_t count = batch->count;
+
+    hid_pacer_t pacer;
+    hid_pacer_begin(&pacer);
+
+    int64_t end_us = 0;
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        const hid_batch_step_t *step = &batch->steps[i];
+        hid_batch_step_result_t result = { .type = step->action.type };
+
+        result.planned_us = end_us + (int64_t)step->delay_ms * 1000;
+        hid_pacer_wait_until(&pacer, result.planned_us);
+        result.started_us = esp_timer_get_time() - pacer.start_us;
+
+        hid_executor_run(conn_id, &step->action, &result.timing);
+
+        result.finished_us = esp_timer_get_time() - pacer.start_us;
+        end_us = result.finished_us;
+
+        xSemaphoreTake(s_job_lock, portMAX_DELAY);
+        batch->results[i] = result;
+        xSemaphoreGive(s_job_lock);
+    }
+
+    hid_pacer_finish(&pacer, timing);
+}
+
+static void hid_executor_task(void *arg)
+{
+    uint32_t job_id;
+
+    for (;;)
+    {
+        if (xQueueReceive(s_job_queue, &job_id, portMAX_DELAY) != pdTRUE)
+        {
+            continue;
+        }
+
+        hid_job_t *job = hid_job_slot(job_id);
+        hid_action_t action;
+        uint16_t conn_id;
+
+        xSemaphoreTake(s_job_lock, portMAX_DELAY);
+        job->info.state = HID_JOB_RUNNING;
+        job->info.started_us = esp_timer_get_time();
+        action = job->action;
+        conn_id = job->conn_id;
+        xSemaphoreGive(s_job_lock);
+
+        hid_link_set_busy(conn_id, true);
+
+        hid_pacer_stats_t timing = { 0 };
+        hid_executor_run(conn_id, &action, &timing);
+
+        xSemaphoreTake(s_job_lock, portMAX_DELAY);
+        job->info.state = HID_JOB_DONE;
+        job->info.finished_us = esp_timer_get_time();
+        job->info.timing = timing;
+        xSemaphoreGive(s_job_lock);
+
+        // The idle profile is only requested HID_LINK_IDLE_MS later, so back-to-back jobs keep the active one
+        hid_link_set_busy(conn_id, false);
+
+        ESP_LOGD(TAG, "job %lu (%s) done", (unsigned long)job_id, hid_action_type_name(action.type));
+    }
+}
+
+esp_err_t hid_executor_start(void)
+{
+    if (s_job_queue)
+    {
+        return ESP_OK;
+    }
+
+    esp_err_t err = hid_pacer_init();
+    if (err != ESP_OK)
+    {
+        return err;
+    }
+
+    s_job_lock = xSemaphoreCreateMutex();
+    s_job_queue = xQueueCreate(HID_EXECUTOR_QUEUE_LEN, sizeof(uint32_t));
+    if (!s_job_lock || !s_job_queue)
+    {
+        ESP_LOGE(TAG, "Failed to create job queue");
+        return ESP_ERR_NO_MEM;
+    }
+
+    if (xTaskCreate(hid_executor_task, "hid_exec", HID_EXECUTOR_TASK_STACK, NULL,
+                    HID_EXECUTOR_TASK_PRIO, NULL) != pdPASS)
+    {
+        ESP_LOGE(TAG, "Failed to create executor task");
+        return ESP_FAIL;
+    }
+
+    return ESP_OK;
+}
+
+/*
+ * A batch slot can be taken over once its job is done (or its job slot was already reused),
+ * so finished batch results stay readable until the next batch needs the slot.
+ */
+static hid_batch_slot_t *hid_batch_claim_locked(uint32_t job_id)
+{
+    for (int i = 0; i < HID_EXECUTOR_BATCH_SLOTS; ++i)
+    {
+        hid_batch_slot_t *batch = &s_batches[i];
+        const hid_job_t *owner = hid_job_slot(batch->job_id);
+        if (batch->job_id == 0 || owner->info.id != batch->job_id || owner->info.state == HID_JOB_DONE)
+        {
+            batch->job_id = job_id;
+            return batch;
+        }
+    }
+    return NULL;
+}
+
+static esp_err_t hid_executor_enqueue(uint16_t conn_id, const hid_action_t *action,
+                                      const hid_batch_step_t *steps, uint32_t count, uint32_t *out_job_id)
+{
+    if (!s_job_queue)
+    {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    xSemaphoreTake(s_job_lock, portMAX_DELAY);
+
+    uint32_t job_id = s_next_job_id;
+    hid_job_t *job = hid_job_slot(job_id);
+    if (uxQueueSpacesAvailable(s_job_queue) == 0 || (job->info.id != 0 && job->info.state != HID_JOB_DONE))
+    {
+        xSemaphoreGive(s_job_lock);
+        return ESP_ERR_NO_MEM;
+    }
+
+    hid_action_t queued = *action;
+    if (queued.type == HID_ACTION_BATCH)
+    {
+        hid_batch_slot_t *batch = hid_batch_claim_locked(job_id);
+        if (!batch)
+        {
+            xSemaphoreGive(s_job_lock);
+            return ESP_ERR_NO_MEM;
+        }
+        batch->count = count;
+        memcpy(batch->steps, steps, count * sizeof(steps[0]));
+        memset(batch->results, 0, sizeof(batch->results));
+        queued.batch.slot = (uint32_t)(batch - s_batches);
+    }
+
+    memset(job, 0, sizeof(*job));
+    job->info.id = job_id;
+    job->info.state = HID_JOB_QUEUED;
+    job->info.type = queued.type;
+    job->info.queued_us = esp_timer_get_time();
+    job->conn_id = conn_id;
+    job->action = queued;
+
+    // Only the HTTP side enqueues and space was checked under the lock, so this cannot block
+    xQueueSend(s_job_queue, &job_id, 0);
+
+    s_next_job_id++;
+    if (s_next_job_id == 0)
+    {
+        s_next_job_id = 1;
+    }
+    xSemaphoreGive(s_job_lock);
+
+    if (out_job_id)
+    {
+        *out_job_id = job_id;
+    }
+    return ESP_OK;
+}
+
+esp_err_t hid_executor_submit(uint16_t conn_id, const hid_action_t *action, uint32_t *out_job_id)
+{
+    if (!action || action->type == HID_ACTION_BATCH)
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+    return hid_executor_enqueue(conn_id, action, NULL, 0, out_job_id);
+}
+
+esp_err_t hid_executor_submit_batch(uint16_t conn_id, const hid_batch_step_t *steps, uint32_t count,
+                                    uint32_t *out_job_id)
+{
+    if (!steps || count == 0 || count > HID_BATCH_MAX_STEPS)
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        if (steps[i].action.type == HID_ACTION_BATCH)
+        {
+            return ESP_ERR_INVALID_ARG;
+        }
+    }
+
+    const hid_action_t action = { .type = HID_ACTION_BATCH };
+    return hid_executor_enqueue(conn_id, &action, steps, count, out_job_id);
+}
+
+esp_err_t hid_executor_get_job(uint32_t job_id, hid_job_info_t *out)
+{
+    if (!s_job_lock || job_id == 0 || !out)
+    {
+        return ESP_ERR_NOT_FOUND;
+    }
+
+    esp_err_t err = ESP_ERR_NOT_FOUND;
+    xSemaphoreTake(s_job_lock, portMAX_DELAY);
+    const hid_job_t *job = hid_job_slot(job_id);
+    if (job->info.id == job_id)
+    {
+        *out = job->info;
+        err = ESP_OK;
+    }
+    xSemaphoreGive(s_job_lock);
+    return err;
+}
+
+esp_err_t hid_executor_get_batch_results(uint32_t job_id, hid_batch_step_result_t *out, uint32_t max,
+                                         uint32_t *out_count)
+{
+    if (!s_job_lock || job_id == 0 || !out || !out_count)
+    {
+        return ESP_ERR_NOT_FOUND;
+    }
+
+    esp_err_t err = ESP_ERR_NOT_FOUND;
+    xSemaphoreTake(s_job_lock, portMAX_DELAY);
+    for (int i = 0; i < HID_EXECUTOR_BATCH_SLOTS; ++i)
+    {
+        const hid_batch_slot_t *batch = &s_batches[i];
+        if (batch->job_id == job_id)
+        {
+            uint32_t count = batch->count < max ? batch->count : max;
+            memcpy(out, batch->results, count * sizeof(out[0]));
+            *out_count = count;
+            err = ESP_OK;
+            break;
+        }
+    }
+    xSemaphoreGive(s_job_lock);
+    return err;
+}
+
+const char *hid_job_state_name(hid_job_state_t state)
+{
+    switch (state)
+    {
+    case HID_JOB_QUEUED:
+        return "queued";
+    case HID_JOB_RUNNING:
+        return "running";
+    case HID_JOB_DONE:
+        return "done";
+    default:
+        return "unknown";
+    }
+}
+
+const char *hid_action_type_name(hid_action_type_t type)
+{
+    switch (type)
+    {
+    case HID_ACTION_TAP:
+        return "tap";
+    case HID_ACTION_LONG_PRESS:
+        return "long_press";
+    case HID_ACTION_SWIPE:
+        return "swipe";
+    case HID_ACTION_MULTI_TAP:
+        return "multi_tap";
+    case HID_ACTION_MULTI_LONG_PRESS:
+        return "multi_long_press";
+    case HID_ACTION_KEY:
+        return "key";
+    case HID_ACTION_PINCH:
+        return "pinch";
+    case HID_ACTION_ROTATE:
+        return "rotate";
+    case HID_ACTION_PATH:
+        return "path";
+    case HID_ACTION_FLING:
+        return "fling";
+    case HID_ACTION_REPLAY:
+        return "replay";
+    case HID_ACTION_TEXT:
+        return "text";
+    case HID_ACTION_TEXT_STREAM:
+        return "text_stream";
+    case HID_ACTION_BATCH:
+        return "batch";
+    default:
+        return "unknown";
+    }
+}
@@ -0,0 +1,174 @@
+/*
+ * HID action executor: runs queued touch and key actions on a dedicated task.
+ */
+
+#ifndef HID_EXECUTOR_H
+#define HID_EXECUTOR_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "esp_err.h"
+
+#include "hid_pacer.h"
+#include "hid_trajectory.h"
+
+#define HID_EXECUTOR_QUEUE_LEN 8     // Max jobs waiting behind the running one
+#define HID_EXECUTOR_JOB_HISTORY 16  // Finished jobs stay queryable until their slot is reused
+#define HID_ACTION_MAX_POINTS 10     // One per touch contact (HID_TOUCH_MAX_CONTACTS)
+#define HID_BATCH_MAX_STEPS 16
+#define HID_EXECUTOR_BATCH_SLOTS 2   // Batches queued or running at once; results live in the slot
+
+typedef enum {
+    HID_ACTION_TAP = 0,
+    HID_ACTION_LONG_PRESS,
+    HID_ACTION_SWIPE,
+    HID_ACTION_MULTI_TAP,
+    HID_ACTION_MULTI_LONG_PRESS,
+    HID_ACTION_KEY,
+    HID_ACTION_PINCH,
+    HID_ACTION_ROTATE,
+    HID_ACTION_PATH,
+    HID_ACTION_FLING,
+    HID_ACTION_REPLAY,
+    HID_ACTION_TEXT,
+    HID_ACTION_TEXT_STREAM,
+    HID_ACTION_BATCH,
+} hid_action_type_t;
+
+typedef void (*hid_key_action_fn_t)(uint16_t conn_id);
+
+/// One validated action, copied into the job table on submit
+typedef struct {
+    hid_action_type_t type;
+    union {
+        struct {
+            float x;
+            float y;
+            uint32_t duration_ms;
+        } touch;                                  /*!< TAP, LONG_PRESS */
+        struct {
+            float start_x;
+            float start_y;
+            float end_x;
+            float end_y;
+            uint32_t duration_ms;
+        } swipe;                                  /*!< SWIPE */
+        struct {
+            uint32_t count;
+            float xs[HID_ACTION_MAX_POINTS];
+            float ys[HID_ACTION_MAX_POINTS];
+            uint32_t duration_ms;
+        } multi;                                  /*!< MULTI_TAP, MULTI_LONG_PRESS */
+        struct {
+            hid_key_action_fn_t press;
+        } key;                                    /*!< KEY */
+        struct {
+            float center_x;
+            float center_y;
+            float start_spread;
+            float end_spread;
+            float start_deg;
+            float end_deg;
+            uint32_t duration_ms;
+        } pair;                                   /*!< PINCH (start_deg == end_deg), ROTATE (equal spreads) */
+        struct {
+            hid_traj_path_t points;
+            uint32_t duration_ms;
+        } path;                                   /*!< PATH */
+        struct {
+            float start_x;
+            float start_y;
+            float angle_deg;
+            float distance;
+            float velocity;
+            bool fling;                           /*!< false: come to rest before the lift */
+        } fling;                                  /*!< FLING */
+        struct {
+            int slot;
+        } replay;                                 /*!< REPLAY, a committed hid_replay slot owned by the job */
+        struct {
+            int slot;
+        } text;                                   /*!< TEXT, a committed hid_keyboard text slot owned by the job */
+                                                  /*!< TEXT_STREAM has no parameters: it types the open text stream */
+        struct {
+            uint32_t slot;
+        } batch;                                  /*!< BATCH, filled in by hid_executor_submit_batch() */
+    };
+} hid_action_t;
+
+/// One step of a batch: wait delay_ms after the previous step finished, then run action
+typedef struct {
+    hid_action_t action;
+    uint32_t delay_ms;
+} hid_batch_step_t;
+
+/// Per-step timing of a batch, offsets are microseconds from the start of the batch
+typedef struct {
+    hid_action_type_t type;
+    int64_t planned_us;                           /*!< Previous step's end + delay_ms */
+    int64_t started_us;
+    int64_t finished_us;
+    hid_pacer_stats_t timing;                     /*!< Report timing inside the step */
+} hid_batch_step_result_t;
+
+typedef enum {
+    HID_JOB_QUEUED = 0,
+    HID_JOB_RUNNING,
+    HID_JOB_DONE,
+} hid_job_state_t;
+
+/// Snapshot of a job, timestamps are esp_timer microseconds (0 = not reached yet)
+typedef struct {
+    uint32_t id;
+    hid_job_state_t state;
+    hid_action_type_t type;
+    int64_t queued_us;
+    int64_t started_us;
+    int64_t finished_us;
+    hid_pacer_stats_t timing;                     /*!< Planned vs. actual report timing, valid once done */
+} hid_job_info_t;
+
+/**
+ * @brief Create the job queue and the executor task. Safe to call more than once.
+ */
+esp_err_t hid_executor_start(void);
+
+/**
+ * @brief Queue an action for conn_id without waiting for it to run. HID_LINK_ALL plays the
+ *        same planned action to every connected host, interleaved per frame.
+ *
+ * @return ESP_OK with *out_job_id set, ESP_ERR_NO_MEM when the queue is full,
+ *         ESP_ERR_INVALID_STATE when the executor is not started
+ */
+esp_err_t hid_executor_submit(uint16_t conn_id, const hid_action_t *action, uint32_t *out_job_id);
+
+/**
+ * @brief Queue a sequence of actions that runs back-to-back as one job.
+ *
+ * Nested batches are rejected.
+ *
+ * @return ESP_OK with *out_job_id set, ESP_ERR_NO_MEM when the queue or every batch slot is busy,
+ *         ESP_ERR_INVALID_ARG for an empty, oversized or nested batch
+ */
+esp_err_t hid_executor_submit_batch(uint16_t conn_id, const hid_batch_step_t *steps, uint32_t count,
+                                    uint32_t *out_job_id);
+
+/**
+ * @brief Look up a job by id.
+ *
+ * @return ESP_OK, or ESP_ERR_NOT_FOUND when the id is unknown or its slot was reused
+ */
+esp_err_t hid_executor_get_job(uint32_t job_id, hid_job_info_t *out);
+
+/**
+ * @brief Copy the per-step results of a batch job. Steps that have not run yet are zeroed.
+ *
+ * @return ESP_OK, or ESP_ERR_NOT_FOUND when the job is not a batch or its slot was reused
+ */
+esp_err_t hid_executor_get_batch_results(uint32_t job_id, hid_batch_step_result_t *out, uint32_t max,
+                                         uint32_t *out_count);
+
+const char *hid_job_state_name(hid_job_state_t state);
+const char *hid_action_type_name(hid_action_type_t type);
+
+#endif /* HID_EXECUTOR_H */
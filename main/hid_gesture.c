@@ -0,0 +1,464 @@
+/*
+ * Gesture planning and playback implementation.
+ *
+ * All coordinate math (mapping, easing, arc) runs in the planners. The pool is
+ * static so planning never touches the heap; blocks are handed out under a
+ * short critical section.
+ */
+
+#include "hid_gesture.h"
+
+#include <string.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+#include "esp_timer.h"
+
+#include "esp_hidd_prf_api.h"
+#include "hid_coalesce.h"
+#include "hid_trajectory.h"
+
+#define HID_GESTURE_MIN_SWIPE_MS (HID_GESTURE_INTERVAL_MS * 4)
+#define HID_GESTURE_MIN_SWIPE_STEPS 5
+
+static hid_gesture_point_t s_pool[HID_GESTURE_POOL_BLOCKS][HID_GESTURE_MAX_POINTS];
+static bool s_pool_used[HID_GESTURE_POOL_BLOCKS];
+static portMUX_TYPE s_pool_lock = portMUX_INITIALIZER_UNLOCKED;
+
+esp_err_t hid_gesture_acquire(hid_gesture_t *gesture)
+{
+    if (!gesture)
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    int block = -1;
+    taskENTER_CRITICAL(&s_pool_lock);
+    for (int i = 0; i < HID_GESTURE_POOL_BLOCKS; ++i)
+    {
+        if (!s_pool_used[i])
+        {
+            s_pool_used[i] = true;
+            block = i;
+            break;
+        }
+    }
+    taskEXIT_CRITICAL(&s_pool_lock);
+
+    if (block < 0)
+    {
+        memset(gesture, 0, sizeof(*gesture));
+        gesture->block = -1;
+        return ESP_ERR_NO_MEM;
+    }
+
+    gesture->points = s_pool[block];
+    gesture->count = 0;
+    gesture->capacity = HID_GESTURE_MAX_POINTS;
+    gesture->block = (int8_t)block;
+    gesture->interval_us = 0;
+    return ESP_OK;
+}
+
+void hid_gesture_release(hid_gesture_t *gesture)
+{
+    if (!gesture || gesture->block < 0 || gesture->block >= HID_GESTURE_POOL_BLOCKS)
+    {
+        return;
+    }
+
+    taskENTER_CRITICAL(&s_pool_lock);
+    s_pool_used[gesture->block] = false;
+    taskEXIT_CRITICAL(&s_pool_lock);
+
+    gesture->points = NULL;
+    gesture->count = 0;
+    gesture->capacity = 0;
+    gesture->block = -1;
+}
+
+uint32_t hid_gesture_end_us(const hid_gesture_t *gesture)
+{
+    if (!gesture || gesture->count == 0)
+    {
+        return 0;
+    }
+    return gesture->points[gesture->count - 1].t_us;
+}
+
+static inline void hid_gesture_put(hid_gesture_t *gesture, uint32_t t_us, uint8_t id, uint16_t x, uint16_t y,
+                                   bool tip)
+{
+    hid_gesture_point_t *point = &gesture->points[gesture->count++];
+    point->t_us = t_us;
+    point->x = x;
+    point->y = y;
+    point->tip = tip ? 1 : 0;
+    point->id = id;
+}
+
+esp_err_t hid_gesture_plan_press(hid_gesture_t *gesture, uint32_t t0_us, float x, float y, uint32_t hold_ms)
+{
+    if (!gesture || !gesture->points || hold_ms > HID_GESTURE_MAX_DURATION_MS)
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (gesture->capacity - gesture->count < 2)
+    {
+        return ESP_ERR_NO_MEM;
+    }
+
+    uint16_t mapped_x = hid_traj_map_normalized(x);
+    uint16_t mapped_y = hid_traj_map_normalized(y);
+
+    hid_gesture_put(gesture, t0_us, 0, mapped_x, mapped_y, true);
+    hid_gesture_put(gesture, t0_us + hold_ms * 1000, 0, mapped_x, mapped_y, false);
+    return ESP_OK;
+}
+
+esp_err_t hid_gesture_plan_multi_press(hid_gesture_t *gesture, uint32_t t0_us, uint32_t count,
+                                       const float *xs, const float *ys, uint32_t hold_ms)
+{
+    if (!gesture || !gesture->points || !xs || !ys || count == 0 || count > HID_TOUCH_MAX_CONTACTS ||
+        hold_ms > HID_GESTURE_MAX_DURATION_MS)
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (gesture->capacity - gesture->count < count * 2)
+    {
+        return ESP_ERR_NO_MEM;
+    }
+
+    uint16_t mapped_x[HID_TOUCH_MAX_CONTACTS];
+    uint16_t mapped_y[HID_TOUCH_MAX_CONTACTS];
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        mapped_x[i] = hid_traj_map_normalized(xs[i]);
+        mapped_y[i] = hid_traj_map_normalized(ys[i]);
+        hid_gesture_put(gesture, t0_us, (uint8_t)i, mapped_x[i], mapped_y[i], true);
+    }
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        hid_gesture_put(gesture, t0_us + hold_ms * 1000, (uint8_t)i, mapped_x[i], mapped_y[i], false);
+    }
+    return ESP_OK;
+}
+
+/*
+ * Moves are sent one connection interval apart once the host has settled it, so each one
+ * meets its own connection event; a fixed 16 ms step on a 15 ms interval would leave some
+ * events empty and give others two moves, which the host reads as jerky velocity.
+ */
+static uint32_t hid_gesture_interval_us(const hid_gesture_t *gesture)
+{
+    return gesture->interval_us ? gesture->interval_us : HID_GESTURE_INTERVAL_MS * 1000u;
+}
+
+// Whole intervals in duration_us, the interval widened to a multiple of itself when the block
+// cannot hold one move per interval. 0 when fewer than the minimum fit: spread those evenly.
+static uint32_t hid_gesture_aligned_steps(uint32_t duration_us, uint32_t max_steps, uint32_t *interval_us)
+{
+    uint32_t steps = duration_us / *interval_us;
+    if (steps > max_steps)
+    {
+        *interval_us *= (steps + max_steps - 1) / max_steps;
+        steps = duration_us / *interval_us;
+    }
+    if (steps < HID_GESTURE_MIN_SWIPE_STEPS)
+    {
+        *interval_us = 0;
+        return HID_GESTURE_MIN_SWIPE_STEPS;
+    }
+    return steps;
+}
+
+// Offset of move i of steps, counted back from the end so the last moves, which hosts take
+// the release velocity from, are exactly one interval apart
+static inline uint32_t hid_gesture_move_us(uint32_t total_us, uint32_t i, uint32_t steps, uint32_t interval_us)
+{
+    return interval_us ? total_us - (steps - i) * interval_us : (uint32_t)((uint64_t)total_us * i / steps);
+}
+
+esp_err_t hid_gesture_plan_swipe(hid_gesture_t *gesture, uint32_t t0_us, float start_x, float start_y,
+                                 float end_x, float end_y, uint32_t duration_ms)
+{
+    if (!gesture || !gesture->points || duration_ms > HID_GESTURE_MAX_DURATION_MS)
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    // Down + at least the minimum number of moves + lift
+    uint32_t room = gesture->capacity - gesture->count;
+    if (room < HID_GESTURE_MIN_SWIPE_STEPS + 2)
+    {
+        return ESP_ERR_NO_MEM;
+    }
+
+    if (duration_ms < HID_GESTURE_MIN_SWIPE_MS)
+    {
+        duration_ms = HID_GESTURE_MIN_SWIPE_MS;
+    }
+
+    // The duration is rounded to whole intervals so the eased steps land on them
+    uint32_t interval_us = hid_gesture_interval_us(gesture);
+    uint32_t duration_us = duration_ms * 1000;
+    uint32_t steps = hid_gesture_aligned_steps(duration_us + interval_us / 2, room - 2, &interval_us);
+    if (interval_us)
+    {
+        duration_us = steps * interval_us;
+    }
+
+    hid_traj_swipe_t traj;
+    hid_traj_swipe_init(&traj, start_x, start_y, end_x, end_y, steps);
+
+    hid_gesture_put(gesture, t0_us, 0, hid_traj_map_normalized(start_x), hid_traj_map_normalized(start_y), true);
+
+    for (uint32_t i = 1; i <= steps; ++i)
+    {
+        uint16_t x, y;
+        hid_traj_swipe_point(&traj, i, &x, &y);
+        hid_gesture_put(gesture, t0_us + hid_gesture_move_us(duration_us, i, steps, interval_us), 0, x, y, true);
+    }
+
+    hid_gesture_put(gesture, t0_us + duration_us, 0,
+                    hid_traj_map_normalized(end_x), hid_traj_map_normalized(end_y), false);
+    return ESP_OK;
+}
+
+esp_err_t hid_gesture_plan_pair(hid_gesture_t *gesture, uint32_t t0_us, float center_x, float center_y,
+                                float start_spread, float end_spread, float start_deg, float end_deg,
+                                uint32_t duration_ms)
+{
+    if (!gesture || !gesture->points || duration_ms > HID_GESTURE_MAX_DURATION_MS)
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    // Two records per frame: down + at least the minimum number of moves + lift
+    uint32_t room = (gesture->capacity - gesture->count) / 2;
+    if (room < HID_GESTURE_MIN_SWIPE_STEPS + 2)
+    {
+        return ESP_ERR_NO_MEM;
+    }
+
+    if (duration_ms < HID_GESTURE_MIN_SWIPE_MS)
+    {
+        duration_ms = HID_GESTURE_MIN_SWIPE_MS;
+    }
+
+    uint32_t interval_us = hid_gesture_interval_us(gesture);
+    uint32_t duration_us = duration_ms * 1000;
+    uint32_t steps = hid_gesture_aligned_steps(duration_us + interval_us / 2, room - 2, &interval_us);
+    if (interval_us)
+    {
+        duration_us = steps * interval_us;
+    }
+
+    hid_traj_pair_t traj;
+    hid_traj_pair_init(&traj, center_x, center_y, start_spread, end_spread, start_deg, end_deg, steps);
+
+    uint16_t xs[2], ys[2];
+    hid_traj_pair_point(&traj, 0, xs, ys);
+    hid_gesture_put(gesture, t0_us, 0, xs[0], ys[0], true);
+    hid_gesture_put(gesture, t0_us, 1, xs[1], ys[1], true);
+
+    for (uint32_t i = 1; i <= steps; ++i)
+    {
+        uint32_t t_us = t0_us + hid_gesture_move_us(duration_us, i, steps, interval_us);
+        hid_traj_pair_point(&traj, i, xs, ys);
+        hid_gesture_put(gesture, t_us, 0, xs[0], ys[0], true);
+        hid_gesture_put(gesture, t_us, 1, xs[1], ys[1], true);
+    }
+
+    hid_gesture_put(gesture, t0_us + duration_us, 0, xs[0], ys[0], false);
+    hid_gesture_put(gesture, t0_us + duration_us, 1, xs[1], ys[1], false);
+    return ESP_OK;
+}
+
+esp_err_t hid_gesture_plan_path(hid_gesture_t *gesture, uint32_t t0_us, const hid_traj_path_t *path,
+                                uint32_t duration_ms)
+{
+    if (!gesture || !gesture->points || duration_ms > HID_GESTURE_MAX_DURATION_MS)
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    uint32_t room = gesture->capacity - gesture->count;
+    if (room < HID_GESTURE_MIN_SWIPE_STEPS + 2)
+    {
+        return ESP_ERR_NO_MEM;
+    }
+
+    if (duration_ms < HID_GESTURE_MIN_SWIPE_MS)
+    {
+        duration_ms = HID_GESTURE_MIN_SWIPE_MS;
+    }
+
+    hid_traj_path_walk_t walk;
+    if (!hid_traj_path_begin(&walk, path, duration_ms))
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    // Slow per-segment speeds can add up past what the uint32 total holds
+    uint64_t total_us = 0;
+    for (uint32_t seg = 0; seg < walk.segments; ++seg)
+    {
+        total_us += walk.seg_us[seg];
+    }
+    if (total_us > (uint64_t)HID_GESTURE_MAX_DURATION_MS * 1000)
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    uint32_t interval_us = hid_gesture_interval_us(gesture);
+    uint32_t steps = hid_gesture_aligned_steps(walk.total_us, room - 2, &interval_us);
+
+    uint16_t x, y;
+    hid_traj_path_at(&walk, 0, &x, &y);
+    hid_gesture_put(gesture, t0_us, 0, x, y, true);
+
+    for (uint32_t i = 1; i <= steps; ++i)
+    {
+        uint32_t t_us = hid_gesture_move_us(walk.total_us, i, steps, interval_us);
+        hid_traj_path_at(&walk, t_us, &x, &y);
+        hid_gesture_put(gesture, t0_us + t_us, 0, x, y, true);
+    }
+
+    hid_gesture_put(gesture, t0_us + walk.total_us, 0, x, y, false);
+    return ESP_OK;
+}
+
+esp_err_t hid_gesture_plan_fling(hid_gesture_t *gesture, uint32_t t0_us, float start_x, float start_y,
+                                 float angle_deg, float distance, float velocity, bool fling)
+{
+    if (!gesture || !gesture->points)
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    uint32_t room = gesture->capacity - gesture->count;
+    if (room < HID_GESTURE_MIN_SWIPE_STEPS + 2)
+    {
+        return ESP_ERR_NO_MEM;
+    }
+
+    hid_traj_fling_t traj;
+    hid_traj_fling_init(&traj, start_x, start_y, angle_deg, distance, velocity, fling);
+
+    uint32_t interval_us = hid_gesture_interval_us(gesture);
+    uint32_t steps = hid_gesture_aligned_steps(traj.move_us, room - 2, &interval_us);
+
+    uint16_t x, y;
+    hid_traj_fling_at(&traj, 0, &x, &y);
+    hid_gesture_put(gesture, t0_us, 0, x, y, true);
+
+    for (uint32_t i = 1; i <= steps; ++i)
+    {
+        uint32_t t_us = hid_gesture_move_us(traj.move_us, i, steps, interval_us);
+        hid_traj_fling_at(&traj, t_us, &x, &y);
+        hid_gesture_put(gesture, t0_us + t_us, 0, x, y, true);
+    }
+
+    uint32_t lift_us = traj.move_us + (fling ? 0 : HID_TRAJ_FLING_SETTLE_MS * 1000);
+    hid_gesture_put(gesture, t0_us + lift_us, 0, x, y, false);
+    return ESP_OK;
+}
+
+void hid_gesture_play(uint16_t conn_id, const hid_gesture_t *gesture, hid_pacer_stats_t *out)
+{
+    hid_gesture_play_hosts(&conn_id, 1, gesture, out);
+}
+
+void hid_gesture_play_hosts(const uint16_t *conn_ids, uint8_t host_count, const hid_gesture_t *gesture,
+                            hid_pacer_stats_t *out)
+{
+    hid_pacer_t pacer;
+    hid_pacer_begin(&pacer);
+
+    if (host_count > HID_MAX_LINKS)
+    {
+        host_count = HID_MAX_LINKS;
+    }
+
+    if (gesture && gesture->points && conn_ids && host_count > 0)
+    {
+        esp_hidd_touch_contact_t contacts[HID_TOUCH_MAX_CONTACTS];
+        esp_hidd_touch_contact_t frame[HID_TOUCH_MAX_CONTACTS];
+        uint16_t live = 0; // Contacts that are down or lift in the current frame
+        hid_coalesce_t co[HID_MAX_LINKS];
+        for (uint8_t h = 0; h < host_count; ++h)
+        {
+            hid_coalesce_begin(&co[h]);
+        }
+
+        const hid_gesture_point_t *point = gesture->points;
+        const hid_gesture_point_t *end = point + gesture->count;
+        uint32_t frames = 0;
+        while (point < end)
+        {
+            // A frame ends at a new deadline or when a contact would appear in it twice
+            const uint32_t t_us = point->t_us;
+            uint16_t in_frame = 0;
+            for (; point < end && point->t_us == t_us; ++point)
+            {
+                if (point->id >= HID_TOUCH_MAX_CONTACTS)
+                {
+                    continue;
+                }
+                if (in_frame & (1u << point->id))
+                {
+                    break;
+                }
+                in_frame |= 1u << point->id;
+                esp_hidd_touch_contact_t *contact = &contacts[point->id];
+                contact->id = point->id;
+                contact->tip = point->tip;
+                contact->x = point->x;
+                contact->y = point->y;
+                live |= 1u << point->id;
+            }
+
+            uint8_t count = 0;
+            for (uint8_t id = 0; id < HID_TOUCH_MAX_CONTACTS; ++id)
+            {
+                if (live & (1u << id))
+                {
+                    frame[count++] = contacts[id];
+                    if (!contacts[id].tip)
+                    {
+                        live &= ~(1u << id);
+                    }
+                }
+            }
+
+            hid_pacer_wait_until(&pacer, t_us);
+            // Only a frame with its own later deadline supersedes this one. The decision is
+            // shared so every host sees the same trajectory.
+            bool superseded = point < end && point->t_us > t_us && hid_pacer_due(&pacer, point->t_us);
+
+            // Hosts take turns going first so none is always the last to receive a frame
+            int64_t first_us = 0;
+            int64_t last_us = 0;
+            for (uint8_t h = 0; h < host_count; ++h)
+            {
+                const uint8_t host = (uint8_t)((frames + h) % host_count);
+                last_us = esp_timer_get_time();
+                if (h == 0)
+                {
+                    first_us = last_us;
+                }
+                hid_coalesce_send(&co[host], conn_ids[host], frame, count, superseded);
+            }
+            if (host_count > 1)
+            {
+                hid_pacer_skew(&pacer, last_us - first_us);
+            }
+            hid_pacer_sent(&pacer);
+            frames++;
+        }
+    }
+
+    hid_pacer_finish(&pacer, out);
+}
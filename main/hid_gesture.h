@@ -0,0 +1,125 @@
+/*
+ * Gesture planning and playback.
+ *
+ * A planner turns a touch request into timestamped records in a pooled buffer;
+ * playback only waits for each timestamp and sends the record as it is.
+ */
+
+#ifndef HID_GESTURE_H
+#define HID_GESTURE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "esp_err.h"
+
+#include "hid_pacer.h"
+#include "hid_trajectory.h"
+
+#define HID_GESTURE_POOL_BLOCKS 2      // Gestures that can be planned at the same time
+#define HID_GESTURE_MAX_POINTS 512     // Records per block, 12 bytes each
+#define HID_GESTURE_INTERVAL_MS 16     // Move spacing until the connection interval is known
+#define HID_GESTURE_MAX_DURATION_MS (10 * 60 * 1000) // Longest hold or stroke; record times are uint32 us
+
+/// One planned contact update, t_us is the offset from the start of playback.
+/// Consecutive records with the same t_us are sent as one multi-contact frame.
+typedef struct {
+    uint32_t t_us;
+    uint16_t x;
+    uint16_t y;
+    uint8_t tip;                                  /*!< 1 = finger down, 0 = lift */
+    uint8_t id;                                   /*!< Contact identifier */
+} hid_gesture_point_t;
+
+/// A planned gesture backed by one pool block
+typedef struct {
+    hid_gesture_point_t *points;
+    uint16_t count;
+    uint16_t capacity;
+    int8_t block;                                 /*!< Pool block index, -1 when not acquired */
+    uint32_t interval_us;                         /*!< Connection interval of the target link, 0 while unknown */
+} hid_gesture_t;
+
+/**
+ * @brief Take a free block from the pool. Set interval_us afterwards to align moves to a link.
+ *
+ * @return ESP_OK, or ESP_ERR_NO_MEM when every block is in use
+ */
+esp_err_t hid_gesture_acquire(hid_gesture_t *gesture);
+
+void hid_gesture_release(hid_gesture_t *gesture);
+
+/**
+ * @brief Offset of the last record, i.e. where the next planned step may start.
+ */
+uint32_t hid_gesture_end_us(const hid_gesture_t *gesture);
+
+/**
+ * @brief Append a tap or press: down at t0_us, lift after hold_ms.
+ *
+ * @return ESP_OK, ESP_ERR_INVALID_ARG when hold_ms exceeds HID_GESTURE_MAX_DURATION_MS,
+ *         or ESP_ERR_NO_MEM when the block is full
+ */
+esp_err_t hid_gesture_plan_press(hid_gesture_t *gesture, uint32_t t0_us, float x, float y, uint32_t hold_ms);
+
+/**
+ * @brief Append a press of several fingers at once: all down at t0_us, all lifted after hold_ms.
+ *        Finger i uses contact id i.
+ *
+ * @return ESP_OK, ESP_ERR_INVALID_ARG for more than HID_TOUCH_MAX_CONTACTS fingers or hold_ms
+ *         over HID_GESTURE_MAX_DURATION_MS, or ESP_ERR_NO_MEM when the block is full
+ */
+esp_err_t hid_gesture_plan_multi_press(hid_gesture_t *gesture, uint32_t t0_us, uint32_t count,
+                                       const float *xs, const float *ys, uint32_t hold_ms);
+
+/**
+ * @brief Append a swipe starting at t0_us. Moves go one connection interval apart and the
+ *        duration is rounded to whole intervals; the spacing is widened to a multiple of the
+ *        interval if the block cannot hold one record per interval. A duration over
+ *        HID_GESTURE_MAX_DURATION_MS is ESP_ERR_INVALID_ARG, as for the other planners.
+ */
+esp_err_t hid_gesture_plan_swipe(hid_gesture_t *gesture, uint32_t t0_us, float start_x, float start_y,
+                                 float end_x, float end_y, uint32_t duration_ms);
+
+/**
+ * @brief Append a two-finger pinch/rotate starting at t0_us, contacts 0 and 1 moving in the
+ *        same frames. Spread and angle are eased like a swipe; see hid_traj_pair_init().
+ */
+esp_err_t hid_gesture_plan_pair(hid_gesture_t *gesture, uint32_t t0_us, float center_x, float center_y,
+                                float start_spread, float end_spread, float start_deg, float end_deg,
+                                uint32_t duration_ms);
+
+/**
+ * @brief Append a path starting at t0_us with the finger down throughout, sampled once per
+ *        connection interval by arc length. Timing follows hid_traj_path_begin().
+ *
+ * @return ESP_OK, ESP_ERR_INVALID_ARG for a path whose point count does not fit its kind or
+ *         that lasts over HID_GESTURE_MAX_DURATION_MS, or ESP_ERR_NO_MEM when the block is full
+ */
+esp_err_t hid_gesture_plan_path(hid_gesture_t *gesture, uint32_t t0_us, const hid_traj_path_t *path,
+                                uint32_t duration_ms);
+
+/**
+ * @brief Append a fling or stopping scroll starting at t0_us; see hid_traj_fling_init().
+ *        Moves are counted back from the end one connection interval apart, and are never
+ *        stretched to a minimum duration, which would change the velocity.
+ *        A fling lifts as it reaches the end point, a stop lifts HID_TRAJ_FLING_SETTLE_MS later.
+ */
+esp_err_t hid_gesture_plan_fling(hid_gesture_t *gesture, uint32_t t0_us, float start_x, float start_y,
+                                 float angle_deg, float distance, float velocity, bool fling);
+
+/**
+ * @brief Send every frame of a planned gesture on its deadline. Contacts that are down
+ *        are repeated in later frames until their lift record is sent. Frames go through
+ *        hid_coalesce, so a player that falls behind skips moves instead of queueing them.
+ */
+void hid_gesture_play(uint16_t conn_id, const hid_gesture_t *gesture, hid_pacer_stats_t *out);
+
+/**
+ * @brief Play one planned gesture to several hosts at once. Each deadline sends the same frame
+ *        to every host back to back, and the spread between the first and last send is
+ *        reported as skew.
+ */
+void hid_gesture_play_hosts(const uint16_t *conn_ids, uint8_t host_count, const hid_gesture_t *gesture,
+                            hid_pacer_stats_t *out);
+
+#endif /* HID_GESTURE_H */
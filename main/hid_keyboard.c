@@ -0,0 +1,554 @@
+/*
+ * Text typing implementation.
+ *
+ * A host registers a key press when the usage appears in a report and a release when it
+ * leaves, so "abc" can go out as [a] [a b] [a b c]: three reports for three characters.
+ * Keys are held for at most HID_KEYBOARD_KEY_SLOTS reports, well inside the host's
+ * auto-repeat delay.
+ */
+
+#include "hid_keyboard.h"
+
+#include <string.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
+#include "freertos/task.h"
+
+#include "esp_log.h"
+#include "esp_timer.h"
+
+#include "hid_dev.h"
+
+#define SHIFT 0x80 // Marks a US-layout entry typed with Shift
+#define HID_TEXT_STREAM_POLL_MS 50 // How often a blocked side checks whether the other gave up
+
+static const char *TAG = "HID_KEYBOARD";
+
+typedef struct {
+    uint8_t data[HID_TEXT_MAX_BYTES];
+    size_t len;
+    bool used;
+} hid_text_slot_t;
+
+/// Key-event ring between the HTTP handler decoding a body and the executor typing it
+typedef struct {
+    QueueHandle_t strokes;
+    StaticQueue_t queue;
+    uint8_t storage[HID_TEXT_STREAM_DEPTH * sizeof(hid_key_stroke_t)];
+    uint8_t refs;                                 /*!< Writer and typist; free at 0 */
+    volatile bool aborted;
+} hid_text_stream_t;
+
+static hid_text_slot_t s_slots[HID_TEXT_SLOTS];
+static hid_text_stream_t s_stream;
+static portMUX_TYPE s_slot_lock = portMUX_INITIALIZER_UNLOCKED;
+
+// Printable ASCII from ' ', usage ID with SHIFT for the upper symbol of a key
+static const uint8_t s_us_layout[0x7F - 0x20] = {
+    [' ' - 0x20] = HID_KEY_SPACEBAR,
+    ['!' - 0x20] = HID_KEY_1 | SHIFT,
+    ['"' - 0x20] = HID_KEY_SGL_QUOTE | SHIFT,
+    ['#' - 0x20] = HID_KEY_3 | SHIFT,
+    ['$' - 0x20] = HID_KEY_4 | SHIFT,
+    ['%' - 0x20] = HID_KEY_5 | SHIFT,
+    ['&' - 0x20] = HID_KEY_7 | SHIFT,
+    ['\'' - 0x20] = HID_KEY_SGL_QUOTE,
+    ['(' - 0x20] = HID_KEY_9 | SHIFT,
+    [')' - 0x20] = HID_KEY_0 | SHIFT,
+    ['*' - 0x20] = HID_KEY_8 | SHIFT,
+    ['+' - 0x20] = HID_KEY_EQUAL | SHIFT,
+    [',' - 0x20] = HID_KEY_COMMA,
+    ['-' - 0x20] = HID_KEY_MINUS,
+    ['.' - 0x20] = HID_KEY_DOT,
+    ['/' - 0x20] = HID_KEY_FWD_SLASH,
+    ['0' - 0x20] = HID_KEY_0,
+    ['1' - 0x20] = HID_KEY_1,
+    ['2' - 0x20] = HID_KEY_2,
+    ['3' - 0x20] = HID_KEY_3,
+    ['4' - 0x20] = HID_KEY_4,
+    ['5' - 0x20] = HID_KEY_5,
+    ['6' - 0x20] = HID_KEY_6,
+    ['7' - 0x20] = HID_KEY_7,
+    ['8' - 0x20] = HID_KEY_8,
+    ['9' - 0x20] = HID_KEY_9,
+    [':' - 0x20] = HID_KEY_SEMI_COLON | SHIFT,
+    [';' - 0x20] = HID_KEY_SEMI_COLON,
+    ['<' - 0x20] = HID_KEY_COMMA | SHIFT,
+    ['=' - 0x20] = HID_KEY_EQUAL,
+    ['>' - 0x20] = HID_KEY_DOT | SHIFT,
+    ['?' - 0x20] = HID_KEY_FWD_SLASH | SHIFT,
+    ['@' - 0x20] = HID_KEY_2 | SHIFT,
+    ['[' - 0x20] = HID_KEY_LEFT_BRKT,
+    ['\\' - 0x20] = HID_KEY_BACK_SLASH,
+    [']' - 0x20] = HID_KEY_RIGHT_BRKT,
+    ['^' - 0x20] = HID_KEY_6 | SHIFT,
+    ['_' - 0x20] = HID_KEY_MINUS | SHIFT,
+    ['`' - 0x20] = HID_KEY_GRV_ACCENT,
+    ['{' - 0x20] = HID_KEY_LEFT_BRKT | SHIFT,
+    ['|' - 0x20] = HID_KEY_BACK_SLASH | SHIFT,
+    ['}' - 0x20] = HID_KEY_RIGHT_BRKT | SHIFT,
+    ['~' - 0x20] = HID_KEY_GRV_ACCENT | SHIFT,
+};
+
+bool hid_keyboard_map_char(uint32_t cp, hid_key_stroke_t *out)
+{
+    uint8_t entry = 0;
+
+    if (cp >= 'a' && cp <= 'z')
+    {
+        entry = (uint8_t)(HID_KEY_A + (cp - 'a'));
+    }
+    else if (cp >= 'A' && cp <= 'Z')
+    {
+        entry = (uint8_t)(HID_KEY_A + (cp - 'A')) | SHIFT;
+    }
+    else if (cp >= 0x20 && cp < 0x7F)
+    {
+        entry = s_us_layout[cp - 0x20];
+    }
+    else if (cp == '\n')
+    {
+        entry = HID_KEY_RETURN;
+    }
+    else if (cp == '\t')
+    {
+        entry = HID_KEY_TAB;
+    }
+
+    if (entry == 0)
+    {
+        return false;
+    }
+    out->usage = entry & ~SHIFT;
+    out->modifiers = (entry & SHIFT) ? LEFT_SHIFT_KEY_MASK : 0;
+    return true;
+}
+
+bool hid_utf8_feed(hid_utf8_t *dec, uint8_t byte, uint32_t *cp)
+{
+    if (dec->need > 0)
+    {
+        if ((byte & 0xC0) == 0x80)
+        {
+            dec->cp = (dec->cp << 6) | (byte & 0x3F);
+            if (--dec->need == 0)
+            {
+                *cp = dec->cp;
+                return true;
+            }
+            return false;
+        }
+        // Truncated sequence: drop it and read this byte as a new lead
+        dec->need = 0;
+        dec->errors++;
+    }
+
+    if (byte < 0x80)
+    {
+        *cp = byte;
+        return true;
+    }
+    if (byte >= 0xC2 && byte <= 0xDF)
+    {
+        dec->cp = byte & 0x1F;
+        dec->need = 1;
+    }
+    else if (byte >= 0xE0 && byte <= 0xEF)
+    {
+        dec->cp = byte & 0x0F;
+        dec->need = 2;
+    }
+    else if (byte >= 0xF0 && byte <= 0xF4)
+    {
+        dec->cp = byte & 0x07;
+        dec->need = 3;
+    }
+    else
+    {
+        dec->errors++; // stray continuation or invalid lead byte
+    }
+    return false;
+}
+
+// Decode one byte; true with *stroke set when it completes a character that can be typed
+static bool hid_text_next(hid_utf8_t *dec, uint8_t byte, hid_key_stroke_t *stroke, hid_text_stats_t *stats)
+{
+    const uint32_t errors = dec->errors;
+    uint32_t cp;
+    bool done = hid_utf8_feed(dec, byte, &cp);
+    stats->unsupported += dec->errors - errors;
+
+    if (!done || cp == '\r')
+    {
+        return false;
+    }
+    if (!hid_keyboard_map_char(cp, stroke))
+    {
+        stats->unsupported++;
+        return false;
+    }
+    stats->chars++;
+    return true;
+}
+
+// A text that ends inside a sequence has one more invalid character
+static void hid_text_end(hid_utf8_t *dec, hid_text_stats_t *stats)
+{
+    if (dec->need > 0)
+    {
+        dec->need = 0;
+        dec->errors++;
+        stats->unsupported++;
+    }
+}
+
+static void hid_typist_send(hid_typist_t *typist)
+{
+    hid_pacer_wait_until(&typist->pacer, typist->next_us);
+
+    // Hosts take turns going first, as in hid_gesture_play_hosts()
+    int64_t first_us = 0;
+    int64_t last_us = 0;
+    for (uint8_t h = 0; h < typist->host_count; ++h)
+    {
+        const uint8_t host = (uint8_t)((typist->stats.reports + h) % typist->host_count);
+        last_us = esp_timer_get_time();
+        if (h == 0)
+        {
+            first_us = last_us;
+        }
+        esp_hidd_send_keyboard_value(typist->conn_ids[host], typist->modifiers, typist->keys, typist->count);
+    }
+    if (typist->host_count > 1)
+    {
+        hid_pacer_skew(&typist->pacer, last_us - first_us);
+    }
+    hid_pacer_sent(&typist->pacer);
+
+    typist->stats.reports++;
+    typist->next_us += typist->interval_us;
+}
+
+static void hid_typist_drop(hid_typist_t *typist, uint8_t index)
+{
+    memmove(&typist->keys[index], &typist->keys[index + 1], typist->count - index - 1);
+    typist->keys[--typist->count] = 0;
+}
+
+// A held key only repeats after it has been seen released: send a report without it
+static void hid_typist_release_key(hid_typist_t *typist, uint8_t usage)
+{
+    for (uint8_t i = 0; i < typist->count; ++i)
+    {
+        if (typist->keys[i] == usage)
+        {
+            hid_typist_drop(typist, i);
+            hid_typist_send(typist);
+            return;
+        }
+    }
+}
+
+static void hid_typist_stroke(hid_typist_t *typist, const hid_key_stroke_t *stroke)
+{
+    hid_typist_release_key(typist, stroke->usage);
+
+    if (stroke->modifiers != typist->modifiers)
+    {
+        // Modifiers apply to the whole report: release the held keys while switching
+        memset(typist->keys, 0, sizeof(typist->keys));
+        typist->modifiers = stroke->modifiers;
+        typist->keys[0] = stroke->usage;
+        typist->count = 1;
+        hid_typist_send(typist);
+        return;
+    }
+
+    if (typist->count == HID_KEYBOARD_KEY_SLOTS)
+    {
+        hid_typist_drop(typist, 0);
+    }
+    typist->keys[typist->count++] = stroke->usage;
+    hid_typist_send(typist);
+}
+
+void hid_typist_begin(hid_typist_t *typist, const uint16_t *conn_ids, uint8_t host_count, uint32_t interval_us)
+{
+    memset(typist, 0, sizeof(*typist));
+    if (host_count > HID_MAX_LINKS)
+    {
+        host_count = HID_MAX_LINKS;
+    }
+    memcpy(typist->conn_ids, conn_ids, host_count * sizeof(conn_ids[0]));
+    typist->host_count = host_count;
+    typist->interval_us = interval_us ? interval_us : HID_KEYBOARD_INTERVAL_MS * 1000;
+    hid_pacer_begin(&typist->pacer);
+}
+
+void hid_typist_feed(hid_typist_t *typist, const uint8_t *utf8, size_t len)
+{
+    for (size_t i = 0; i < len; ++i)
+    {
+        hid_key_stroke_t stroke;
+        if (hid_text_next(&typist->utf8, utf8[i], &stroke, &typist->stats))
+        {
+            hid_typist_stroke(typist, &stroke);
+        }
+    }
+}
+
+void hid_typist_release(hid_typist_t *typist)
+{
+    if (typist->count == 0 && typist->modifiers == 0)
+    {
+        return;
+    }
+    memset(typist->keys, 0, sizeof(typist->keys));
+    typist->count = 0;
+    typist->modifiers = 0;
+    hid_typist_send(typist);
+}
+
+void hid_typist_finish(hid_typist_t *typist, hid_pacer_stats_t *out)
+{
+    hid_text_end(&typist->utf8, &typist->stats);
+    hid_typist_release(typist);
+    hid_pacer_finish(&typist->pacer, out);
+}
+
+int hid_text_acquire(void)
+{
+    int slot = -1;
+    taskENTER_CRITICAL(&s_slot_lock);
+    for (int i = 0; i < HID_TEXT_SLOTS; ++i)
+    {
+        if (!s_slots[i].used)
+        {
+            s_slots[i].used = true;
+            s_slots[i].len = 0;
+            slot = i;
+            break;
+        }
+    }
+    taskEXIT_CRITICAL(&s_slot_lock);
+    return slot;
+}
+
+uint8_t *hid_text_buffer(int slot)
+{
+    if (slot < 0 || slot >= HID_TEXT_SLOTS)
+    {
+        return NULL;
+    }
+    return s_slots[slot].data;
+}
+
+esp_err_t hid_text_commit(int slot, size_t len, hid_text_stats_t *out)
+{
+    if (slot < 0 || slot >= HID_TEXT_SLOTS || len == 0 || len > HID_TEXT_MAX_BYTES)
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    hid_text_slot_t *s = &s_slots[slot];
+    s->len = len;
+
+    if (out)
+    {
+        // Same decoding as hid_typist_feed(), without the reports
+        hid_utf8_t dec = { 0 };
+        hid_key_stroke_t stroke;
+        memset(out, 0, sizeof(*out));
+        for (size_t i = 0; i < len; ++i)
+        {
+            hid_text_next(&dec, s->data[i], &stroke, out);
+        }
+        hid_text_end(&dec, out);
+    }
+    return ESP_OK;
+}
+
+void hid_text_release(int slot)
+{
+    if (slot < 0 || slot >= HID_TEXT_SLOTS)
+    {
+        return;
+    }
+
+    taskENTER_CRITICAL(&s_slot_lock);
+    s_slots[slot].used = false;
+    taskEXIT_CRITICAL(&s_slot_lock);
+}
+
+void hid_text_type(const uint16_t *conn_ids, uint8_t host_count, int slot, uint32_t interval_us,
+                   hid_pacer_stats_t *timing, hid_text_stats_t *out)
+{
+    hid_typist_t typist;
+    hid_typist_begin(&typist, conn_ids, host_count, interval_us);
+
+    if (slot >= 0 && slot < HID_TEXT_SLOTS)
+    {
+        hid_typist_feed(&typist, s_slots[slot].data, s_slots[slot].len);
+    }
+
+    hid_typist_finish(&typist, timing);
+    if (out)
+    {
+        *out = typist.stats;
+    }
+}
+
+esp_err_t hid_text_stream_open(void)
+{
+    esp_err_t err = ESP_OK;
+    taskENTER_CRITICAL(&s_slot_lock);
+    if (s_stream.refs > 0)
+    {
+        err = ESP_ERR_INVALID_STATE;
+    }
+    else
+    {
+        s_stream.refs = 2;
+        s_stream.aborted = false;
+    }
+    taskEXIT_CRITICAL(&s_slot_lock);
+
+    if (err != ESP_OK)
+    {
+        return err;
+    }
+    if (!s_stream.strokes)
+    {
+        s_stream.strokes = xQueueCreateStatic(HID_TEXT_STREAM_DEPTH, sizeof(hid_key_stroke_t), s_stream.storage,
+                                              &s_stream.queue);
+    }
+    xQueueReset(s_stream.strokes);
+    return ESP_OK;
+}
+
+// Queue one stroke, waiting for the typist to make room; false once the stream is dead
+static bool hid_text_stream_put(const hid_key_stroke_t *stroke)
+{
+    for (uint32_t waited_ms = 0; waited_ms < HID_TEXT_STREAM_WRITE_MS; waited_ms += HID_TEXT_STREAM_POLL_MS)
+    {
+        if (s_stream.aborted)
+        {
+            return false;
+        }
+        if (xQueueSend(s_stream.strokes, stroke, pdMS_TO_TICKS(HID_TEXT_STREAM_POLL_MS)) == pdTRUE)
+        {
+            return true;
+        }
+    }
+    s_stream.aborted = true;
+    return false;
+}
+
+esp_err_t hid_text_stream_write(hid_utf8_t *dec, const uint8_t *utf8, size_t len, hid_text_stats_t *stats)
+{
+    for (size_t i = 0; i < len; ++i)
+    {
+        hid_key_stroke_t stroke;
+        if (hid_text_next(dec, utf8[i], &stroke, stats) && !hid_text_stream_put(&stroke))
+        {
+            return ESP_ERR_TIMEOUT;
+        }
+    }
+    return ESP_OK;
+}
+
+void hid_text_stream_close(hid_utf8_t *dec, hid_text_stats_t *stats, bool complete)
+{
+    if (complete)
+    {
+        hid_text_end(dec, stats);
+        const hid_key_stroke_t end = { 0 };
+        hid_text_stream_put(&end);
+    }
+    else
+    {
+        s_stream.aborted = true;
+    }
+    hid_text_stream_release();
+}
+
+void hid_text_stream_release(void)
+{
+    taskENTER_CRITICAL(&s_slot_lock);
+    if (s_stream.refs > 0)
+    {
+        s_stream.refs--;
+    }
+    taskEXIT_CRITICAL(&s_slot_lock);
+}
+
+// Next stroke from the ring; false at the end of the text or when the writer went away
+static bool hid_text_stream_take(hid_key_stroke_t *stroke, uint32_t timeout_ms)
+{
+    for (uint32_t waited_ms = 0; waited_ms < timeout_ms; waited_ms += HID_TEXT_STREAM_POLL_MS)
+    {
+        if (xQueueReceive(s_stream.strokes, stroke, pdMS_TO_TICKS(HID_TEXT_STREAM_POLL_MS)) == pdTRUE)
+        {
+            return true;
+        }
+        if (s_stream.aborted)
+        {
+            return false;
+        }
+    }
+    return false;
+}
+
+void hid_text_stream_type(const uint16_t *conn_ids, uint8_t host_count, uint32_t interval_us,
+                          hid_pacer_stats_t *timing, hid_text_stats_t *out)
+{
+    hid_typist_t typist;
+    hid_typist_begin(&typist, conn_ids, host_count, interval_us);
+
+    while (!s_stream.aborted)
+    {
+        hid_key_stroke_t stroke;
+        if (xQueueReceive(s_stream.strokes, &stroke, 0) != pdTRUE)
+        {
+            // Underrun: keep the keys held through a short gap, release them before auto-repeat
+            bool got = hid_text_stream_take(&stroke, HID_TEXT_STREAM_HOLD_MS);
+            if (!got && !s_stream.aborted)
+            {
+                hid_typist_release(&typist);
+                got = hid_text_stream_take(&stroke, HID_TEXT_STREAM_TIMEOUT_MS);
+            }
+            if (!got)
+            {
+                s_stream.aborted = true;
+                break;
+            }
+
+            // Deadlines that passed while the ring was empty would otherwise go out as a burst
+            const int64_t now_us = esp_timer_get_time() - typist.pacer.start_us - typist.pacer.stalled_us;
+            if (typist.next_us < now_us)
+            {
+                typist.next_us = now_us;
+            }
+        }
+
+        if (stroke.usage == 0)
+        {
+            break;
+        }
+        hid_typist_stroke(&typist, &stroke);
+        typist.stats.chars++;
+    }
+
+    if (s_stream.aborted)
+    {
+        ESP_LOGW(TAG, "Text stream stopped after %u chars", (unsigned)typist.stats.chars);
+    }
+
+    hid_typist_finish(&typist, timing);
+    if (out)
+    {
+        *out = typist.stats;
+    }
+    hid_text_stream_release();
+}
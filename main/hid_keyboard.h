@@ -0,0 +1,167 @@
+/*
+ * Text typing over the keyboard report: UTF-8 is mapped to US-layout key strokes and
+ * typed with rollover, one new key per report, so a character costs one report instead
+ * of a press and a release.
+ */
+
+#ifndef HID_KEYBOARD_H
+#define HID_KEYBOARD_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "esp_err.h"
+
+#include "esp_hidd_prf_api.h"
+#include "hid_pacer.h"
+#include "hid_report_schema.h"
+
+#define HID_TEXT_SLOTS 2                 // Texts uploaded or queued at once
+#define HID_TEXT_MAX_BYTES 2048          // UTF-8 size of one text
+#define HID_KEYBOARD_INTERVAL_MS 15      // Report spacing until the connection interval is known
+#define HID_TEXT_STREAM_DEPTH 128        // Key strokes buffered between a streamed body and the typist
+#define HID_TEXT_STREAM_HOLD_MS 200      // Underrun kept with keys held, below the host's auto-repeat delay
+#define HID_TEXT_STREAM_TIMEOUT_MS 10000 // Typist waiting longer for input gives up
+#define HID_TEXT_STREAM_WRITE_MS 1000    // Writer waiting longer for room gives up; it blocks the HTTP server
+
+/// One key press: usage ID on the keyboard page plus the modifier byte it needs
+typedef struct {
+    uint8_t usage;
+    uint8_t modifiers;
+} hid_key_stroke_t;
+
+/// Incremental UTF-8 decoder state
+typedef struct {
+    uint32_t cp;
+    uint8_t need;                                 /*!< Continuation bytes still expected */
+    uint32_t errors;                              /*!< Invalid or truncated sequences skipped */
+} hid_utf8_t;
+
+typedef struct {
+    uint32_t chars;                               /*!< Characters typed */
+    uint32_t unsupported;                         /*!< Characters without a US-layout key, or invalid UTF-8, skipped */
+    uint32_t reports;                             /*!< Keyboard reports sent per host */
+} hid_text_stats_t;
+
+/// Typing state of one text: the keys currently held and the report timeline
+typedef struct {
+    uint16_t conn_ids[HID_MAX_LINKS];
+    uint8_t host_count;
+    hid_pacer_t pacer;
+    uint32_t interval_us;
+    int64_t next_us;                              /*!< Offset of the next report */
+    uint8_t modifiers;
+    uint8_t keys[HID_KEYBOARD_KEY_SLOTS];         /*!< Held keys, oldest first */
+    uint8_t count;
+    hid_utf8_t utf8;
+    hid_text_stats_t stats;
+} hid_typist_t;
+
+/**
+ * @brief Key stroke of a code point on the US layout. '\n' is Return, '\t' Tab; '\r' has no
+ *        stroke so CR LF types one Return.
+ */
+bool hid_keyboard_map_char(uint32_t cp, hid_key_stroke_t *out);
+
+/**
+ * @brief Feed one byte of UTF-8.
+ *
+ * @return true with *cp set when the byte completes a code point. Invalid sequences are
+ *         skipped and counted in errors.
+ */
+bool hid_utf8_feed(hid_utf8_t *dec, uint8_t byte, uint32_t *cp);
+
+/**
+ * @brief Start typing to the given hosts, one report every interval_us.
+ */
+void hid_typist_begin(hid_typist_t *typist, const uint16_t *conn_ids, uint8_t host_count, uint32_t interval_us);
+
+/**
+ * @brief Type len bytes of UTF-8. A sequence split across calls is completed by the next one.
+ *
+ * Each character adds its key to the held set in a new report, dropping the oldest key once
+ * all HID_KEYBOARD_KEY_SLOTS are held. A release report is only inserted when the key is
+ * already held; a modifier change replaces the held keys with the new one.
+ */
+void hid_typist_feed(hid_typist_t *typist, const uint8_t *utf8, size_t len);
+
+/**
+ * @brief Release every held key. Call at the end, and before any pause long enough for the
+ *        host to start auto-repeat.
+ */
+void hid_typist_release(hid_typist_t *typist);
+
+void hid_typist_finish(hid_typist_t *typist, hid_pacer_stats_t *out);
+
+/**
+ * @brief Take a free slot to upload a text into.
+ *
+ * @return Slot index, or -1 when every slot is in use
+ */
+int hid_text_acquire(void);
+
+/**
+ * @brief Buffer to receive up to HID_TEXT_MAX_BYTES of UTF-8 into.
+ */
+uint8_t *hid_text_buffer(int slot);
+
+/**
+ * @brief Mark the len bytes written to the slot ready to type, counting what will be typed.
+ *
+ * @return ESP_OK, or ESP_ERR_INVALID_ARG for an empty or oversized text
+ */
+esp_err_t hid_text_commit(int slot, size_t len, hid_text_stats_t *out);
+
+void hid_text_release(int slot);
+
+/**
+ * @brief Type a committed text to the given hosts.
+ */
+void hid_text_type(const uint16_t *conn_ids, uint8_t host_count, int slot, uint32_t interval_us,
+                   hid_pacer_stats_t *timing, hid_text_stats_t *out);
+
+/*
+ * Streaming: the HTTP handler decodes the body chunk by chunk into a bounded ring of key
+ * strokes while a job types from the other end, so typing starts with the first chunk and
+ * memory does not grow with the text. A full ring blocks the writer, which stops reading the
+ * socket and lets TCP flow control slow the client down to the typing rate.
+ */
+
+/**
+ * @brief Claim the stream for one writer and one typist.
+ *
+ * @return ESP_OK, or ESP_ERR_INVALID_STATE while another stream is still open
+ */
+esp_err_t hid_text_stream_open(void);
+
+/**
+ * @brief Decode len bytes of UTF-8 into the ring, blocking while it is full. A sequence split
+ *        across calls is completed by the next one. The writer runs on the HTTP server task, so
+ *        a stroke waits at most HID_TEXT_STREAM_WRITE_MS for room, many typing intervals.
+ *
+ * @return ESP_OK, or ESP_ERR_TIMEOUT when the typist stopped taking strokes or has not started
+ *         within that time, e.g. behind a long job; the stream is aborted then
+ */
+esp_err_t hid_text_stream_write(hid_utf8_t *dec, const uint8_t *utf8, size_t len, hid_text_stats_t *stats);
+
+/**
+ * @brief Writer side is done: mark the end of the text, or abort the stream when the body could
+ *        not be read completely.
+ */
+void hid_text_stream_close(hid_utf8_t *dec, hid_text_stats_t *stats, bool complete);
+
+/**
+ * @brief Drop one side's hold on the stream. The typist calls it when it returns; call it for
+ *        the typist when its job could not be queued.
+ */
+void hid_text_stream_release(void);
+
+/**
+ * @brief Type from the ring until the end of the text. Held keys are released when the ring
+ *        stays empty for HID_TEXT_STREAM_HOLD_MS; the stream is aborted after
+ *        HID_TEXT_STREAM_TIMEOUT_MS without input.
+ */
+void hid_text_stream_type(const uint16_t *conn_ids, uint8_t host_count, uint32_t interval_us,
+                          hid_pacer_stats_t *timing, hid_text_stats_t *out);
+
+#endif /* HID_KEYBOARD_H */
@@ -0,0 +1,457 @@
+/*
+ * Connection-parameter manager implementation.
+ *
+ * Hosts usually settle on 30-50 ms intervals when left alone, which quantizes every report,
+ * while a 7.5-15 ms interval kept up forever costs the host radio time for nothing.
+ */
+
+#include "hid_link.h"
+
+#include <string.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+#include "esp_log.h"
+#include "esp_timer.h"
+
+// Active: as short as hosts allow, no skipped events
+#define HID_LINK_ACTIVE_MIN_INT 0x0006  // 7.5 ms
+#define HID_LINK_ACTIVE_MAX_INT 0x000C  // 15 ms
+#define HID_LINK_ACTIVE_LATENCY 0
+#define HID_LINK_ACTIVE_TIMEOUT 400     // 4 s
+
+// Idle: long interval and slave latency; the timeout must exceed (1 + latency) * max_int * 2
+#define HID_LINK_IDLE_MIN_INT 0x0018    // 30 ms
+#define HID_LINK_IDLE_MAX_INT 0x0028    // 50 ms
+#define HID_LINK_IDLE_LATENCY 10
+#define HID_LINK_IDLE_TIMEOUT 600       // 6 s
+
+#define HID_LINK_RETRY_MS 5000          // After an answer, how long before a profile the host refused or left is asked again
+
+static const char *TAG = "HID_LINK";
+
+typedef struct {
+    bool in_use;
+    bool secured;
+    uint8_t busy;                                 /*!< Activities in progress: executor jobs and live sessions */
+    bool update_pending;                          /*!< Profile requested, the host has not answered yet */
+    uint16_t conn_id;
+    esp_bd_addr_t remote_bda;
+    const void *touch_owner;                      /*!< Sender whose stroke holds the touch report, NULL when free */
+    int64_t idle_since_us;                        /*!< End of the last activity */
+    int64_t retry_at_us;                          /*!< Earliest time to ask the host again after it answered */
+    hid_link_params_t params;
+} hid_link_t;
+
+static portMUX_TYPE s_link_lock = portMUX_INITIALIZER_UNLOCKED;
+static esp_timer_handle_t s_idle_timer;
+static hid_link_t s_links[HID_MAX_LINKS];
+
+// Callers hold s_link_lock
+static hid_link_t *hid_link_find(uint16_t conn_id)
+{
+    for (int i = 0; i < HID_MAX_LINKS; i++)
+    {
+        if (s_links[i].in_use && s_links[i].conn_id == conn_id)
+        {
+            return &s_links[i];
+        }
+    }
+    return NULL;
+}
+
+static hid_link_t *hid_link_find_bda(const esp_bd_addr_t remote_bda)
+{
+    for (int i = 0; i < HID_MAX_LINKS; i++)
+    {
+        if (s_links[i].in_use && memcmp(s_links[i].remote_bda, remote_bda, sizeof(esp_bd_addr_t)) == 0)
+        {
+            return &s_links[i];
+        }
+    }
+    return NULL;
+}
+
+// Callers hold s_link_lock. A profile counts as applied while its request is unanswered, then only
+// while the interval in use is within its bounds: the host may have granted something else, or
+// moved the link later on its own, as iOS does to 30 ms
+static bool hid_link_in_profile(const hid_link_t *link, hid_link_profile_t profile)
+{
+    if (link->params.requested != profile)
+    {
+        return false;
+    }
+    if (link->update_pending)
+    {
+        return true;
+    }
+
+    const uint16_t interval = link->params.interval;
+    if (profile == HID_LINK_PROFILE_ACTIVE)
+    {
+        return interval >= HID_LINK_ACTIVE_MIN_INT && interval <= HID_LINK_ACTIVE_MAX_INT;
+    }
+    return interval >= HID_LINK_IDLE_MIN_INT && interval <= HID_LINK_IDLE_MAX_INT;
+}
+
+static void hid_link_request(uint16_t conn_id, hid_link_profile_t profile)
+{
+    esp_ble_conn_update_params_t conn = { 0 };
+
+    taskENTER_CRITICAL(&s_link_lock);
+    hid_link_t *link = hid_link_find(conn_id);
+    const bool allowed = link && link->secured && !hid_link_in_profile(link, profile);
+    if (allowed)
+    {
+        link->params.requested = profile;
+        link->update_pending = true;
+        memcpy(conn.bda, link->remote_bda, sizeof(esp_bd_addr_t));
+    }
+    taskEXIT_CRITICAL(&s_link_lock);
+
+    if (!allowed)
+    {
+        return;
+    }
+
+    if (profile == HID_LINK_PROFILE_ACTIVE)
+    {
+        conn.min_int = HID_LINK_ACTIVE_MIN_INT;
+        conn.max_int = HID_LINK_ACTIVE_MAX_INT;
+        conn.latency = HID_LINK_ACTIVE_LATENCY;
+        conn.timeout = HID_LINK_ACTIVE_TIMEOUT;
+    }
+    else
+    {
+        conn.min_int = HID_LINK_IDLE_MIN_INT;
+        conn.max_int = HID_LINK_IDLE_MAX_INT;
+        conn.latency = HID_LINK_IDLE_LATENCY;
+        conn.timeout = HID_LINK_IDLE_TIMEOUT;
+    }
+
+    esp_err_t err = esp_ble_gap_update_conn_params(&conn);
+    if (err != ESP_OK)
+    {
+        ESP_LOGW(TAG, "Failed to request %s profile on conn %u: %s", hid_link_profile_name(profile), conn_id,
+                 esp_err_to_name(err));
+
+        taskENTER_CRITICAL(&s_link_lock);
+        link = hid_link_find(conn_id);
+        if (link)
+        {
+            link->params.requested = HID_LINK_PROFILE_NONE;
+            link->update_pending = false;
+        }
+        taskEXIT_CRITICAL(&s_link_lock);
+    }
+}
+
+/*
+ * One timer serves every link: it fires for the earliest link due and re-arms for the rest. An
+ * idle link is due to relax HID_LINK_IDLE_MS after its last activity. A busy link the host refused
+ * the active profile, or moved off it, is due to ask again, so a long live session still gets it.
+ */
+static void hid_link_idle_cb(void *arg)
+{
+    const int64_t idle_us = (int64_t)HID_LINK_IDLE_MS * 1000;
+    const int64_t now = esp_timer_get_time();
+    uint16_t due[HID_MAX_LINKS];
+    hid_link_profile_t due_profile[HID_MAX_LINKS];
+    int due_count = 0;
+    int64_t next_us = -1;
+
+    taskENTER_CRITICAL(&s_link_lock);
+    for (int i = 0; i < HID_MAX_LINKS; i++)
+    {
+        const hid_link_t *link = &s_links[i];
+        const hid_link_profile_t profile = link->busy ? HID_LINK_PROFILE_ACTIVE : HID_LINK_PROFILE_IDLE;
+        if (!link->in_use || !link->secured || link->update_pending || hid_link_in_profile(link, profile))
+        {
+            continue;
+        }
+
+        int64_t due_us = link->retry_at_us;
+        if (!link->busy && link->idle_since_us + idle_us > due_us)
+        {
+            due_us = link->idle_since_us + idle_us;
+        }
+        const int64_t remaining = due_us - now;
+        if (remaining <= 0)
+        {
+            due[due_count] = link->conn_id;
+            due_profile[due_count++] = profile;
+        }
+        else if (next_us < 0 || remaining < next_us)
+        {
+            next_us = remaining;
+        }
+    }
+    taskEXIT_CRITICAL(&s_link_lock);
+
+    for (int i = 0; i < due_count; i++)
+    {
+        hid_link_request(due[i], due_profile[i]);
+    }
+
+    if (next_us > 0 && s_idle_timer)
+    {
+        esp_timer_stop(s_idle_timer);
+        esp_timer_start_once(s_idle_timer, (uint64_t)next_us);
+    }
+}
+
+esp_err_t hid_link_init(void)
+{
+    if (s_idle_timer)
+    {
+        return ESP_OK;
+    }
+
+    const esp_timer_create_args_t args = {
+        .callback = hid_link_idle_cb,
+        .arg = NULL,
+        .dispatch_method = ESP_TIMER_TASK,
+        .name = "hid_link_idle",
+    };
+    esp_err_t err = esp_timer_create(&args, &s_idle_timer);
+    if (err != ESP_OK)
+    {
+        ESP_LOGE(TAG, "Failed to create idle timer: %s", esp_err_to_name(err));
+    }
+    return err;
+}
+
+void hid_link_on_connect(uint16_t conn_id, const esp_bd_addr_t remote_bda)
+{
+    taskENTER_CRITICAL(&s_link_lock);
+    hid_link_t *link = hid_link_find(conn_id);
+    for (int i = 0; !link && i < HID_MAX_LINKS; i++)
+    {
+        if (!s_links[i].in_use)
+        {
+            link = &s_links[i];
+        }
+    }
+    if (link)
+    {
+        memset(link, 0, sizeof(*link));
+        link->in_use = true;
+        link->conn_id = conn_id;
+        memcpy(link->remote_bda, remote_bda, sizeof(esp_bd_addr_t));
+        link->idle_since_us = esp_timer_get_time();
+    }
+    taskEXIT_CRITICAL(&s_link_lock);
+
+    if (!link)
+    {
+        ESP_LOGW(TAG, "No free link slot for conn %u", conn_id);
+    }
+}
+
+void hid_link_on_disconnect(uint16_t conn_id)
+{
+    taskENTER_CRITICAL(&s_link_lock);
+    hid_link_t *link = hid_link_find(conn_id);
+    if (link)
+    {
+        memset(link, 0, sizeof(*link));
+    }
+    taskEXIT_CRITICAL(&s_link_lock);
+}
+
+void hid_link_on_secured(const esp_bd_addr_t remote_bda)
+{
+    uint16_t conn_id = 0;
+    bool busy = false;
+
+    taskENTER_CRITICAL(&s_link_lock);
+    hid_link_t *link = hid_link_find_bda(remote_bda);
+    if (link)
+    {
+        link->secured = true;
+        conn_id = link->conn_id;
+        busy = link->busy > 0;
+    }
+    taskEXIT_CRITICAL(&s_link_lock);
+
+    if (link)
+    {
+        hid_link_request(conn_id, busy ? HID_LINK_PROFILE_ACTIVE : HID_LINK_PROFILE_IDLE);
+    }
+}
+
+void hid_link_on_conn_params(const esp_ble_gap_cb_param_t *param)
+{
+    taskENTER_CRITICAL(&s_link_lock);
+    hid_link_t *link = hid_link_find_bda(param->update_conn_params.bda);
+    if (link)
+    {
+        link->params.last_status = param->update_conn_params.status;
+        if (param->update_conn_params.status == ESP_BT_STATUS_SUCCESS)
+        {
+            link->params.interval = param->update_conn_params.conn_int;
+            link->params.latency = param->update_conn_params.latency;
+            link->params.timeout = param->update_conn_params.timeout;
+        }
+        else
+        {
+            link->params.requested = HID_LINK_PROFILE_NONE; // Rejected: the next activity change asks again
+        }
+        link->params.updates++;
+        link->update_pending = false;
+        link->retry_at_us = esp_timer_get_time() + (int64_t)HID_LINK_RETRY_MS * 1000;
+    }
+    taskEXIT_CRITICAL(&s_link_lock);
+
+    if (link)
+    {
+        hid_link_idle_cb(NULL); // Arms a retry when the answer left the link outside the profile it needs
+    }
+
+    ESP_LOGI(TAG, "conn params " ESP_BD_ADDR_STR ": status %d, interval %u (x1.25 ms), latency %u, timeout %u (x10 ms)",
+             ESP_BD_ADDR_HEX(param->update_conn_params.bda), param->update_conn_params.status,
+             param->update_conn_params.conn_int, param->update_conn_params.latency,
+             param->update_conn_params.timeout);
+}
+
+uint8_t hid_link_hosts(uint16_t conn_id, uint16_t *conn_ids)
+{
+    uint8_t count = 0;
+
+    taskENTER_CRITICAL(&s_link_lock);
+    for (int i = 0; i < HID_MAX_LINKS; i++)
+    {
+        if (s_links[i].in_use && (conn_id == HID_LINK_ALL || s_links[i].conn_id == conn_id))
+        {
+            conn_ids[count++] = s_links[i].conn_id;
+        }
+    }
+    taskEXIT_CRITICAL(&s_link_lock);
+    return count;
+}
+
+void hid_link_set_busy(uint16_t conn_id, bool busy)
+{
+    uint16_t conn_ids[HID_MAX_LINKS];
+    const int64_t now = esp_timer_get_time();
+
+    taskENTER_CRITICAL(&s_link_lock);
+    uint8_t count = 0;
+    for (int i = 0; i < HID_MAX_LINKS; i++)
+    {
+        hid_link_t *link = &s_links[i];
+        if (link->in_use && (conn_id == HID_LINK_ALL || link->conn_id == conn_id))
+        {
+            if (busy)
+            {
+                link->busy++;
+            }
+            else if (link->busy > 0 && --link->busy == 0)
+            {
+                link->idle_since_us = now;
+            }
+            conn_ids[count++] = link->conn_id;
+        }
+    }
+    taskEXIT_CRITICAL(&s_link_lock);
+
+    if (count == 0)
+    {
+        return;
+    }
+
+    if (busy)
+    {
+        for (uint8_t i = 0; i < count; i++)
+        {
+            hid_link_request(conn_ids[i], HID_LINK_PROFILE_ACTIVE);
+        }
+    }
+    else
+    {
+        // Re-evaluates every link, so a later end never postpones an earlier one
+        hid_link_idle_cb(NULL);
+    }
+}
+
+bool hid_link_touch_take(uint16_t conn_id, const void *owner)
+{
+    taskENTER_CRITICAL(&s_link_lock);
+    hid_link_t *link = hid_link_find(conn_id);
+    const bool taken = link && (!link->touch_owner || link->touch_owner == owner);
+    if (taken)
+    {
+        link->touch_owner = owner;
+    }
+    taskEXIT_CRITICAL(&s_link_lock);
+    return taken;
+}
+
+void hid_link_touch_give(uint16_t conn_id, const void *owner)
+{
+    taskENTER_CRITICAL(&s_link_lock);
+    hid_link_t *link = hid_link_find(conn_id);
+    if (link && link->touch_owner == owner)
+    {
+        link->touch_owner = NULL;
+    }
+    taskEXIT_CRITICAL(&s_link_lock);
+}
+
+esp_err_t hid_link_get_params(uint16_t conn_id, hid_link_params_t *out)
+{
+    if (!out)
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    esp_err_t err = ESP_ERR_NOT_FOUND;
+    taskENTER_CRITICAL(&s_link_lock);
+    const hid_link_t *link = hid_link_find(conn_id);
+    if (link)
+    {
+        *out = link->params;
+        err = ESP_OK;
+    }
+    taskEXIT_CRITICAL(&s_link_lock);
+    return err;
+}
+
+uint32_t hid_link_interval_us(uint16_t conn_id)
+{
+    uint16_t interval = 0;
+
+    taskENTER_CRITICAL(&s_link_lock);
+    for (int i = 0; i < HID_MAX_LINKS; i++)
+    {
+        const hid_link_t *link = &s_links[i];
+        if (!link->in_use || (conn_id != HID_LINK_ALL && link->conn_id != conn_id))
+        {
+            continue;
+        }
+
+        // Right after hid_link_set_busy() the link is usually still on the idle interval, and an
+        // update takes at least 6 connection events to apply: moves planned for the requested
+        // interval would bunch up in the slow events until then and be coalesced away
+        if (link->params.interval > interval)
+        {
+            interval = link->params.interval;
+        }
+    }
+    taskEXIT_CRITICAL(&s_link_lock);
+    return (uint32_t)interval * 1250;
+}
+
+const char *hid_link_profile_name(hid_link_profile_t profile)
+{
+    switch (profile)
+    {
+    case HID_LINK_PROFILE_ACTIVE:
+        return "active";
+    case HID_LINK_PROFILE_IDLE:
+        return "idle";
+    default:
+        return "none";
+    }
+}
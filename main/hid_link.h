@@ -0,0 +1,98 @@
+/*
+ * BLE connection-parameter manager: a low-latency profile while actions run and a
+ * high slave-latency profile once the link has been idle for a while, tracked per host.
+ */
+
+#ifndef HID_LINK_H
+#define HID_LINK_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "esp_err.h"
+#include "esp_bt_defs.h"
+#include "esp_gap_ble_api.h"
+#include "esp_hidd_prf_api.h"
+
+#define HID_LINK_IDLE_MS 3000 // Quiet time before relaxing to the idle profile
+#define HID_LINK_ALL 0xFFFF   // conn_id that stands for every connected host
+
+typedef enum {
+    HID_LINK_PROFILE_NONE = 0,                    /*!< Not connected or not yet encrypted */
+    HID_LINK_PROFILE_ACTIVE,
+    HID_LINK_PROFILE_IDLE,
+} hid_link_profile_t;
+
+/// Parameters in use on the link. Interval and timeout are 0 until the first update event.
+typedef struct {
+    hid_link_profile_t requested;                 /*!< Last profile asked for, NONE after the host rejected it */
+    uint16_t interval;                            /*!< Connection interval, 1.25 ms units */
+    uint16_t latency;                             /*!< Slave latency, connection events */
+    uint16_t timeout;                             /*!< Supervision timeout, 10 ms units */
+    int last_status;                              /*!< esp_bt_status_t of the last update event */
+    uint32_t updates;                             /*!< Update events seen on this connection */
+} hid_link_params_t;
+
+esp_err_t hid_link_init(void);
+
+void hid_link_on_connect(uint16_t conn_id, const esp_bd_addr_t remote_bda);
+void hid_link_on_disconnect(uint16_t conn_id);
+
+/**
+ * @brief Encryption is up; parameter updates are only requested from here on, since
+ *        iOS rejects them while the HID encryption is being set up.
+ */
+void hid_link_on_secured(const esp_bd_addr_t remote_bda);
+
+/**
+ * @brief Record the result of ESP_GAP_BLE_UPDATE_CONN_PARAMS_EVT, whichever side asked. When the
+ *        host rejected the profile the link needs, or settled outside its intervals, it is asked
+ *        again a few seconds later.
+ */
+void hid_link_on_conn_params(const esp_ble_gap_cb_param_t *param);
+
+/**
+ * @brief Resolve conn_id, or HID_LINK_ALL, to the connected hosts it names.
+ *
+ * @param[out] conn_ids room for HID_MAX_LINKS entries
+ * @return number of hosts written
+ */
+uint8_t hid_link_hosts(uint16_t conn_id, uint16_t *conn_ids);
+
+/**
+ * @brief Mark the start and end of input activity on one link, or on all with HID_LINK_ALL. Starting requests the active
+ *        profile; the idle profile is requested HID_LINK_IDLE_MS after the last end. Activities are counted, so an
+ *        executor job and a live session can overlap; every start needs one end with the same conn_id.
+ */
+void hid_link_set_busy(uint16_t conn_id, bool busy);
+
+/**
+ * @brief Take the touch report of one host for a stroke. Frames from two senders must not mix:
+ *        a hybrid frame spans several notifications and contact ids are shared, so a host takes
+ *        strokes from one owner at a time. Taking again as the same owner is a no-op.
+ *
+ * @param owner Any pointer identifying the sender, e.g. its session
+ * @return true when the host was free or already held by owner
+ */
+bool hid_link_touch_take(uint16_t conn_id, const void *owner);
+
+/**
+ * @brief Give the touch report back once every contact of the stroke is lifted. Ignored unless
+ *        owner holds it; a disconnect frees it too.
+ */
+void hid_link_touch_give(uint16_t conn_id, const void *owner);
+
+/**
+ * @return ESP_ERR_NOT_FOUND when conn_id is not connected
+ */
+esp_err_t hid_link_get_params(uint16_t conn_id, hid_link_params_t *out);
+
+/**
+ * @brief Connection interval in use on the link in microseconds, 0 while unknown. A requested
+ *        profile only counts once the host has applied it. For HID_LINK_ALL the longest one, so
+ *        no host gets two moves in one connection event.
+ */
+uint32_t hid_link_interval_us(uint16_t conn_id);
+
+const char *hid_link_profile_name(hid_link_profile_t profile);
+
+#endif /* HID_LINK_H */
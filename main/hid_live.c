@@ -0,0 +1,515 @@
+/*
+ * Live input implementation.
+ *
+ * Reports go out on the calling task; the BLE stack queues them, so a record costs a table
+ * update and a notification, with no pacing or planning in between.
+ */
+
+#include "hid_live.h"
+
+#include <string.h>
+
+#include "esp_log.h"
+
+#include "hid_link.h"
+#include "hid_trajectory.h"
+
+#define HID_LIVE_MODIFIER_FIRST 0xE0 // Left Control; the eight modifiers map to the bits of the modifier byte
+#define HID_LIVE_MODIFIER_LAST  0xE7
+
+static const char *TAG = "HID_LIVE";
+
+static uint16_t hid_live_rd16(const uint8_t *p)
+{
+    return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+static uint32_t hid_live_rd32(const uint8_t *p)
+{
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static uint16_t hid_live_coord(uint16_t value)
+{
+    return value > HID_ABS_MAX_COORD ? HID_ABS_MAX_COORD : value;
+}
+
+static uint8_t hid_live_hosts(const hid_live_t *live, uint16_t *conn_ids)
+{
+    if (live->conn_id != HID_LINK_ALL)
+    {
+        conn_ids[0] = live->conn_id;
+        return 1;
+    }
+    return hid_link_hosts(HID_LINK_ALL, conn_ids);
+}
+
+static int hid_live_find_contact(const hid_live_t *live, uint8_t id)
+{
+    for (uint8_t i = 0; i < live->contact_count; ++i)
+    {
+        if (live->contacts[i].id == id)
+        {
+            return i;
+        }
+    }
+    return -1;
+}
+
+/*
+ * Coalescer of one host, keyed by conn_id: positions in hid_link_hosts() shift when a host
+ * connects or disconnects during a session, and another host's last frame would make a move look
+ * like a repeat. Slots of hosts no longer in conn_ids are freed first, so a host that joins starts
+ * from an empty frame.
+ */
+static hid_coalesce_t *hid_live_coalescer(hid_live_t *live, uint16_t conn_id, const uint16_t *conn_ids,
+                                          uint8_t count)
+{
+    int free_slot = -1;
+    for (uint8_t slot = 0; slot < HID_MAX_LINKS; ++slot)
+    {
+        if (live->co_conn_ids[slot] == conn_id)
+        {
+            return &live->co[slot];
+        }
+
+        bool connected = false;
+        for (uint8_t i = 0; i < count && !connected; ++i)
+        {
+            connected = live->co_conn_ids[slot] == conn_ids[i];
+        }
+        if (!connected)
+        {
+            live->co_conn_ids[slot] = HID_LINK_ALL;
+        }
+        if (free_slot < 0 && live->co_conn_ids[slot] == HID_LINK_ALL)
+        {
+            free_slot = slot;
+        }
+    }
+
+    // count <= HID_MAX_LINKS and this host has no slot yet, so one is free
+    live->co_conn_ids[free_slot] = conn_id;
+    hid_coalesce_begin(&live->co[free_slot]);
+    return &live->co[free_slot];
+}
+
+// A host whose touch report another sender holds, e.g. an executor gesture, misses the frame
+static void hid_live_send_touch(hid_live_t *live, bool superseded)
+{
+    uint16_t conn_ids[HID_MAX_LINKS];
+    uint8_t count = hid_live_hosts(live, conn_ids);
+    for (uint8_t i = 0; i < count; ++i)
+    {
+        if (!hid_link_touch_take(conn_ids[i], live))
+        {
+            live->stats.blocked++;
+            continue;
+        }
+        hid_coalesce_t *co = hid_live_coalescer(live, conn_ids[i], conn_ids, count);
+        hid_coalesce_send(co, conn_ids[i], live->contacts, live->contact_count, superseded);
+    }
+    if (!superseded)
+    {
+        live->stats.reports++;
+    }
+
+    // Lifted contacts were reported once and leave the frame
+    uint8_t kept = 0;
+    for (uint8_t i = 0; i < live->contact_count; ++i)
+    {
+        if (live->contacts[i].tip)
+        {
+            live->contacts[kept++] = live->contacts[i];
+        }
+    }
+    live->contact_count = kept;
+
+    if (kept == 0)
+    {
+        for (uint8_t i = 0; i < count; ++i)
+        {
+            hid_link_touch_give(conn_ids[i], live);
+        }
+    }
+}
+
+static void hid_live_send_keyboard(hid_live_t *live)
+{
+    uint16_t conn_ids[HID_MAX_LINKS];
+    uint8_t count = hid_live_hosts(live, conn_ids);
+    for (uint8_t i = 0; i < count; ++i)
+    {
+        esp_hidd_send_keyboard_value(conn_ids[i], live->modifiers, live->keys, live->key_count);
+    }
+    live->stats.reports++;
+}
+
+static void hid_live_send_consumer(hid_live_t *live, uint16_t usage, bool pressed)
+{
+    uint16_t conn_ids[HID_MAX_LINKS];
+    uint8_t count = hid_live_hosts(live, conn_ids);
+    for (uint8_t i = 0; i < count; ++i)
+    {
+        esp_hidd_send_consumer_value(conn_ids[i], usage, pressed);
+    }
+    live->stats.reports++;
+}
+
+static bool hid_live_touch(hid_live_t *live, uint8_t op, uint8_t id, uint16_t x, uint16_t y, bool superseded)
+{
+    if (id >= HID_TOUCH_MAX_CONTACTS)
+    {
+        return false;
+    }
+
+    int index = hid_live_find_contact(live, id);
+    if (op == HID_LIVE_OP_DOWN && index < 0)
+    {
+        if (live->contact_count == HID_TOUCH_MAX_CONTACTS)
+        {
+            return false;
+        }
+        index = live->contact_count++;
+        live->contacts[index].id = id;
+        live->contacts[index].tip = true;
+        superseded = false;
+    }
+    else if (index < 0)
+    {
+        return false; // move or up of a contact that is not down
+    }
+
+    live->contacts[index].x = hid_live_coord(x);
+    live->contacts[index].y = hid_live_coord(y);
+    if (op == HID_LIVE_OP_UP)
+    {
+        live->contacts[index].tip = false;
+        superseded = false;
+    }
+    hid_live_send_touch(live, superseded);
+    return true;
+}
+
+static bool hid_live_key(hid_live_t *live, uint8_t page, uint16_t usage, bool pressed)
+{
+    if (page == HID_LIVE_PAGE_CONSUMER)
+    {
+        if (pressed)
+        {
+            live->consumer = usage;
+        }
+        else if (live->consumer == usage)
+        {
+            live->consumer = 0;
+        }
+        hid_live_send_consumer(live, usage, pressed);
+        return true;
+    }
+    if (page != HID_LIVE_PAGE_KEYBOARD || usage == 0 || usage > 0xFF)
+    {
+        return false;
+    }
+
+    if (usage >= HID_LIVE_MODIFIER_FIRST && usage <= HID_LIVE_MODIFIER_LAST)
+    {
+        const uint8_t bit = (uint8_t)(1 << (usage - HID_LIVE_MODIFIER_FIRST));
+        live->modifiers = pressed ? (live->modifiers | bit) : (live->modifiers & ~bit);
+        hid_live_send_keyboard(live);
+        return true;
+    }
+
+    uint8_t index = 0;
+    while (index < live->key_count && live->keys[index] != usage)
+    {
+        ++index;
+    }
+
+    if (pressed && index == live->key_count)
+    {
+        if (live->key_count == HID_KEYBOARD_KEY_SLOTS)
+        {
+            return false;
+        }
+        live->keys[live->key_count++] = (uint8_t)usage;
+    }
+    else if (!pressed && index < live->key_count)
+    {
+        memmove(&live->keys[index], &live->keys[index + 1], live->key_count - index - 1);
+        live->keys[--live->key_count] = 0;
+    }
+    hid_live_send_keyboard(live);
+    return true;
+}
+
+void hid_live_begin(hid_live_t *live, uint16_t conn_id)
+{
+    memset(live, 0, sizeof(*live));
+    live->conn_id = conn_id;
+    for (uint8_t i = 0; i < HID_MAX_LINKS; ++i)
+    {
+        live->co_conn_ids[i] = HID_LINK_ALL;
+        hid_coalesce_begin(&live->co[i]);
+    }
+
+    // The whole session runs on the active connection parameters; releasing them between
+    // strokes would let the link relax after HID_LINK_IDLE_MS of the user resting
+    hid_link_set_busy(conn_id, true);
+    live->busy = true;
+}
+
+esp_err_t hid_live_feed(hid_live_t *live, const uint8_t *data, size_t len)
+{
+    if (len % HID_LIVE_RECORD_LEN != 0)
+    {
+        return ESP_ERR_INVALID_SIZE;
+    }
+
+    for (size_t off = 0; off < len; off += HID_LIVE_RECORD_LEN)
+    {
+        const uint8_t *rec = &data[off];
+        const uint8_t op = rec[0];
+        const uint16_t seq = hid_live_rd16(&rec[2]);
+
+        const int16_t ahead = live->started ? (int16_t)(seq - live->next_seq) : 0;
+        live->started = true;
+        if (ahead < 0)
+        {
+            // Only a move is safe to drop; a late down, up or key still changes what is held
+            if (op == HID_LIVE_OP_MOVE)
+            {
+                live->stats.stale++;
+                continue;
+            }
+        }
+        else
+        {
+            live->stats.gaps += ahead;
+            live->next_seq = seq + 1;
+        }
+
+        // A move is skipped when the next record of the message updates the touch frame again
+        const size_t next = off + HID_LIVE_RECORD_LEN;
+        const bool superseded = next < len && data[next] >= HID_LIVE_OP_DOWN && data[next] <= HID_LIVE_OP_UP;
+
+        bool ok;
+        switch (op)
+        {
+        case HID_LIVE_OP_DOWN:
+        case HID_LIVE_OP_MOVE:
+        case HID_LIVE_OP_UP:
+            ok = hid_live_touch(live, op, rec[1], hid_live_rd16(&rec[4]), hid_live_rd16(&rec[6]), superseded);
+            break;
+        case HID_LIVE_OP_KEY_DOWN:
+        case HID_LIVE_OP_KEY_UP:
+            ok = hid_live_key(live, rec[1], hid_live_rd16(&rec[4]), op == HID_LIVE_OP_KEY_DOWN);
+            break;
+        case HID_LIVE_OP_SYNC:
+            live->sync_pending = true;
+            live->sync_seq = seq;
+            ok = true;
+            break;
+        default:
+            ok = false;
+            break;
+        }
+
+        if (ok)
+        {
+            live->stats.records++;
+        }
+        else
+        {
+            live->stats.rejected++;
+        }
+    }
+
+    return ESP_OK;
+}
+
+bool hid_live_take_sync(hid_live_t *live, uint8_t reply[HID_LIVE_RECORD_LEN])
+{
+    if (!live->sync_pending)
+    {
+        return false;
+    }
+    live->sync_pending = false;
+
+    reply[0] = HID_LIVE_OP_SYNC;
+    reply[1] = 0;
+    reply[2] = (uint8_t)(live->sync_seq & 0xFF);
+    reply[3] = (uint8_t)(live->sync_seq >> 8);
+    reply[4] = (uint8_t)(live->stats.gaps & 0xFF);
+    reply[5] = (uint8_t)((live->stats.gaps >> 8) & 0xFF);
+    reply[6] = (uint8_t)(live->stats.reports & 0xFF);
+    reply[7] = (uint8_t)((live->stats.reports >> 8) & 0xFF);
+    return true;
+}
+
+// Bring the contact table to the client's state and send one frame if anything changed
+static bool hid_live_apply_state(hid_live_t *live, const uint8_t *contacts, uint8_t count)
+{
+    bool changed = false;
+
+    for (uint8_t i = 0; i < live->contact_count; ++i)
+    {
+        bool present = false;
+        for (uint8_t c = 0; c < count && !present; ++c)
+        {
+            present = contacts[c * HID_LIVE_STATE_CONTACT_LEN] == live->contacts[i].id;
+        }
+        if (!present)
+        {
+            live->contacts[i].tip = false;
+            changed = true;
+        }
+    }
+
+    for (uint8_t c = 0; c < count; ++c)
+    {
+        const uint8_t *entry = &contacts[c * HID_LIVE_STATE_CONTACT_LEN];
+        const uint8_t id = entry[0];
+        const bool tip = entry[1] & 0x01;
+        const uint16_t x = hid_live_coord(hid_live_rd16(&entry[2]));
+        const uint16_t y = hid_live_coord(hid_live_rd16(&entry[4]));
+
+        int index = hid_live_find_contact(live, id);
+        if (index < 0)
+        {
+            // A lift of a contact that is not down is a repeat of one already applied
+            if (!tip)
+            {
+                continue;
+            }
+            if (id >= HID_TOUCH_MAX_CONTACTS || live->contact_count == HID_TOUCH_MAX_CONTACTS)
+            {
+                live->stats.rejected++;
+                continue;
+            }
+            index = live->contact_count++;
+            live->contacts[index].id = id;
+            live->contacts[index].tip = true;
+            changed = true;
+        }
+        else if (!live->contacts[index].tip)
+        {
+            continue; // lifted above
+        }
+        else if (!tip)
+        {
+            live->contacts[index].tip = false;
+            changed = true;
+        }
+
+        if (live->contacts[index].x != x || live->contacts[index].y != y)
+        {
+            live->contacts[index].x = x;
+            live->contacts[index].y = y;
+            changed = true;
+        }
+    }
+
+    if (changed)
+    {
+        hid_live_send_touch(live, false);
+    }
+    return changed;
+}
+
+esp_err_t hid_live_feed_state(hid_live_t *live, const uint8_t *data, size_t len, int64_t now_us)
+{
+    if (len < HID_LIVE_STATE_HEADER_LEN)
+    {
+        return ESP_ERR_INVALID_SIZE;
+    }
+    if (data[0] != HID_LIVE_STATE_VERSION)
+    {
+        return ESP_ERR_INVALID_VERSION;
+    }
+    const uint8_t count = data[1];
+    if (count > HID_TOUCH_MAX_CONTACTS || len != HID_LIVE_STATE_HEADER_LEN + count * HID_LIVE_STATE_CONTACT_LEN)
+    {
+        return ESP_ERR_INVALID_SIZE;
+    }
+
+    const uint32_t seq = hid_live_rd32(&data[2]);
+    const int32_t transit = (int32_t)((uint32_t)now_us - hid_live_rd32(&data[6]));
+
+    if (live->started)
+    {
+        const int32_t ahead = (int32_t)(seq - live->state_seq);
+        if (ahead <= 0 && ahead > -HID_LIVE_STATE_RESTART)
+        {
+            // Newest state wins: anything older or repeated has nothing left to say
+            live->stats.late++;
+            return ESP_OK;
+        }
+        if (ahead > 1)
+        {
+            live->stats.gaps += ahead - 1;
+        }
+
+        int32_t d = transit - live->state_transit_us;
+        if (d < 0)
+        {
+            d = -d;
+        }
+        live->stats.jitter_us += ((int32_t)d - (int32_t)live->stats.jitter_us) / 16;
+    }
+    live->started = true;
+    live->state_seq = seq;
+    live->state_transit_us = transit;
+    live->state_rx_us = now_us;
+    live->stats.records++;
+
+    hid_live_apply_state(live, &data[HID_LIVE_STATE_HEADER_LEN], count);
+    return ESP_OK;
+}
+
+void hid_live_poll_state(hid_live_t *live, int64_t now_us)
+{
+    if (live->contact_count > 0 && now_us - live->state_rx_us > HID_LIVE_STATE_HOLD_MS * 1000LL)
+    {
+        ESP_LOGW(TAG, "State client silent for %d ms, lifting %u contacts", HID_LIVE_STATE_HOLD_MS,
+                 live->contact_count);
+        hid_live_release(live);
+    }
+}
+
+void hid_live_release(hid_live_t *live)
+{
+    if (live->contact_count > 0)
+    {
+        for (uint8_t i = 0; i < live->contact_count; ++i)
+        {
+            live->contacts[i].tip = false;
+        }
+        hid_live_send_touch(live, false);
+    }
+    if (live->key_count > 0 || live->modifiers != 0)
+    {
+        memset(live->keys, 0, sizeof(live->keys));
+        live->key_count = 0;
+        live->modifiers = 0;
+        hid_live_send_keyboard(live);
+    }
+    if (live->consumer != 0)
+    {
+        hid_live_send_consumer(live, live->consumer, false);
+        live->consumer = 0;
+    }
+}
+
+void hid_live_end(hid_live_t *live)
+{
+    hid_live_release(live);
+    if (live->busy)
+    {
+        live->busy = false;
+        hid_link_set_busy(live->conn_id, false);
+    }
+
+    ESP_LOGI(TAG, "Live input ended: %u records, %u reports, %u gaps, %u stale, %u rejected, %u blocked",
+             (unsigned)live->stats.records, (unsigned)live->stats.reports, (unsigned)live->stats.gaps,
+             (unsigned)live->stats.stale, (unsigned)live->stats.rejected, (unsigned)live->stats.blocked);
+}
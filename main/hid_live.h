@@ -0,0 +1,144 @@
+/*
+ * Live input: touch and key events streamed by a remote client, sent as reports the moment
+ * they arrive instead of being planned and paced by the executor. A touch stroke holds the
+ * host's touch report from its first down to its last lift (hid_link_touch_take()), so it never
+ * mixes with a planned gesture; frames for a host that is busy with one are dropped and counted.
+ *
+ * Events are fixed 8-byte little-endian records; one transport message may carry several:
+ *
+ *   0  op    HID_LIVE_OP_*
+ *   1  arg   contact id (DOWN/MOVE/UP), usage page 0x07 or 0x0C (KEY_DOWN/KEY_UP)
+ *   2  seq   incremented by the client for every record
+ *   4  a     x in 0..HID_ABS_MAX_COORD, or the usage
+ *   6  b     y in 0..HID_ABS_MAX_COORD
+ *
+ * A SYNC record is answered with a SYNC record echoing its seq, with a = gaps and b = reports
+ * sent so far (both modulo 2^16), so the client can measure round trip and loss.
+ *
+ * Over a lossy transport a client sends state datagrams instead: each one carries every contact
+ * the client has down, so any single datagram that arrives brings the host up to date.
+ *
+ *   0  u8   version, HID_LIVE_STATE_VERSION
+ *   1  u8   count, 0..HID_TOUCH_MAX_CONTACTS
+ *   2  u32  seq, incremented by the client for every datagram
+ *   6  u32  timestamp, client microseconds, only used to measure jitter
+ *  10  count x { u8 id, u8 flags (bit 0 tip), u16 x, u16 y }
+ *
+ * Only a datagram newer than the last one applied is used. A contact missing from the state, or
+ * present with tip clear, is lifted; repeating the final state is therefore harmless and is how
+ * the client makes the lift survive loss. Contacts are also lifted when no datagram arrives for
+ * HID_LIVE_STATE_HOLD_MS, so the client must resend its state while a finger rests.
+ */
+
+#ifndef HID_LIVE_H
+#define HID_LIVE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "esp_err.h"
+
+#include "esp_hidd_prf_api.h"
+#include "hid_coalesce.h"
+#include "hid_report_schema.h"
+
+#define HID_LIVE_RECORD_LEN 8
+
+#define HID_LIVE_STATE_VERSION 1
+#define HID_LIVE_STATE_HEADER_LEN 10
+#define HID_LIVE_STATE_CONTACT_LEN 6
+#define HID_LIVE_STATE_MAX_LEN (HID_LIVE_STATE_HEADER_LEN + HID_TOUCH_MAX_CONTACTS * HID_LIVE_STATE_CONTACT_LEN)
+#define HID_LIVE_STATE_HOLD_MS 300       // Contacts lifted when the client falls silent this long
+#define HID_LIVE_STATE_RESTART 4096      // A seq this far behind is a restarted client, not a late datagram
+
+typedef enum {
+    HID_LIVE_OP_DOWN = 1,
+    HID_LIVE_OP_MOVE = 2,
+    HID_LIVE_OP_UP = 3,
+    HID_LIVE_OP_KEY_DOWN = 4,
+    HID_LIVE_OP_KEY_UP = 5,
+    HID_LIVE_OP_SYNC = 6,
+} hid_live_op_t;
+
+#define HID_LIVE_PAGE_KEYBOARD 0x07
+#define HID_LIVE_PAGE_CONSUMER 0x0C
+
+typedef struct {
+    uint32_t records;                             /*!< Records applied */
+    uint32_t gaps;                                /*!< Sequence numbers skipped by the client */
+    uint32_t stale;                               /*!< Moves older than the last record, dropped */
+    uint32_t rejected;                            /*!< Unknown ops, unknown contacts, full contact or key table */
+    uint32_t reports;                             /*!< Touch, keyboard and consumer reports sent per host */
+    uint32_t late;                                /*!< State datagrams not newer than the last applied */
+    uint32_t blocked;                             /*!< Touch frames a host missed while another sender held it */
+    uint32_t jitter_us;                           /*!< Interarrival jitter of state datagrams (RFC 3550) */
+} hid_live_stats_t;
+
+/// One client's input state
+typedef struct {
+    uint16_t conn_id;                             /*!< A single host or HID_LINK_ALL */
+    bool started;                                 /*!< A record was seen, next_seq is valid */
+    uint16_t next_seq;
+    esp_hidd_touch_contact_t contacts[HID_TOUCH_MAX_CONTACTS]; /*!< Contacts down, in order of arrival */
+    uint8_t contact_count;
+    hid_coalesce_t co[HID_MAX_LINKS];             /*!< Per host, for the conn_id in the same slot of co_conn_ids */
+    uint16_t co_conn_ids[HID_MAX_LINKS];          /*!< HID_LINK_ALL for a free slot */
+    uint8_t modifiers;
+    uint8_t keys[HID_KEYBOARD_KEY_SLOTS];
+    uint8_t key_count;
+    uint16_t consumer;                            /*!< Consumer usage held, 0 for none */
+    bool busy;                                    /*!< Holding the link on its active connection parameters, begin to end */
+    bool sync_pending;
+    uint16_t sync_seq;
+    uint32_t state_seq;                           /*!< Last state datagram applied */
+    int32_t state_transit_us;                     /*!< Its arrival minus its timestamp */
+    int64_t state_rx_us;                          /*!< When it arrived */
+    hid_live_stats_t stats;
+} hid_live_t;
+
+/**
+ * @brief Start a session. The link stays on its active connection parameters until hid_live_end().
+ */
+void hid_live_begin(hid_live_t *live, uint16_t conn_id);
+
+/**
+ * @brief Apply the records of one message in order. Moves that are followed by another
+ *        record of the same message are coalesced; downs, ups and keys are always sent.
+ *
+ * @return ESP_OK, or ESP_ERR_INVALID_SIZE when len is not a multiple of HID_LIVE_RECORD_LEN
+ *         (nothing is applied then)
+ */
+esp_err_t hid_live_feed(hid_live_t *live, const uint8_t *data, size_t len);
+
+/**
+ * @brief Reply to the last SYNC record fed, if any is still unanswered.
+ *
+ * @return true with reply filled in
+ */
+bool hid_live_take_sync(hid_live_t *live, uint8_t reply[HID_LIVE_RECORD_LEN]);
+
+/**
+ * @brief Apply one state datagram received at now_us, see above.
+ *
+ * @return ESP_OK (a late datagram is counted and dropped), or ESP_ERR_INVALID_SIZE /
+ *         ESP_ERR_INVALID_VERSION for a malformed one
+ */
+esp_err_t hid_live_feed_state(hid_live_t *live, const uint8_t *data, size_t len, int64_t now_us);
+
+/**
+ * @brief Lift the contacts of a state client that stopped sending. Call periodically.
+ */
+void hid_live_poll_state(hid_live_t *live, int64_t now_us);
+
+/**
+ * @brief Lift every contact and release every key.
+ */
+void hid_live_release(hid_live_t *live);
+
+/**
+ * @brief hid_live_release(), hand the link back to the idle timer and log the session totals,
+ *        e.g. when the client goes away.
+ */
+void hid_live_end(hid_live_t *live);
+
+#endif /* HID_LIVE_H */
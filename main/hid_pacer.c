@@ -0,0 +1,175 @@
+/*
+ * Report pacing implementation.
+ *
+ * vTaskDelay can only sleep whole ticks (10 ms at CONFIG_FREERTOS_HZ=100), so waits are
+ * armed on a one-shot esp_timer that notifies the sleeping task; the last few microseconds
+ * are spun on esp_timer_get_time().
+ */
+
+#include "hid_pacer.h"
+
+#include <string.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "freertos/task.h"
+
+#include "esp_log.h"
+#include "esp_timer.h"
+
+#define HID_PACER_SPIN_US 50 // Below this, arming the timer costs more than spinning
+
+static const char *TAG = "HID_PACER";
+
+static esp_timer_handle_t s_wake_timer;
+static SemaphoreHandle_t s_wait_lock;
+static TaskHandle_t s_waiter;
+
+static void hid_pacer_timer_cb(void *arg)
+{
+    TaskHandle_t waiter = s_waiter;
+    if (waiter)
+    {
+        xTaskNotifyGive(waiter);
+    }
+}
+
+esp_err_t hid_pacer_init(void)
+{
+    if (s_wake_timer)
+    {
+        return ESP_OK;
+    }
+
+    s_wait_lock = xSemaphoreCreateMutex();
+    if (!s_wait_lock)
+    {
+        return ESP_ERR_NO_MEM;
+    }
+
+    const esp_timer_create_args_t args = {
+        .callback = hid_pacer_timer_cb,
+        .arg = NULL,
+        .dispatch_method = ESP_TIMER_TASK,
+        .name = "hid_pacer",
+    };
+    esp_err_t err = esp_timer_create(&args, &s_wake_timer);
+    if (err != ESP_OK)
+    {
+        ESP_LOGE(TAG, "Failed to create pacing timer: %s", esp_err_to_name(err));
+    }
+    return err;
+}
+
+void hid_pacer_begin(hid_pacer_t *pacer)
+{
+    memset(pacer, 0, sizeof(*pacer));
+    pacer->start_us = esp_timer_get_time();
+    pacer->last_actual_us = pacer->start_us;
+}
+
+static void hid_pacer_sleep_until(int64_t deadline_us)
+{
+    int64_t remaining = deadline_us - esp_timer_get_time();
+    if (remaining <= HID_PACER_SPIN_US)
+    {
+        return;
+    }
+
+    if (!s_wake_timer)
+    {
+        // Not initialised: fall back to tick sleep, still against the absolute deadline
+        vTaskDelay(pdMS_TO_TICKS(remaining / 1000));
+        return;
+    }
+
+    xSemaphoreTake(s_wait_lock, portMAX_DELAY);
+    s_waiter = xTaskGetCurrentTaskHandle();
+    while (remaining > HID_PACER_SPIN_US)
+    {
+        ulTaskNotifyTake(pdTRUE, 0); // drop a stale wake-up from an earlier wait
+        esp_timer_start_once(s_wake_timer, (uint64_t)(remaining - HID_PACER_SPIN_US));
+        // The tick timeout is only a safety net in case the timer notification is lost
+        ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(remaining / 1000) + 2);
+        esp_timer_stop(s_wake_timer);
+        remaining = deadline_us - esp_timer_get_time();
+    }
+    s_waiter = NULL;
+    xSemaphoreGive(s_wait_lock);
+}
+
+void hid_pacer_wait_until(hid_pacer_t *pacer, int64_t offset_us)
+{
+    int64_t deadline_us = pacer->start_us + pacer->stalled_us + offset_us;
+
+    hid_pacer_sleep_until(deadline_us);
+
+    int64_t now = esp_timer_get_time();
+    while (now < deadline_us)
+    {
+        now = esp_timer_get_time();
+    }
+
+    int64_t late = now - deadline_us;
+    if (late > INT32_MAX)
+    {
+        late = INT32_MAX;
+    }
+    if ((int32_t)late > pacer->max_late_us)
+    {
+        pacer->max_late_us = (int32_t)late;
+    }
+    pacer->total_late_us += late;
+    pacer->waits++;
+    pacer->last_planned_us = offset_us;
+    pacer->last_actual_us = now;
+}
+
+void hid_pacer_sent(hid_pacer_t *pacer)
+{
+    int64_t blocked = esp_timer_get_time() - pacer->last_actual_us;
+    if (blocked > HID_PACER_STALL_US)
+    {
+        pacer->stalled_us += blocked;
+        if (pacer->stalled_us > HID_PACER_MAX_STALL_US)
+        {
+            pacer->stalled_us = HID_PACER_MAX_STALL_US;
+        }
+    }
+}
+
+void hid_pacer_skew(hid_pacer_t *pacer, int64_t skew_us)
+{
+    if (skew_us > INT32_MAX)
+    {
+        skew_us = INT32_MAX;
+    }
+    if ((int32_t)skew_us > pacer->max_skew_us)
+    {
+        pacer->max_skew_us = (int32_t)skew_us;
+    }
+    pacer->total_skew_us += skew_us;
+    pacer->skews++;
+}
+
+bool hid_pacer_due(const hid_pacer_t *pacer, int64_t offset_us)
+{
+    return esp_timer_get_time() >= pacer->start_us + pacer->stalled_us + offset_us;
+}
+
+void hid_pacer_finish(const hid_pacer_t *pacer, hid_pacer_stats_t *out)
+{
+    if (!out)
+    {
+        return;
+    }
+
+    out->samples = pacer->waits;
+    out->planned_us = pacer->last_planned_us;
+    out->actual_us = pacer->last_actual_us - pacer->start_us;
+    out->max_late_us = pacer->max_late_us;
+    out->avg_late_us = pacer->waits ? (int32_t)(pacer->total_late_us / pacer->waits) : 0;
+    out->stalled_us = pacer->stalled_us;
+    out->max_skew_us = pacer->max_skew_us;
+    out->avg_skew_us = pacer->skews ? (int32_t)(pacer->total_skew_us / pacer->skews) : 0;
+}
@@ -0,0 +1,74 @@
+/*
+ * Report pacing on absolute esp_timer deadlines, independent of the FreeRTOS tick.
+ */
+
+#ifndef HID_PACER_H
+#define HID_PACER_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "esp_err.h"
+
+#define HID_PACER_STALL_US 2000      // A send blocking longer than this was waiting for the link
+#define HID_PACER_MAX_STALL_US 48000 // Most a gesture is pushed back; past it the player coalesces to catch up
+
+/// Timeline of one gesture; every deadline is an offset from begin, so send overhead never accumulates
+typedef struct {
+    int64_t start_us;
+    int64_t stalled_us;        /*!< Added to every deadline, see hid_pacer_sent() */
+    int64_t last_planned_us;
+    int64_t last_actual_us;
+    int64_t total_late_us;
+    int32_t max_late_us;
+    uint32_t waits;
+    int64_t total_skew_us;
+    int32_t max_skew_us;
+    uint32_t skews;
+} hid_pacer_t;
+
+/// Planned-vs-actual timing of a finished gesture
+typedef struct {
+    uint32_t samples;          /*!< Number of paced deadlines */
+    int64_t planned_us;        /*!< Offset of the last deadline */
+    int64_t actual_us;         /*!< Time from begin until the last deadline was released */
+    int32_t max_late_us;       /*!< Worst wake-up lateness over all deadlines */
+    int32_t avg_late_us;       /*!< Mean wake-up lateness */
+    int64_t stalled_us;        /*!< Time the deadlines were pushed back by a busy link */
+    int32_t max_skew_us;       /*!< Worst spread between hosts sent the same deadline, 0 for one host */
+    int32_t avg_skew_us;
+} hid_pacer_stats_t;
+
+/**
+ * @brief Create the one-shot wake-up timer. Safe to call more than once.
+ */
+esp_err_t hid_pacer_init(void);
+
+void hid_pacer_begin(hid_pacer_t *pacer);
+
+/**
+ * @brief Block until begin + offset_us. Returns immediately if that time has already passed.
+ */
+void hid_pacer_wait_until(hid_pacer_t *pacer, int64_t offset_us);
+
+/**
+ * @brief Call right after sending the report of the last deadline. If the send blocked on a
+ *        busy link for more than HID_PACER_STALL_US, every later deadline moves back by that
+ *        time, so the gesture keeps its spacing instead of bursting into a congested link.
+ *        The total push-back is capped at HID_PACER_MAX_STALL_US to bound the lag.
+ */
+void hid_pacer_sent(hid_pacer_t *pacer);
+
+/**
+ * @brief Record how far apart the first and last host were handed the report of the last
+ *        deadline when it goes to several hosts.
+ */
+void hid_pacer_skew(hid_pacer_t *pacer, int64_t skew_us);
+
+/**
+ * @brief Whether begin + offset_us (plus any stall push-back) has already passed.
+ */
+bool hid_pacer_due(const hid_pacer_t *pacer, int64_t offset_us);
+
+void hid_pacer_finish(const hid_pacer_t *pacer, hid_pacer_stats_t *out);
+
+#endif /* HID_PACER_H */
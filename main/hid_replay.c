@@ -0,0 +1,232 @@
+/*
+ * Recorded trajectory replay implementation.
+ *
+ * Recordings stay encoded in a static slot until they are played; a 5 s swipe at
+ * 120 Hz is a few hundred bytes, where the decoded records would need several
+ * gesture blocks.
+ */
+
+#include "hid_replay.h"
+
+#include <string.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+#include "esp_hidd_prf_api.h"
+#include "hid_coalesce.h"
+#include "hid_trajectory.h"
+
+typedef struct {
+    uint8_t data[HID_REPLAY_MAX_BYTES];
+    size_t len;
+    bool used;
+} hid_replay_slot_t;
+
+/// Decoding position in an encoded recording
+typedef struct {
+    const uint8_t *pos;
+    const uint8_t *end;
+} hid_replay_cursor_t;
+
+/// One decoded sample, absolute
+typedef struct {
+    uint32_t t_us;
+    int32_t x;
+    int32_t y;
+} hid_replay_sample_t;
+
+static hid_replay_slot_t s_slots[HID_REPLAY_SLOTS];
+static portMUX_TYPE s_slot_lock = portMUX_INITIALIZER_UNLOCKED;
+
+static bool hid_replay_varint(hid_replay_cursor_t *cur, uint32_t *out)
+{
+    uint32_t value = 0;
+    for (int shift = 0; shift < 32; shift += 7)
+    {
+        if (cur->pos >= cur->end)
+        {
+            return false;
+        }
+        uint8_t byte = *cur->pos++;
+        if (shift == 28 && (byte & 0x70))
+        {
+            return false; // bits past 32
+        }
+        value |= (uint32_t)(byte & 0x7F) << shift;
+        if (!(byte & 0x80))
+        {
+            *out = value;
+            return true;
+        }
+    }
+    return false;
+}
+
+static inline int32_t hid_replay_unzigzag(uint32_t v)
+{
+    return (int32_t)(v >> 1) ^ -(int32_t)(v & 1);
+}
+
+static bool hid_replay_begin(hid_replay_cursor_t *cur, const hid_replay_slot_t *slot, hid_replay_sample_t *first)
+{
+    cur->pos = slot->data;
+    cur->end = slot->data + slot->len;
+
+    uint32_t version, x, y;
+    if (!hid_replay_varint(cur, &version) || version != HID_REPLAY_VERSION ||
+        !hid_replay_varint(cur, &x) || !hid_replay_varint(cur, &y) || x > HID_ABS_MAX_COORD ||
+        y > HID_ABS_MAX_COORD)
+    {
+        return false;
+    }
+
+    first->t_us = 0;
+    first->x = (int32_t)x;
+    first->y = (int32_t)y;
+    return true;
+}
+
+static inline bool hid_replay_in_range(int64_t v)
+{
+    return v >= HID_ABS_MIN_COORD && v <= HID_ABS_MAX_COORD;
+}
+
+// Advance sample by one encoded step; false at the end, on a malformed step or on a
+// sample off the 0..HID_ABS_MAX_COORD range
+static bool hid_replay_next(hid_replay_cursor_t *cur, hid_replay_sample_t *sample)
+{
+    uint32_t dt, dx, dy;
+    if (cur->pos >= cur->end || !hid_replay_varint(cur, &dt) || !hid_replay_varint(cur, &dx) ||
+        !hid_replay_varint(cur, &dy))
+    {
+        return false;
+    }
+
+    // A delta can be any int32, so the sum is checked before it is stored
+    int64_t x = (int64_t)sample->x + hid_replay_unzigzag(dx);
+    int64_t y = (int64_t)sample->y + hid_replay_unzigzag(dy);
+    if (!hid_replay_in_range(x) || !hid_replay_in_range(y))
+    {
+        return false;
+    }
+
+    sample->t_us += dt;
+    sample->x = (int32_t)x;
+    sample->y = (int32_t)y;
+    return true;
+}
+
+int hid_replay_acquire(void)
+{
+    int slot = -1;
+    taskENTER_CRITICAL(&s_slot_lock);
+    for (int i = 0; i < HID_REPLAY_SLOTS; ++i)
+    {
+        if (!s_slots[i].used)
+        {
+            s_slots[i].used = true;
+            s_slots[i].len = 0;
+            slot = i;
+            break;
+        }
+    }
+    taskEXIT_CRITICAL(&s_slot_lock);
+    return slot;
+}
+
+uint8_t *hid_replay_buffer(int slot)
+{
+    if (slot < 0 || slot >= HID_REPLAY_SLOTS)
+    {
+        return NULL;
+    }
+    return s_slots[slot].data;
+}
+
+esp_err_t hid_replay_commit(int slot, size_t len, hid_replay_info_t *out)
+{
+    if (slot < 0 || slot >= HID_REPLAY_SLOTS || len > HID_REPLAY_MAX_BYTES)
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    hid_replay_slot_t *s = &s_slots[slot];
+    s->len = len;
+
+    hid_replay_cursor_t cur;
+    hid_replay_sample_t sample;
+    if (!hid_replay_begin(&cur, s, &sample))
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    uint32_t samples = 1;
+    uint32_t last_t_us = 0;
+    while (hid_replay_next(&cur, &sample))
+    {
+        if (sample.t_us < last_t_us)
+        {
+            return ESP_ERR_INVALID_ARG; // timestamp wrapped
+        }
+        last_t_us = sample.t_us;
+        samples++;
+    }
+    if (cur.pos != cur.end || samples < 2)
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    if (out)
+    {
+        out->samples = samples;
+        out->duration_us = last_t_us;
+    }
+    return ESP_OK;
+}
+
+void hid_replay_release(int slot)
+{
+    if (slot < 0 || slot >= HID_REPLAY_SLOTS)
+    {
+        return;
+    }
+
+    taskENTER_CRITICAL(&s_slot_lock);
+    s_slots[slot].used = false;
+    taskEXIT_CRITICAL(&s_slot_lock);
+}
+
+void hid_replay_play(uint16_t conn_id, int slot, hid_pacer_stats_t *out)
+{
+    hid_pacer_t pacer;
+    hid_pacer_begin(&pacer);
+
+    hid_replay_cursor_t cur;
+    hid_replay_sample_t sample;
+    if (slot >= 0 && slot < HID_REPLAY_SLOTS && hid_replay_begin(&cur, &s_slots[slot], &sample))
+    {
+        hid_coalesce_t co;
+        hid_coalesce_begin(&co);
+
+        esp_hidd_touch_contact_t contact = { .id = 0, .tip = true };
+        hid_replay_sample_t next = sample;
+        bool more = true;
+        while (more)
+        {
+            contact.x = (uint16_t)sample.x;
+            contact.y = (uint16_t)sample.y;
+            more = hid_replay_next(&cur, &next);
+
+            hid_pacer_wait_until(&pacer, sample.t_us);
+            hid_coalesce_send(&co, conn_id, &contact, 1, more && next.t_us > sample.t_us && hid_pacer_due(&pacer, next.t_us));
+            hid_pacer_sent(&pacer);
+            sample = next;
+        }
+
+        contact.tip = false;
+        hid_coalesce_send(&co, conn_id, &contact, 1, false);
+    }
+
+    hid_pacer_finish(&pacer, out);
+}
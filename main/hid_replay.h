@@ -0,0 +1,59 @@
+/*
+ * Replay of recorded touch trajectories uploaded in a compact binary form.
+ *
+ * Format, all integers LEB128 varints (7 bits per byte, low first):
+ *   version (1), x0, y0                  start point, mapped 0..32767
+ *   then per sample: dt_us, zz(dx), zz(dy)
+ * where zz() is the zigzag encoding of a signed delta. The finger goes down at the
+ * start point and lifts at the last sample. Every sample must stay inside 0..32767.
+ */
+
+#ifndef HID_REPLAY_H
+#define HID_REPLAY_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "esp_err.h"
+
+#include "hid_pacer.h"
+
+#define HID_REPLAY_VERSION 1
+#define HID_REPLAY_SLOTS 2           // Recordings uploaded or queued at once
+#define HID_REPLAY_MAX_BYTES 4096    // Encoded size of one recording
+
+/// Decoded recording info, filled in by hid_replay_commit()
+typedef struct {
+    uint32_t samples;
+    uint32_t duration_us;
+} hid_replay_info_t;
+
+/**
+ * @brief Take a free slot to upload a recording into.
+ *
+ * @return Slot index, or -1 when every slot is in use
+ */
+int hid_replay_acquire(void);
+
+/**
+ * @brief Buffer to receive up to HID_REPLAY_MAX_BYTES of encoded recording into.
+ */
+uint8_t *hid_replay_buffer(int slot);
+
+/**
+ * @brief Check the len bytes written to the slot buffer and mark the slot ready to play.
+ *
+ * @return ESP_OK, or ESP_ERR_INVALID_ARG for a truncated, malformed or empty recording,
+ *         or one with a sample off the coordinate range
+ */
+esp_err_t hid_replay_commit(int slot, size_t len, hid_replay_info_t *out);
+
+void hid_replay_release(int slot);
+
+/**
+ * @brief Play a committed recording on its timestamps. Samples are decoded one ahead of
+ *        their deadline, so decoding never sits between a wake-up and its report.
+ */
+void hid_replay_play(uint16_t conn_id, int slot, hid_pacer_stats_t *out);
+
+#endif /* HID_REPLAY_H */
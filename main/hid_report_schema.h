@@ -0,0 +1,152 @@
+/*
+ * Single source for the HID reports. Each application collection of the report map owns one
+ * report ID; each report names its collection, type and payload length. The report IDs, the
+ * lengths, the GATT report references and the lookup table are generated from these lists,
+ * and the report map itself is checked against them when the service starts.
+ */
+
+#ifndef HID_REPORT_SCHEMA_H
+#define HID_REPORT_SCHEMA_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "esp_hidd_prf_api.h"
+
+#define HID_REPORT_TYPE_INPUT       1
+#define HID_REPORT_TYPE_OUTPUT      2
+#define HID_REPORT_TYPE_FEATURE     3
+
+#define HID_TOUCH_CONTACT_LEN       6   // Tip/in-range bits, contact id, X, Y
+#define HID_KEYBOARD_KEY_SLOTS      6   // Key array of the keyboard report
+#define HID_VENDOR_OUT_LEN          127
+
+// X(collection, report ID)
+#define HID_COLLECTION_SCHEMA(X) \
+    X(MOUSE,    1) \
+    X(KEYBOARD, 2) \
+    X(CONSUMER, 3) \
+    X(TOUCH,    4) \
+    X(VENDOR,   5)
+
+// X(report, collection, type, length in bytes without the report ID)
+#define HID_REPORT_SCHEMA(X) \
+    X(MOUSE_IN,   MOUSE,    HID_REPORT_TYPE_INPUT,   4) \
+    X(KEY_IN,     KEYBOARD, HID_REPORT_TYPE_INPUT,   2 + HID_KEYBOARD_KEY_SLOTS) \
+    X(LED_OUT,    KEYBOARD, HID_REPORT_TYPE_OUTPUT,  1) \
+    X(CC_IN,      CONSUMER, HID_REPORT_TYPE_INPUT,   2) \
+    X(TOUCH_IN,   TOUCH,    HID_REPORT_TYPE_INPUT,   HID_TOUCH_CONTACTS_PER_REPORT * HID_TOUCH_CONTACT_LEN + 1) \
+    X(FEATURE,    TOUCH,    HID_REPORT_TYPE_FEATURE, 1) \
+    X(VENDOR_OUT, VENDOR,   HID_REPORT_TYPE_OUTPUT,  HID_VENDOR_OUT_LEN)
+
+// X(boot report, report-mode twin, length in bytes). A boot report has the ID and type of its
+// twin but the fixed layout of the boot protocol: the boot mouse has no wheel byte.
+#define HID_BOOT_REPORT_SCHEMA(X) \
+    X(BOOT_KB_IN,    KEY_IN,   2 + HID_KEYBOARD_KEY_SLOTS) \
+    X(BOOT_KB_OUT,   LED_OUT,  1) \
+    X(BOOT_MOUSE_IN, MOUSE_IN, 3)
+
+#define HID_SCHEMA_COLLECTION_ID(name, id) HID_COLLECTION_ID_##name = (id),
+enum { HID_COLLECTION_SCHEMA(HID_SCHEMA_COLLECTION_ID) };
+
+#define HID_SCHEMA_RPT_ID(name, coll, type, len) HID_RPT_ID_##name = HID_COLLECTION_ID_##coll,
+enum { HID_REPORT_SCHEMA(HID_SCHEMA_RPT_ID) };
+
+#define HID_SCHEMA_RPT_TYPE(name, coll, type, len) HID_RPT_TYPE_##name = (type),
+enum { HID_REPORT_SCHEMA(HID_SCHEMA_RPT_TYPE) };
+
+#define HID_SCHEMA_RPT_LEN(name, coll, type, len) HID_RPT_LEN_##name = (len),
+enum { HID_REPORT_SCHEMA(HID_SCHEMA_RPT_LEN) };
+
+#define HID_SCHEMA_BOOT_LEN(name, twin, len) HID_RPT_LEN_##name = (len),
+enum { HID_BOOT_REPORT_SCHEMA(HID_SCHEMA_BOOT_LEN) };
+
+// A report ID used by two collections makes the sum and the union of the ID bits differ
+#define HID_SCHEMA_ID_SUM(name, id) + (1u << (id))
+#define HID_SCHEMA_ID_OR(name, id) | (1u << (id))
+_Static_assert((0 HID_COLLECTION_SCHEMA(HID_SCHEMA_ID_SUM)) == (0 HID_COLLECTION_SCHEMA(HID_SCHEMA_ID_OR)),
+               "two collections share a report ID");
+
+#define HID_SCHEMA_ID_RANGE(name, id) \
+    _Static_assert((id) >= 1 && (id) <= 15, "report ID of " #name " out of range");
+HID_COLLECTION_SCHEMA(HID_SCHEMA_ID_RANGE)
+
+#define HID_SCHEMA_LEN_RANGE(name, coll, type, len) \
+    _Static_assert((len) >= 1 && (len) <= 255, "length of " #name " out of range");
+HID_REPORT_SCHEMA(HID_SCHEMA_LEN_RANGE)
+
+#define HID_SCHEMA_BOOT_LEN_RANGE(name, twin, len) \
+    _Static_assert((len) >= 1 && (len) <= 8, "length of " #name " out of the boot protocol range");
+HID_BOOT_REPORT_SCHEMA(HID_SCHEMA_BOOT_LEN_RANGE)
+
+/*
+ * Schema length of a report, 0 when it is not declared. The case labels also reject a report
+ * declared twice with the same ID and type at compile time.
+ */
+static inline uint8_t hid_report_schema_len(uint8_t id, uint8_t type)
+{
+#define HID_SCHEMA_LEN_CASE(name, coll, type, len) \
+    case (type) << 4 | HID_COLLECTION_ID_##coll: \
+        return (len);
+
+    switch (type << 4 | id)
+    {
+        HID_REPORT_SCHEMA(HID_SCHEMA_LEN_CASE)
+    default:
+        return 0;
+    }
+
+#undef HID_SCHEMA_LEN_CASE
+}
+
+/*
+ * Length of the boot protocol report with this ID and type, 0 when there is none.
+ */
+static inline uint8_t hid_boot_report_schema_len(uint8_t id, uint8_t type)
+{
+#define HID_SCHEMA_BOOT_LEN_CASE(name, twin, len) \
+    case HID_RPT_TYPE_##twin << 4 | HID_RPT_ID_##twin: \
+        return (len);
+
+    switch (type << 4 | id)
+    {
+        HID_BOOT_REPORT_SCHEMA(HID_SCHEMA_BOOT_LEN_CASE)
+    default:
+        return 0;
+    }
+
+#undef HID_SCHEMA_BOOT_LEN_CASE
+}
+
+// Packers: fixed offsets straight from the layouts above
+
+static inline void hid_pack_touch_contact(uint8_t *field, const esp_hidd_touch_contact_t *contact)
+{
+    field[0] = (uint8_t)((contact->tip != 0) * 0x03); // Tip Switch | In Range
+    field[1] = contact->id;
+    field[2] = (uint8_t)(contact->x & 0xFF);
+    field[3] = (uint8_t)(contact->x >> 8);
+    field[4] = (uint8_t)(contact->y & 0xFF);
+    field[5] = (uint8_t)(contact->y >> 8);
+}
+
+// Modifier byte, reserved byte, then the key array; unused slots must already be 0
+static inline void hid_pack_keyboard(uint8_t *buffer, uint8_t modifiers, const uint8_t *keys, uint8_t num_keys)
+{
+    buffer[0] = modifiers;
+    buffer[1] = 0;
+    for (uint8_t i = 0; i < num_keys; i++)
+    {
+        buffer[2 + i] = keys[i];
+    }
+}
+
+static inline void hid_pack_mouse(uint8_t *buffer, uint8_t buttons, int8_t dx, int8_t dy, int8_t wheel)
+{
+    buffer[0] = buttons;
+    buffer[1] = (uint8_t)dx;
+    buffer[2] = (uint8_t)dy;
+    buffer[3] = (uint8_t)wheel;
+}
+
+#endif /* HID_REPORT_SCHEMA_H */
@@ -0,0 +1,579 @@
+/*
+ * Swipe trajectory kernels.
+ *
+ * The fixed-point kernel replaces cosf/sinf with 256-segment Q30 tables (linear
+ * interpolation, one guard entry). Q15 entries were not enough for the two-finger
+ * kernel, where a full turn amplifies the ease error to 2 LSB at the fingertips. Positions are Q28 so that a
+ * normalized input survives the round trip to 0..32767 exactly. sqrtf and the
+ * divisions only run once per swipe, in init. The two-finger kernel reuses the
+ * arc table as a sine over half a turn, with angles in 2^32 per turn.
+ *
+ * Paths are only evaluated while planning, so they stay in float: curves are
+ * flattened into HID_TRAJ_PATH_SUBSTEPS chords per segment and sampled by arc length.
+ */
+
+#include "hid_trajectory.h"
+
+#include <math.h>
+
+#define HID_PI 3.1415926f
+
+#define HID_Q30_ONE (1L << 30)
+
+#define HID_TRAJ_PATH_SUBSTEPS 16
+#define HID_TRAJ_PATH_MIN_SPEED 0.01f // normalized units/s, keeps segment times within uint32
+
+#define HID_TRAJ_FLING_WINDOW_S 0.1f      // Trailing window hosts estimate the release velocity over
+#define HID_TRAJ_FLING_MIN_ACCEL_S 0.048f // Shortest run-up, three report intervals
+#define HID_TRAJ_FLING_MIN_SPEED 0.05f
+
+#define HID_TRAJ_TABLE_BITS 8
+#define HID_TRAJ_INDEX_SHIFT (30 - HID_TRAJ_TABLE_BITS)
+#define HID_TRAJ_FRAC_MASK ((1L << HID_TRAJ_INDEX_SHIFT) - 1)
+
+// 0.5 - 0.5 * cos(pi * k / 256) in Q30, k = 0..256 plus a guard entry
+static const uint32_t hid_traj_ease_tbl[(1 << HID_TRAJ_TABLE_BITS) + 2] = {
+             0,      40425,     161695,     363792,     646685,    1010330,
+       1454675,    1979651,    2585180,    3271171,    4037519,    4884110,
+       5810817,    6817499,    7904006,    9070172,   10315824,   11640773,
+      13044820,   14527753,   16089348,   17729372,   19447577,   21243703,
+      23117481,   25068629,   27096852,   29201845,   31383291,   33640862,
+      35974217,   38383006,   40866865,   43425420,   46058287,   48765068,
+      51545356,   54398732,   57324767,   60323019,   63393038,   66534362,
+      69746516,   73029017,   76381371,   79803073,   83293608,   86852450,
+      90479063,   94172901,   97933408,  101760017,  105652152,  109609227,
+     113630646,  117715804,  121864085,  126074864,  130347508,  134681373,
+     139075806,  143530145,  148043720,  152615851,  157245850,  161933018,
+     166676651,  171476034,  176330443,  181239149,  186201412,  191216484,
+     196283611,  201402029,  206570967,  211789647,  217057283,  222373082,
+     227736243,  233145959,  238601414,  244101788,  249646252,  255233971,
+     260864103,  266535801,  272248210,  278000471,  283791716,  289621074,
+     295487667,  301390612,  307329019,  313301994,  319308638,  325348046,
+     331419309,  337521511,  343653736,  349815057,  356004549,  362221279,
+     368464310,  374732703,  381025513,  387341792,  393680591,  400040953,
+     406421921,  412822535,  419241829,  425678839,  432132593,  438602120,
+     445086447,  451584596,  458095588,  464618444,  471152181,  477695815,
+     484248360,  490808831,  497376238,  503949592,  510527905,  517110185,
+     523695440,  530282680,  536870912,  543459144,  550046384,  556631639,
+     563213919,  569792232,  576365586,  582932993,  589493464,  596046009,
+     602589643,  609123380,  615646236,  622157228,  628655377,  635139704,
+     641609231,  648062985,  654499995,  660919289,  667319903,  673700871,
+     680061233,  686400032,  692716311,  699009121,  705277514,  711520545,
+     717737275,  723926767,  730088088,  736220313,  742322515,  748393778,
+     754433186,  760439830,  766412805,  772351212,  778254157,  784120750,
+     789950108,  795741353,  801493614,  807206023,  812877721,  818507853,
+     824095572,  829640036,  835140410,  840595865,  846005581,  851368742,
+     856684541,  861952177,  867170857,  872339795,  877458213,  882525340,
+     887540412,  892502675,  897411381,  902265790,  907065173,  911808806,
+     916495974,  921125973,  925698104,  930211679,  934666018,  939060451,
+     943394316,  947666960,  951877739,  956026020,  960111178,  964132597,
+     968089672,  971981807,  975808416,  979568923,  983262761,  986889374,
+     990448216,  993938751,  997360453, 1000712807, 1003995308, 1007207462,
+    1010348786, 1013418805, 1016417057, 1019343092, 1022196468, 1024976756,
+    1027683537, 1030316404, 1032874959, 1035358818, 1037767607, 1040100962,
+    1042358533, 1044539979, 1046644972, 1048673195, 1050624343, 1052498121,
+    1054294247, 1056012452, 1057652476, 1059214071, 1060697004, 1062101051,
+    1063426000, 1064671652, 1065837818, 1066924325, 1067931007, 1068857714,
+    1069704305, 1070470653, 1071156644, 1071762173, 1072287149, 1072731494,
+    1073095139, 1073378032, 1073580129, 1073701399, 1073741824, 1073741824,
+};
+
+// sin(pi * k / 256) in Q30, k = 0..256 plus a guard entry
+static const uint32_t hid_traj_arc_tbl[(1 << HID_TRAJ_TABLE_BITS) + 2] = {
+             0,   13176464,   26350943,   39521455,   52686014,   65842639,
+      78989349,   92124163,  105245103,  118350194,  131437462,  144504935,
+     157550647,  170572633,  183568930,  196537583,  209476638,  222384147,
+     235258165,  248096755,  260897982,  273659918,  286380643,  299058239,
+     311690799,  324276419,  336813204,  349299266,  361732726,  374111709,
+     386434353,  398698801,  410903207,  423045732,  435124548,  447137835,
+     459083786,  470960600,  482766489,  494499676,  506158392,  517740883,
+     529245404,  540670223,  552013618,  563273883,  574449320,  585538248,
+     596538995,  607449906,  618269338,  628995660,  639627258,  650162530,
+     660599890,  670937767,  681174602,  691308855,  701339000,  711263525,
+     721080937,  730789757,  740388522,  749875788,  759250125,  768510122,
+     777654384,  786681534,  795590213,  804379079,  813046808,  821592095,
+     830013654,  838310216,  846480531,  854523370,  862437520,  870221790,
+     877875009,  885396022,  892783698,  900036924,  907154608,  914135678,
+     920979082,  927683790,  934248793,  940673101,  946955747,  953095785,
+     959092290,  964944360,  970651112,  976211688,  981625251,  986890984,
+     992008094,  996975812, 1001793390, 1006460100, 1010975242, 1015338134,
+    1019548121, 1023604567, 1027506862, 1031254418, 1034846671, 1038283080,
+    1041563127, 1044686319, 1047652185, 1050460278, 1053110176, 1055601479,
+    1057933813, 1060106826, 1062120190, 1063973603, 1065666786, 1067199483,
+    1068571464, 1069782521, 1070832474, 1071721163, 1072448455, 1073014240,
+    1073418433, 1073660973, 1073741824, 1073660973, 1073418433, 1073014240,
+    1072448455, 1071721163, 1070832474, 1069782521, 1068571464, 1067199483,
+    1065666786, 1063973603, 1062120190, 1060106826, 1057933813, 1055601479,
+    1053110176, 1050460278, 1047652185, 1044686319, 1041563127, 1038283080,
+    1034846671, 1031254418, 1027506862, 1023604567, 1019548121, 1015338134,
+    1010975242, 1006460100, 1001793390,  996975812,  992008094,  986890984,
+     981625251,  976211688,  970651112,  964944360,  959092290,  953095785,
+     946955747,  940673101,  934248793,  927683790,  920979082,  914135678,
+     907154608,  900036924,  892783698,  885396022,  877875009,  870221790,
+     862437520,  854523370,  846480531,  838310216,  830013654,  821592095,
+     813046808,  804379079,  795590213,  786681534,  777654384,  768510122,
+     759250125,  749875788,  740388522,  730789757,  721080937,  711263525,
+     701339000,  691308855,  681174602,  670937767,  660599890,  650162530,
+     639627258,  628995660,  618269338,  607449906,  596538995,  585538248,
+     574449320,  563273883,  552013618,  540670223,  529245404,  517740883,
+     506158392,  494499676,  482766489,  470960600,  459083786,  447137835,
+     435124548,  423045732,  410903207,  398698801,  386434353,  374111709,
+     361732726,  349299266,  336813204,  324276419,  311690799,  299058239,
+     286380643,  273659918,  260897982,  248096755,  235258165,  222384147,
+     209476638,  196537583,  183568930,  170572633,  157550647,  144504935,
+     131437462,  118350194,  105245103,   92124163,   78989349,   65842639,
+      52686014,   39521455,   26350943,   13176464,          0,          0,
+};
+
+static inline int16_t hid_clamp_coord(int32_t coord)
+{
+    if (coord < HID_ABS_MIN_COORD)
+    {
+        return HID_ABS_MIN_COORD;
+    }
+    if (coord > HID_ABS_MAX_COORD)
+    {
+        return HID_ABS_MAX_COORD;
+    }
+    return (int16_t)coord;
+}
+
+uint16_t hid_traj_map_normalized(float value)
+{
+    if (value < 0.0f)
+    {
+        value = 0.0f;
+    }
+    else if (value > 1.0f)
+    {
+        value = 1.0f;
+    }
+
+    int32_t scaled = (int32_t)(value * HID_ABS_MAX_COORD + 0.5f);
+    return (uint16_t)hid_clamp_coord(scaled);
+}
+
+uint16_t hid_traj_map_fx(int32_t q)
+{
+    if (q < 0)
+    {
+        q = 0;
+    }
+    else if (q > HID_FX_ONE)
+    {
+        q = HID_FX_ONE;
+    }
+
+    // floor(q / 2^28 * 32767 + 0.5), the same rounding as the float mapping
+    return (uint16_t)hid_clamp_coord((int32_t)(((int64_t)q * HID_ABS_MAX_COORD + (HID_FX_ONE / 2)) >> HID_FX_SHIFT));
+}
+
+int32_t hid_traj_to_fx(float value)
+{
+    // Q28 holds +-8; anything past +-4 is far off screen anyway
+    if (value < -4.0f)
+    {
+        value = -4.0f;
+    }
+    else if (value > 4.0f)
+    {
+        value = 4.0f;
+    }
+    return (int32_t)lroundf(value * HID_FX_ONE);
+}
+
+// (a * b) >> shift with rounding; a shift, because a 64-bit division is a libcall on RV32
+static inline int32_t hid_fx_mul(int32_t a, int32_t b, int shift)
+{
+    return (int32_t)(((int64_t)a * b + ((int64_t)1 << (shift - 1))) >> shift);
+}
+
+// Interpolated table lookup, t and result in Q30
+static inline int32_t hid_traj_lut(const uint32_t *tbl, int32_t t)
+{
+    if (t <= 0)
+    {
+        return (int32_t)tbl[0];
+    }
+    if (t >= HID_Q30_ONE)
+    {
+        return (int32_t)tbl[1 << HID_TRAJ_TABLE_BITS];
+    }
+
+    int32_t idx = t >> HID_TRAJ_INDEX_SHIFT;
+    int32_t frac = t & HID_TRAJ_FRAC_MASK;
+    int32_t a = (int32_t)tbl[idx];
+    int32_t b = (int32_t)tbl[idx + 1];
+    return a + hid_fx_mul(b - a, frac, HID_TRAJ_INDEX_SHIFT);
+}
+
+void hid_traj_swipe_init_f(hid_traj_swipe_f_t *traj, float start_x, float start_y,
+                           float end_x, float end_y, uint32_t steps)
+{
+    traj->start_x = start_x;
+    traj->start_y = start_y;
+    traj->dx = end_x - start_x;
+    traj->dy = end_y - start_y;
+    traj->steps = steps ? steps : 1;
+
+    float path_len = sqrtf(traj->dx * traj->dx + traj->dy * traj->dy);
+
+    float perp_x = -traj->dy;
+    float perp_y = traj->dx;
+    float perp_len = sqrtf(perp_x * perp_x + perp_y * perp_y);
+    if (perp_len > 0.0001f)
+    {
+        perp_x /= perp_len;
+        perp_y /= perp_len;
+    }
+    else
+    {
+        perp_x = 0.0f;
+        perp_y = 0.1f;
+    }
+    traj->perp_x = perp_x;
+    traj->perp_y = perp_y;
+
+    traj->arc_offset = fmaxf(0.02f, path_len * 0.25f);
+}
+
+void hid_traj_swipe_point_f(const hid_traj_swipe_f_t *traj, uint32_t step, uint16_t *x, uint16_t *y)
+{
+    float t = (float)step / (float)traj->steps;
+    float eased = 0.5f - 0.5f * cosf(t * HID_PI); // ease-in-out to simulate acceleration
+    float along_x = traj->start_x + traj->dx * eased;
+    float along_y = traj->start_y + traj->dy * eased;
+
+    float arc = sinf(eased * HID_PI); // create slight arc offset
+    *x = hid_traj_map_normalized(along_x + traj->perp_x * arc * traj->arc_offset);
+    *y = hid_traj_map_normalized(along_y + traj->perp_y * arc * traj->arc_offset);
+}
+
+void hid_traj_swipe_init_fx(hid_traj_swipe_fx_t *traj, float start_x, float start_y,
+                            float end_x, float end_y, uint32_t steps)
+{
+    // Direction and arc size come from the float model once per swipe so both kernels agree
+    hid_traj_swipe_f_t ref;
+    hid_traj_swipe_init_f(&ref, start_x, start_y, end_x, end_y, steps);
+
+    traj->start_x = hid_traj_to_fx(start_x);
+    traj->start_y = hid_traj_to_fx(start_y);
+    traj->dx = hid_traj_to_fx(end_x) - traj->start_x;
+    traj->dy = hid_traj_to_fx(end_y) - traj->start_y;
+    traj->perp_x = (int32_t)lroundf(ref.perp_x * HID_Q30_ONE);
+    traj->perp_y = (int32_t)lroundf(ref.perp_y * HID_Q30_ONE);
+    traj->arc_offset = (int32_t)lroundf(ref.arc_offset * HID_Q30_ONE);
+    traj->steps = ref.steps;
+    traj->t_inc = (uint32_t)(HID_Q30_ONE / ref.steps);
+}
+
+void hid_traj_swipe_point_fx(const hid_traj_swipe_fx_t *traj, uint32_t step, uint16_t *x, uint16_t *y)
+{
+    int32_t t = (step >= traj->steps) ? HID_Q30_ONE : (int32_t)(step * traj->t_inc);
+    int32_t eased = hid_traj_lut(hid_traj_ease_tbl, t);
+    int32_t arc = hid_traj_lut(hid_traj_arc_tbl, eased);
+    int32_t arc_scale = hid_fx_mul(arc, traj->arc_offset, 30);
+
+    *x = hid_traj_map_fx(traj->start_x + hid_fx_mul(traj->dx, eased, 30) + hid_fx_mul(traj->perp_x, arc_scale, 32));
+    *y = hid_traj_map_fx(traj->start_y + hid_fx_mul(traj->dy, eased, 30) + hid_fx_mul(traj->perp_y, arc_scale, 32));
+}
+
+static float hid_traj_clamp_turn(float deg)
+{
+    return fmaxf(-360.0f, fminf(360.0f, deg));
+}
+
+void hid_traj_pair_init_f(hid_traj_pair_f_t *traj, float center_x, float center_y, float start_spread,
+                          float end_spread, float start_deg, float end_deg, uint32_t steps)
+{
+    traj->center_x = center_x;
+    traj->center_y = center_y;
+    traj->radius = fmaxf(0.0f, start_spread) * 0.5f;
+    traj->d_radius = fmaxf(0.0f, end_spread) * 0.5f - traj->radius;
+    traj->angle = start_deg * (HID_PI / 180.0f);
+    traj->d_angle = hid_traj_clamp_turn(end_deg - start_deg) * (HID_PI / 180.0f);
+    traj->steps = steps ? steps : 1;
+}
+
+void hid_traj_pair_point_f(const hid_traj_pair_f_t *traj, uint32_t step, uint16_t xs[2], uint16_t ys[2])
+{
+    float t = (float)step / (float)traj->steps;
+    float eased = 0.5f - 0.5f * cosf(t * HID_PI);
+    float radius = traj->radius + traj->d_radius * eased;
+    float angle = traj->angle + traj->d_angle * eased;
+    float ox = radius * cosf(angle);
+    float oy = radius * sinf(angle);
+
+    xs[0] = hid_traj_map_normalized(traj->center_x + ox);
+    ys[0] = hid_traj_map_normalized(traj->center_y + oy);
+    xs[1] = hid_traj_map_normalized(traj->center_x - ox);
+    ys[1] = hid_traj_map_normalized(traj->center_y - oy);
+}
+
+// sin of an angle in 2^32 per turn, Q30
+static inline int32_t hid_traj_sin_turn(uint32_t angle)
+{
+    int32_t half = hid_traj_lut(hid_traj_arc_tbl, (int32_t)((angle & 0x7FFFFFFFu) >> 1));
+    return (angle & 0x80000000u) ? -half : half;
+}
+
+static inline uint32_t hid_traj_deg_to_turn(float deg)
+{
+    // Reduce first so the cast below stays in range
+    float turns = deg / 360.0f;
+    turns -= floorf(turns);
+    return (uint32_t)llroundf(turns * 4294967296.0f);
+}
+
+void hid_traj_pair_init_fx(hid_traj_pair_fx_t *traj, float center_x, float center_y, float start_spread,
+                           float end_spread, float start_deg, float end_deg, uint32_t steps)
+{
+    traj->center_x = hid_traj_to_fx(center_x);
+    traj->center_y = hid_traj_to_fx(center_y);
+    traj->radius = hid_traj_to_fx(fmaxf(0.0f, start_spread) * 0.5f);
+    traj->d_radius = hid_traj_to_fx(fmaxf(0.0f, end_spread) * 0.5f) - traj->radius;
+    traj->angle = hid_traj_deg_to_turn(start_deg);
+    traj->d_angle = (int64_t)llroundf(hid_traj_clamp_turn(end_deg - start_deg) / 360.0f * 4294967296.0f);
+    traj->steps = steps ? steps : 1;
+    traj->t_inc = (uint32_t)(HID_Q30_ONE / traj->steps);
+}
+
+void hid_traj_pair_point_fx(const hid_traj_pair_fx_t *traj, uint32_t step, uint16_t xs[2], uint16_t ys[2])
+{
+    int32_t t = (step >= traj->steps) ? HID_Q30_ONE : (int32_t)(step * traj->t_inc);
+    int32_t eased = hid_traj_lut(hid_traj_ease_tbl, t);
+    int32_t radius = traj->radius + hid_fx_mul(traj->d_radius, eased, 30);
+    uint32_t angle = traj->angle + (uint32_t)((traj->d_angle * eased + (1LL << 29)) >> 30);
+
+    int32_t ox = hid_fx_mul(radius, hid_traj_sin_turn(angle + 0x40000000u), 30);
+    int32_t oy = hid_fx_mul(radius, hid_traj_sin_turn(angle), 30);
+
+    xs[0] = hid_traj_map_fx(traj->center_x + ox);
+    ys[0] = hid_traj_map_fx(traj->center_y + oy);
+    xs[1] = hid_traj_map_fx(traj->center_x - ox);
+    ys[1] = hid_traj_map_fx(traj->center_y - oy);
+}
+
+uint32_t hid_traj_path_segments(const hid_traj_path_t *path)
+{
+    if (!path || path->count < 2 || path->count > HID_TRAJ_PATH_MAX_POINTS)
+    {
+        return 0;
+    }
+
+    switch (path->kind)
+    {
+    case HID_TRAJ_PATH_POLYLINE:
+    case HID_TRAJ_PATH_CATMULL_ROM:
+        return path->count - 1;
+    case HID_TRAJ_PATH_BEZIER:
+        return ((path->count - 1) % 3 == 0) ? (path->count - 1) / 3 : 0;
+    default:
+        return 0;
+    }
+}
+
+static inline float hid_traj_path_coord(const uint16_t *v, int32_t i, int32_t count)
+{
+    return (float)v[i < 0 ? 0 : (i >= count ? count - 1 : i)];
+}
+
+// Point at u in [0, 1] of one segment
+static void hid_traj_path_eval(const hid_traj_path_t *path, uint32_t seg, float u, float *x, float *y)
+{
+    const int32_t n = path->count;
+    const uint16_t *coords[2] = { path->xs, path->ys };
+    float *out[2] = { x, y };
+
+    for (int axis = 0; axis < 2; ++axis)
+    {
+        const uint16_t *v = coords[axis];
+        if (path->kind == HID_TRAJ_PATH_BEZIER)
+        {
+            const int32_t i = (int32_t)seg * 3;
+            float w = 1.0f - u;
+            *out[axis] = w * w * w * v[i] + 3.0f * w * w * u * v[i + 1] + 3.0f * w * u * u * v[i + 2] +
+                         u * u * u * v[i + 3];
+        }
+        else if (path->kind == HID_TRAJ_PATH_CATMULL_ROM)
+        {
+            // Uniform Catmull-Rom, end points repeated
+            const int32_t i = (int32_t)seg;
+            float p0 = hid_traj_path_coord(v, i - 1, n);
+            float p1 = hid_traj_path_coord(v, i, n);
+            float p2 = hid_traj_path_coord(v, i + 1, n);
+            float p3 = hid_traj_path_coord(v, i + 2, n);
+            *out[axis] = 0.5f * (2.0f * p1 + (p2 - p0) * u + (2.0f * p0 - 5.0f * p1 + 4.0f * p2 - p3) * u * u +
+                                 (3.0f * p1 - p0 - 3.0f * p2 + p3) * u * u * u);
+        }
+        else
+        {
+            *out[axis] = v[seg] + (v[seg + 1] - (float)v[seg]) * u;
+        }
+    }
+}
+
+static inline uint32_t hid_traj_path_substeps(const hid_traj_path_t *path)
+{
+    return (path->kind == HID_TRAJ_PATH_POLYLINE) ? 1 : HID_TRAJ_PATH_SUBSTEPS;
+}
+
+// Load chord sub of the current segment into the walk
+static void hid_traj_path_load_chord(hid_traj_path_walk_t *walk)
+{
+    const float subs = (float)hid_traj_path_substeps(walk->path);
+    hid_traj_path_eval(walk->path, walk->seg, walk->sub / subs, &walk->ax, &walk->ay);
+    hid_traj_path_eval(walk->path, walk->seg, (walk->sub + 1) / subs, &walk->bx, &walk->by);
+    walk->chord_len = sqrtf((walk->bx - walk->ax) * (walk->bx - walk->ax) + (walk->by - walk->ay) * (walk->by - walk->ay));
+}
+
+bool hid_traj_path_begin(hid_traj_path_walk_t *walk, const hid_traj_path_t *path, uint32_t duration_ms)
+{
+    const uint32_t segments = hid_traj_path_segments(path);
+    if (!walk || segments == 0)
+    {
+        return false;
+    }
+
+    walk->path = path;
+    walk->segments = segments;
+
+    const uint32_t subs = hid_traj_path_substeps(path);
+    float total_len = 0.0f;
+    bool use_speeds = true;
+    for (uint32_t seg = 0; seg < segments; ++seg)
+    {
+        float len = 0.0f;
+        float px, py;
+        hid_traj_path_eval(path, seg, 0.0f, &px, &py);
+        for (uint32_t i = 1; i <= subs; ++i)
+        {
+            float x, y;
+            hid_traj_path_eval(path, seg, (float)i / subs, &x, &y);
+            len += sqrtf((x - px) * (x - px) + (y - py) * (y - py));
+            px = x;
+            py = y;
+        }
+        walk->seg_len[seg] = len;
+        total_len += len;
+        use_speeds = use_speeds && path->speeds[seg] > 0.0f;
+    }
+
+    walk->total_us = 0;
+    for (uint32_t seg = 0; seg < segments; ++seg)
+    {
+        float seg_us;
+        if (use_speeds)
+        {
+            float speed = fmaxf(HID_TRAJ_PATH_MIN_SPEED, path->speeds[seg]) * HID_ABS_MAX_COORD;
+            seg_us = walk->seg_len[seg] / speed * 1e6f;
+        }
+        else
+        {
+            seg_us = (total_len > 0.0f) ? duration_ms * 1000.0f * walk->seg_len[seg] / total_len
+                                        : duration_ms * 1000.0f / segments;
+        }
+        walk->seg_us[seg] = (uint32_t)(seg_us + 0.5f);
+        walk->total_us += walk->seg_us[seg];
+    }
+
+    walk->seg = 0;
+    walk->seg_start_us = 0;
+    walk->sub = 0;
+    walk->sub_start_len = 0.0f;
+    hid_traj_path_load_chord(walk);
+    return true;
+}
+
+static inline uint16_t hid_traj_path_round(float v)
+{
+    return (uint16_t)hid_clamp_coord((int32_t)(v + 0.5f));
+}
+
+void hid_traj_path_at(hid_traj_path_walk_t *walk, uint32_t t_us, uint16_t *x, uint16_t *y)
+{
+    // Find the segment, then the distance along it at constant speed
+    while (walk->seg + 1 < walk->segments && t_us >= walk->seg_start_us + walk->seg_us[walk->seg])
+    {
+        walk->seg_start_us += walk->seg_us[walk->seg];
+        walk->seg++;
+        walk->sub = 0;
+        walk->sub_start_len = 0.0f;
+        hid_traj_path_load_chord(walk);
+    }
+
+    const uint32_t seg_us = walk->seg_us[walk->seg];
+    const uint32_t local_us = t_us - walk->seg_start_us;
+    float dist = walk->seg_len[walk->seg];
+    if (seg_us > 0 && local_us < seg_us)
+    {
+        dist *= (float)local_us / (float)seg_us;
+    }
+
+    const uint32_t subs = hid_traj_path_substeps(walk->path);
+    while (walk->sub + 1 < subs && dist > walk->sub_start_len + walk->chord_len)
+    {
+        walk->sub_start_len += walk->chord_len;
+        walk->sub++;
+        hid_traj_path_load_chord(walk);
+    }
+
+    float f = (walk->chord_len > 0.0f) ? (dist - walk->sub_start_len) / walk->chord_len : 0.0f;
+    f = fmaxf(0.0f, fminf(1.0f, f));
+    *x = hid_traj_path_round(walk->ax + (walk->bx - walk->ax) * f);
+    *y = hid_traj_path_round(walk->ay + (walk->by - walk->ay) * f);
+}
+
+void hid_traj_fling_init(hid_traj_fling_t *traj, float start_x, float start_y, float angle_deg,
+                         float distance, float velocity, bool fling)
+{
+    const float rad = angle_deg * HID_PI / 180.0f;
+    traj->start_x = start_x;
+    traj->start_y = start_y;
+    traj->dir_x = cosf(rad);
+    traj->dir_y = sinf(rad);
+    // With the speed floor this keeps cruise_s under a minute, so the casts below stay in range
+    traj->distance = fmaxf(0.0f, fminf(HID_TRAJ_FLING_MAX_DISTANCE, distance));
+    traj->velocity = fmaxf(HID_TRAJ_FLING_MIN_SPEED, velocity);
+    traj->fling = fling;
+
+    const float cruise_s = traj->distance / traj->velocity;
+    if (!fling)
+    {
+        // Smoothstep peaks at 1.5x its mean speed
+        traj->accel_us = 0;
+        traj->move_us = (uint32_t)(1.5f * cruise_s * 1e6f + 0.5f);
+        return;
+    }
+
+    // Run up so the whole window is at constant speed; short strokes get a shorter window
+    float accel_s = fmaxf(2.0f * (cruise_s - HID_TRAJ_FLING_WINDOW_S), fminf(cruise_s, HID_TRAJ_FLING_MIN_ACCEL_S));
+    traj->accel_us = (uint32_t)(accel_s * 1e6f + 0.5f);
+    traj->move_us = (uint32_t)((cruise_s + 0.5f * accel_s) * 1e6f + 0.5f);
+}
+
+void hid_traj_fling_at(const hid_traj_fling_t *traj, uint32_t t_us, uint16_t *x, uint16_t *y)
+{
+    float dist = traj->distance;
+    if (t_us < traj->move_us)
+    {
+        const float t = t_us * 1e-6f;
+        if (!traj->fling)
+        {
+            const float u = (float)t_us / (float)traj->move_us;
+            dist *= u * u * (3.0f - 2.0f * u);
+        }
+        else if (t_us < traj->accel_us)
+        {
+            dist = 0.5f * traj->velocity * t * t / (traj->accel_us * 1e-6f);
+        }
+        else
+        {
+            const float accel_s = traj->accel_us * 1e-6f;
+            dist = fminf(dist, traj->velocity * (0.5f * accel_s + (t - accel_s)));
+        }
+    }
+
+    *x = hid_traj_map_normalized(traj->start_x + traj->dir_x * dist);
+    *y = hid_traj_map_normalized(traj->start_y + traj->dir_y * dist);
+}
@@ -0,0 +1,251 @@
+/*
+ * Swipe and two-finger trajectory kernels: float reference and fixed point for FPU-less targets.
+ */
+
+#ifndef HID_TRAJECTORY_H
+#define HID_TRAJECTORY_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "sdkconfig.h"
+
+#define HID_ABS_MIN_COORD 0
+#define HID_ABS_MAX_COORD 32767
+
+#define HID_FX_SHIFT 28
+#define HID_FX_ONE (1L << HID_FX_SHIFT) // 1.0 in the Q28 coordinate format
+
+// ESP32-C2/C3 have no FPU, every float op there is a soft-float library call
+#ifndef HID_TRAJ_FIXED_POINT
+#if CONFIG_SOC_CPU_HAS_FPU
+#define HID_TRAJ_FIXED_POINT 0
+#else
+#define HID_TRAJ_FIXED_POINT 1
+#endif
+#endif
+
+/// Float swipe state, the original ease-in-out + arc model
+typedef struct {
+    float start_x;
+    float start_y;
+    float dx;
+    float dy;
+    float perp_x;
+    float perp_y;
+    float arc_offset;
+    uint32_t steps;
+} hid_traj_swipe_f_t;
+
+/// Same model in fixed point: positions Q28, direction and arc size Q30; only integer ops per step
+typedef struct {
+    int32_t start_x;
+    int32_t start_y;
+    int32_t dx;
+    int32_t dy;
+    int32_t perp_x;
+    int32_t perp_y;
+    int32_t arc_offset;
+    uint32_t steps;
+    uint32_t t_inc;
+} hid_traj_swipe_fx_t;
+
+/// Two fingers mirrored about a center; spread and angle follow the same ease-in-out as the swipe
+typedef struct {
+    float center_x;
+    float center_y;
+    float radius;                                 /*!< Half the start spread */
+    float d_radius;
+    float angle;                                  /*!< Radians */
+    float d_angle;
+    uint32_t steps;
+} hid_traj_pair_f_t;
+
+/// Fixed-point pair: center and radius Q28, angles in 2^32 per turn so they wrap for free
+typedef struct {
+    int32_t center_x;
+    int32_t center_y;
+    int32_t radius;
+    int32_t d_radius;
+    uint32_t angle;
+    int64_t d_angle;                              /*!< At most one turn either way */
+    uint32_t steps;
+    uint32_t t_inc;
+} hid_traj_pair_fx_t;
+
+#define HID_TRAJ_PATH_MAX_POINTS 12
+
+typedef enum {
+    HID_TRAJ_PATH_POLYLINE = 0,                   /*!< Straight segments between the points */
+    HID_TRAJ_PATH_CATMULL_ROM,                    /*!< Curve through every point */
+    HID_TRAJ_PATH_BEZIER,                         /*!< Cubic segments, 3n + 1 points with shared ends */
+} hid_traj_path_kind_t;
+
+/// Control points of a path, in mapped coordinates
+typedef struct {
+    uint8_t kind;                                 /*!< hid_traj_path_kind_t */
+    uint8_t count;
+    uint16_t xs[HID_TRAJ_PATH_MAX_POINTS];
+    uint16_t ys[HID_TRAJ_PATH_MAX_POINTS];
+    float speeds[HID_TRAJ_PATH_MAX_POINTS - 1];   /*!< Per segment, normalized units/s; all 0 = use a total duration */
+} hid_traj_path_t;
+
+/// Arc-length walk over a path; samples are requested at increasing times
+typedef struct {
+    const hid_traj_path_t *path;
+    uint32_t segments;
+    uint32_t total_us;
+    float seg_len[HID_TRAJ_PATH_MAX_POINTS - 1];
+    uint32_t seg_us[HID_TRAJ_PATH_MAX_POINTS - 1];
+    uint32_t seg;                                 /*!< Cursor: segment, its start time, */
+    uint32_t seg_start_us;
+    uint32_t sub;                                 /*!< sub-sample and the chord it starts */
+    float sub_start_len;
+    float chord_len;
+    float ax, ay, bx, by;
+} hid_traj_path_walk_t;
+
+#define HID_TRAJ_FLING_SETTLE_MS 100        // Stop mode: still time before the lift, one velocity window
+#define HID_TRAJ_FLING_MAX_DISTANCE 2.0f    // Longer than any on-screen stroke; bounds move_us to about a minute
+
+/// One-finger straight stroke shaped by its release velocity, distances in normalized units
+typedef struct {
+    float start_x;
+    float start_y;
+    float dir_x;                                  /*!< Unit direction */
+    float dir_y;
+    float distance;
+    float velocity;                               /*!< Release velocity (fling) or peak velocity (stop), units/s */
+    uint32_t accel_us;                            /*!< Fling: constant acceleration phase before cruising */
+    uint32_t move_us;                             /*!< Time until the end point is reached */
+    bool fling;
+} hid_traj_fling_t;
+
+/**
+ * @brief Clamp a normalized coordinate to [0, 1] and scale it to 0..HID_ABS_MAX_COORD.
+ */
+uint16_t hid_traj_map_normalized(float value);
+
+/**
+ * @brief Clamp a Q28 coordinate to [0, HID_FX_ONE] and scale it to 0..HID_ABS_MAX_COORD.
+ *        Gives the same result as hid_traj_map_normalized() for the same value.
+ */
+uint16_t hid_traj_map_fx(int32_t q);
+
+int32_t hid_traj_to_fx(float value);
+
+void hid_traj_swipe_init_f(hid_traj_swipe_f_t *traj, float start_x, float start_y,
+                           float end_x, float end_y, uint32_t steps);
+void hid_traj_swipe_point_f(const hid_traj_swipe_f_t *traj, uint32_t step, uint16_t *x, uint16_t *y);
+
+void hid_traj_swipe_init_fx(hid_traj_swipe_fx_t *traj, float start_x, float start_y,
+                            float end_x, float end_y, uint32_t steps);
+void hid_traj_swipe_point_fx(const hid_traj_swipe_fx_t *traj, uint32_t step, uint16_t *x, uint16_t *y);
+
+/**
+ * @brief Set up a two-finger trajectory. Spreads are finger-to-finger distances and angles are
+ *        degrees of the finger axis, clockwise on screen since y grows downwards. A pinch keeps
+ *        the angle and a rotate keeps the spread. The rotation is limited to one turn.
+ */
+void hid_traj_pair_init_f(hid_traj_pair_f_t *traj, float center_x, float center_y, float start_spread,
+                          float end_spread, float start_deg, float end_deg, uint32_t steps);
+void hid_traj_pair_point_f(const hid_traj_pair_f_t *traj, uint32_t step, uint16_t xs[2], uint16_t ys[2]);
+
+void hid_traj_pair_init_fx(hid_traj_pair_fx_t *traj, float center_x, float center_y, float start_spread,
+                           float end_spread, float start_deg, float end_deg, uint32_t steps);
+void hid_traj_pair_point_fx(const hid_traj_pair_fx_t *traj, uint32_t step, uint16_t xs[2], uint16_t ys[2]);
+
+/**
+ * @brief Number of segments of a path, 0 when the point count does not fit its kind.
+ */
+uint32_t hid_traj_path_segments(const hid_traj_path_t *path);
+
+/**
+ * @brief Measure the path and split its time over the segments: by the per-segment speeds
+ *        when all of them are set, otherwise duration_ms spread in proportion to length
+ *        so the speed is constant.
+ *
+ * @return false for an invalid path
+ */
+bool hid_traj_path_begin(hid_traj_path_walk_t *walk, const hid_traj_path_t *path, uint32_t duration_ms);
+
+/**
+ * @brief Point reached at t_us. t_us must not decrease between calls.
+ */
+void hid_traj_path_at(hid_traj_path_walk_t *walk, uint32_t t_us, uint16_t *x, uint16_t *y);
+
+/**
+ * @brief Set up a fling or a stopping scroll along angle_deg (0 = right, 90 = down).
+ *
+ *        A fling accelerates from rest and then moves at exactly velocity for the last
+ *        velocity window before it reaches the end, so the host measures that speed at the
+ *        lift. A stop eases in and out with velocity as its peak speed and comes to rest at
+ *        the end point; the caller holds it for HID_TRAJ_FLING_SETTLE_MS before lifting.
+ *        distance is clamped to HID_TRAJ_FLING_MAX_DISTANCE.
+ */
+void hid_traj_fling_init(hid_traj_fling_t *traj, float start_x, float start_y, float angle_deg,
+                         float distance, float velocity, bool fling);
+
+/**
+ * @brief Point reached at t_us, the end point from move_us on.
+ */
+void hid_traj_fling_at(const hid_traj_fling_t *traj, uint32_t t_us, uint16_t *x, uint16_t *y);
+
+/*
+ * Kernel selected for this target. Both produce the same mapped coordinates to within 1 LSB.
+ */
+#if HID_TRAJ_FIXED_POINT
+typedef hid_traj_swipe_fx_t hid_traj_swipe_t;
+
+static inline void hid_traj_swipe_init(hid_traj_swipe_t *traj, float start_x, float start_y,
+                                       float end_x, float end_y, uint32_t steps)
+{
+    hid_traj_swipe_init_fx(traj, start_x, start_y, end_x, end_y, steps);
+}
+
+static inline void hid_traj_swipe_point(const hid_traj_swipe_t *traj, uint32_t step, uint16_t *x, uint16_t *y)
+{
+    hid_traj_swipe_point_fx(traj, step, x, y);
+}
+
+typedef hid_traj_pair_fx_t hid_traj_pair_t;
+
+static inline void hid_traj_pair_init(hid_traj_pair_t *traj, float center_x, float center_y, float start_spread,
+                                      float end_spread, float start_deg, float end_deg, uint32_t steps)
+{
+    hid_traj_pair_init_fx(traj, center_x, center_y, start_spread, end_spread, start_deg, end_deg, steps);
+}
+
+static inline void hid_traj_pair_point(const hid_traj_pair_t *traj, uint32_t step, uint16_t xs[2], uint16_t ys[2])
+{
+    hid_traj_pair_point_fx(traj, step, xs, ys);
+}
+#else
+typedef hid_traj_swipe_f_t hid_traj_swipe_t;
+
+static inline void hid_traj_swipe_init(hid_traj_swipe_t *traj, float start_x, float start_y,
+                                       float end_x, float end_y, uint32_t steps)
+{
+    hid_traj_swipe_init_f(traj, start_x, start_y, end_x, end_y, steps);
+}
+
+static inline void hid_traj_swipe_point(const hid_traj_swipe_t *traj, uint32_t step, uint16_t *x, uint16_t *y)
+{
+    hid_traj_swipe_point_f(traj, step, x, y);
+}
+
+typedef hid_traj_pair_f_t hid_traj_pair_t;
+
+static inline void hid_traj_pair_init(hid_traj_pair_t *traj, float center_x, float center_y, float start_spread,
+                                      float end_spread, float start_deg, float end_deg, uint32_t steps)
+{
+    hid_traj_pair_init_f(traj, center_x, center_y, start_spread, end_spread, start_deg, end_deg, steps);
+}
+
+static inline void hid_traj_pair_point(const hid_traj_pair_t *traj, uint32_t step, uint16_t xs[2], uint16_t ys[2])
+{
+    hid_traj_pair_point_f(traj, step, xs, ys);
+}
+#endif
+
+#endif /* HID_TRAJECTORY_H */
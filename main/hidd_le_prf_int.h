@@ -30,19 +30,13 @@
 #define HIDD_SUB_VER     0x00  //Version + Subversion
 #define HIDD_VERSION     ((HIDD_GREAT_VER<<8)|HIDD_SUB_VER)  //Version + Subversion
 
-#define HID_MAX_APPS                 1
+#define HID_MAX_APPS                 HID_MAX_LINKS
 
 // Number of HID reports defined in the service
 #define HID_NUM_REPORTS          9
 
-// HID Report IDs for the service
-#define HID_RPT_ID_MOUSE_IN      1   // Mouse input report ID
-#define HID_RPT_ID_KEY_IN        2   // Keyboard input report ID
-#define HID_RPT_ID_CC_IN         3   //Consumer Control input report ID
-#define HID_RPT_ID_TOUCH_IN      4   // Touch input report ID
-#define HID_RPT_ID_VENDOR_OUT    5   // Vendor output report ID
-#define HID_RPT_ID_LED_OUT       2  // LED output report ID
-#define HID_RPT_ID_FEATURE       0  // Feature report ID
+// HID report IDs (HID_RPT_ID_*), lengths (HID_RPT_LEN_*) and report types
+#include "hid_report_schema.h"
 
 #define HIDD_APP_ID			0x1812//ATT_SVC_HID
 
@@ -91,12 +85,6 @@
 // HID feature flags
 #define HID_KBD_FLAGS             HID_FLAGS_REMOTE_WAKE
 
-/* HID Report type */
-#define HID_REPORT_TYPE_INPUT       1
-#define HID_REPORT_TYPE_OUTPUT      2
-#define HID_REPORT_TYPE_FEATURE     3
-
-
 /// HID Service Attributes Indexes
 enum {
     HIDD_LE_IDX_SVC,
@@ -258,7 +246,9 @@ typedef struct {
     esp_bd_addr_t         remote_bda;
     uint32_t                  trans_id;
     uint8_t                    cur_srvc_id;
-
+    bool                        secured;
+    uint16_t                  notify_mask;       // Bit per input report ID with notifications enabled
+    uint32_t                  seq;               // Connection order
 } hidd_clcb_t;
 
 // HID report mapping table
@@ -329,6 +319,8 @@ void hidd_clcb_alloc (uint16_t conn_id, esp_bd_addr_t bda);
 
 bool hidd_clcb_dealloc (uint16_t conn_id);
 
+hidd_clcb_t *hidd_clcb_find (uint16_t conn_id);
+
 void hidd_le_create_service(esp_gatt_if_t gatts_if);
 
 void hidd_set_attr_value(uint16_t handle, uint16_t val_len, const uint8_t *value);
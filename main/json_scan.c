@@ -0,0 +1,647 @@
+/*
+ * JSON scanner implementation.
+ *
+ * The scanner is a small state machine over the grammar with one bit per open container to
+ * tell objects from arrays, so validation costs nothing beyond the single pass.
+ */
+
+#include "json_scan.h"
+
+#include <float.h>
+#include <string.h>
+
+// What the scanner accepts next
+enum {
+    JSON_SCAN_VALUE,            /*!< Document start or after ':' */
+    JSON_SCAN_VALUE_OR_END,     /*!< After '[' */
+    JSON_SCAN_KEY,              /*!< After ',' in an object */
+    JSON_SCAN_KEY_OR_END,       /*!< After '{' */
+    JSON_SCAN_COMMA_OR_END,     /*!< After a value inside a container */
+    JSON_SCAN_DONE,             /*!< After the top-level value */
+    JSON_SCAN_FAILED,
+};
+
+#define JSON_MANTISSA_LIMIT 100000000u // One more digit still fits 9 digits in a uint32_t
+
+static const float s_pow10[] = {
+    1e0f,  1e1f,  1e2f,  1e3f,  1e4f,  1e5f,  1e6f,  1e7f,  1e8f,  1e9f,  1e10f, 1e11f, 1e12f,
+    1e13f, 1e14f, 1e15f, 1e16f, 1e17f, 1e18f, 1e19f, 1e20f, 1e21f, 1e22f, 1e23f, 1e24f, 1e25f,
+    1e26f, 1e27f, 1e28f, 1e29f, 1e30f, 1e31f, 1e32f, 1e33f, 1e34f, 1e35f, 1e36f, 1e37f, 1e38f,
+};
+#define JSON_MAX_POW10 ((int)(sizeof(s_pow10) / sizeof(s_pow10[0])) - 1)
+
+static bool json_is_digit(char c)
+{
+    return c >= '0' && c <= '9';
+}
+
+static bool json_is_hex(char c)
+{
+    return json_is_digit(c) || (c >= 'a' && c <= 'f') || (c >= 'A' && c <= 'F');
+}
+
+static void json_skip_space(json_scan_t *scan)
+{
+    while (scan->p < scan->end && (*scan->p == ' ' || *scan->p == '\t' || *scan->p == '\n' || *scan->p == '\r'))
+    {
+        scan->p++;
+    }
+}
+
+static json_tok_type_t json_fail(json_scan_t *scan, json_tok_t *tok)
+{
+    scan->state = JSON_SCAN_FAILED;
+    tok->type = JSON_TOK_ERROR;
+    return JSON_TOK_ERROR;
+}
+
+static bool json_in_object(const json_scan_t *scan)
+{
+    return scan->depth > 0 && (scan->objects >> (scan->depth - 1)) & 1u;
+}
+
+static void json_after_value(json_scan_t *scan)
+{
+    scan->state = scan->depth == 0 ? JSON_SCAN_DONE : JSON_SCAN_COMMA_OR_END;
+}
+
+static bool json_push(json_scan_t *scan, bool object)
+{
+    if (scan->depth == JSON_SCAN_MAX_DEPTH)
+    {
+        return false;
+    }
+    if (object)
+    {
+        scan->objects |= 1u << scan->depth;
+    }
+    else
+    {
+        scan->objects &= ~(1u << scan->depth);
+    }
+    scan->depth++;
+    return true;
+}
+
+static json_tok_type_t json_pop(json_scan_t *scan, json_tok_t *tok, char close)
+{
+    const bool object = json_in_object(scan);
+    if (scan->depth == 0 || close != (object ? '}' : ']'))
+    {
+        return json_fail(scan, tok);
+    }
+    scan->p++;
+    scan->depth--;
+    json_after_value(scan);
+    tok->type = object ? JSON_TOK_OBJECT_END : JSON_TOK_ARRAY_END;
+    return tok->type;
+}
+
+static bool json_read_string(json_scan_t *scan, json_tok_t *tok)
+{
+    const char *p = scan->p + 1;
+    tok->str = p;
+    tok->escaped = false;
+
+    while (p < scan->end && *p != '"')
+    {
+        if ((unsigned char)*p < 0x20)
+        {
+            return false;
+        }
+        if (*p == '\\')
+        {
+            tok->escaped = true;
+            if (++p == scan->end)
+            {
+                return false;
+            }
+            if (*p == 'u')
+            {
+                if (scan->end - p < 5 || !json_is_hex(p[1]) || !json_is_hex(p[2]) || !json_is_hex(p[3]) ||
+                    !json_is_hex(p[4]))
+                {
+                    return false;
+                }
+                p += 4;
+            }
+            else if (!strchr("\"\\/bfnrt", *p))
+            {
+                return false;
+            }
+        }
+        p++;
+    }
+    if (p == scan->end)
+    {
+        return false;
+    }
+
+    tok->len = (size_t)(p - tok->str);
+    scan->p = p + 1;
+    return true;
+}
+
+static bool json_read_number(json_scan_t *scan, json_tok_t *tok)
+{
+    const char *p = scan->p;
+    const char *end = scan->end;
+
+    const bool negative = *p == '-';
+    if (negative)
+    {
+        p++;
+    }
+    if (p == end || !json_is_digit(*p))
+    {
+        return false;
+    }
+
+    uint32_t mantissa = 0;
+    int exp10 = 0;
+    bool integral = true;
+
+    if (*p == '0')
+    {
+        p++; // no leading zeros in JSON
+    }
+    else
+    {
+        for (; p < end && json_is_digit(*p); ++p)
+        {
+            if (mantissa < JSON_MANTISSA_LIMIT)
+            {
+                mantissa = mantissa * 10 + (uint32_t)(*p - '0');
+            }
+            else
+            {
+                exp10++;
+            }
+        }
+    }
+
+    if (p < end && *p == '.')
+    {
+        integral = false;
+        if (++p == end || !json_is_digit(*p))
+        {
+            return false;
+        }
+        for (; p < end && json_is_digit(*p); ++p)
+        {
+            if (mantissa < JSON_MANTISSA_LIMIT)
+            {
+                mantissa = mantissa * 10 + (uint32_t)(*p - '0');
+                exp10--;
+            }
+        }
+    }
+
+    if (p < end && (*p == 'e' || *p == 'E'))
+    {
+        integral = false;
+        ++p;
+        int sign = 1;
+        if (p < end && (*p == '+' || *p == '-'))
+        {
+            sign = (*p == '-') ? -1 : 1;
+            ++p;
+        }
+        if (p == end || !json_is_digit(*p))
+        {
+            return false;
+        }
+        int e = 0;
+        for (; p < end && json_is_digit(*p); ++p)
+        {
+            if (e < 1000)
+            {
+                e = e * 10 + (*p - '0');
+            }
+        }
+        exp10 += sign * e;
+    }
+
+    float value = (float)mantissa;
+    if (mantissa != 0 && exp10 > 0)
+    {
+        if (exp10 > JSON_MAX_POW10)
+        {
+            return false; // beyond float range
+        }
+        value *= s_pow10[exp10];
+        if (value > FLT_MAX)
+        {
+            return false; // e.g. 0.5e39 or a 39-digit integer, past FLT_MAX after scaling
+        }
+    }
+    else if (mantissa != 0 && exp10 < 0)
+    {
+        int div = -exp10;
+        while (div > JSON_MAX_POW10 && value != 0.0f)
+        {
+            value /= s_pow10[JSON_MAX_POW10];
+            div -= JSON_MAX_POW10;
+        }
+        value /= s_pow10[div > JSON_MAX_POW10 ? JSON_MAX_POW10 : div];
+    }
+
+    tok->num = negative ? -value : value;
+    tok->integral = integral && exp10 == 0 && !negative;
+    tok->uint = tok->integral ? mantissa : 0;
+    scan->p = p;
+    return true;
+}
+
+static bool json_read_literal(json_scan_t *scan, const char *literal)
+{
+    const size_t len = strlen(literal);
+    if ((size_t)(scan->end - scan->p) < len || memcmp(scan->p, literal, len) != 0)
+    {
+        return false;
+    }
+    scan->p += len;
+    return true;
+}
+
+static json_tok_type_t json_read_value(json_scan_t *scan, json_tok_t *tok)
+{
+    const char c = *scan->p;
+    switch (c)
+    {
+    case '{':
+    case '[':
+        if (!json_push(scan, c == '{'))
+        {
+            return json_fail(scan, tok);
+        }
+        scan->p++;
+        scan->state = (c == '{') ? JSON_SCAN_KEY_OR_END : JSON_SCAN_VALUE_OR_END;
+        tok->type = (c == '{') ? JSON_TOK_OBJECT_BEGIN : JSON_TOK_ARRAY_BEGIN;
+        return tok->type;
+    case '"':
+        if (!json_read_string(scan, tok))
+        {
+            return json_fail(scan, tok);
+        }
+        tok->type = JSON_TOK_STRING;
+        break;
+    case 't':
+        if (!json_read_literal(scan, "true"))
+        {
+            return json_fail(scan, tok);
+        }
+        tok->type = JSON_TOK_TRUE;
+        break;
+    case 'f':
+        if (!json_read_literal(scan, "false"))
+        {
+            return json_fail(scan, tok);
+        }
+        tok->type = JSON_TOK_FALSE;
+        break;
+    case 'n':
+        if (!json_read_literal(scan, "null"))
+        {
+            return json_fail(scan, tok);
+        }
+        tok->type = JSON_TOK_NULL;
+        break;
+    default:
+        if (!json_read_number(scan, tok))
+        {
+            return json_fail(scan, tok);
+        }
+        tok->type = JSON_TOK_NUMBER;
+        break;
+    }
+
+    json_after_value(scan);
+    return tok->type;
+}
+
+static json_tok_type_t json_read_key(json_scan_t *scan, json_tok_t *tok)
+{
+    if (*scan->p != '"' || !json_read_string(scan, tok))
+    {
+        return json_fail(scan, tok);
+    }
+    json_skip_space(scan);
+    if (scan->p == scan->end || *scan->p != ':')
+    {
+        return json_fail(scan, tok);
+    }
+    scan->p++;
+    scan->state = JSON_SCAN_VALUE;
+    tok->type = JSON_TOK_KEY;
+    return JSON_TOK_KEY;
+}
+
+void json_scan_init(json_scan_t *scan, const char *json, size_t len)
+{
+    memset(scan, 0, sizeof(*scan));
+    scan->p = json;
+    scan->end = json + len;
+    scan->state = JSON_SCAN_VALUE;
+}
+
+json_tok_type_t json_scan_next(json_scan_t *scan, json_tok_t *tok)
+{
+    if (scan->state == JSON_SCAN_FAILED)
+    {
+        return json_fail(scan, tok);
+    }
+
+    json_skip_space(scan);
+    if (scan->p == scan->end)
+    {
+        if (scan->state != JSON_SCAN_DONE)
+        {
+            return json_fail(scan, tok);
+        }
+        tok->type = JSON_TOK_END;
+        return JSON_TOK_END;
+    }
+
+    const char c = *scan->p;
+    switch (scan->state)
+    {
+    case JSON_SCAN_VALUE:
+        return json_read_value(scan, tok);
+    case JSON_SCAN_VALUE_OR_END:
+        return (c == ']') ? json_pop(scan, tok, c) : json_read_value(scan, tok);
+    case JSON_SCAN_KEY:
+        return json_read_key(scan, tok);
+    case JSON_SCAN_KEY_OR_END:
+        return (c == '}') ? json_pop(scan, tok, c) : json_read_key(scan, tok);
+    case JSON_SCAN_COMMA_OR_END:
+        if (c == ',')
+        {
+            scan->p++;
+            scan->state = json_in_object(scan) ? JSON_SCAN_KEY : JSON_SCAN_VALUE;
+            return json_scan_next(scan, tok);
+        }
+        return json_pop(scan, tok, c);
+    default:
+        return json_fail(scan, tok); // data after the top-level value
+    }
+}
+
+bool json_scan_skip(json_scan_t *scan, const json_tok_t *value)
+{
+    switch (value->type)
+    {
+    case JSON_TOK_OBJECT_BEGIN:
+    case JSON_TOK_ARRAY_BEGIN:
+    {
+        const uint8_t outer = scan->depth - 1;
+        json_tok_t tok;
+        while (scan->depth > outer)
+        {
+            if (json_scan_next(scan, &tok) == JSON_TOK_ERROR)
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+    case JSON_TOK_STRING:
+    case JSON_TOK_NUMBER:
+    case JSON_TOK_TRUE:
+    case JSON_TOK_FALSE:
+    case JSON_TOK_NULL:
+        return true;
+    default:
+        return false;
+    }
+}
+
+static uint8_t json_hex_value(char c)
+{
+    if (json_is_digit(c))
+    {
+        return (uint8_t)(c - '0');
+    }
+    return (uint8_t)((c | 0x20) - 'a' + 10);
+}
+
+bool json_tok_copy(const json_tok_t *tok, char *out, size_t cap)
+{
+    size_t n = 0;
+    for (size_t i = 0; i < tok->len; ++i)
+    {
+        char c = tok->str[i];
+        if (c == '\\')
+        {
+            c = tok->str[++i];
+            switch (c)
+            {
+            case 'b': c = '\b'; break;
+            case 'f': c = '\f'; break;
+            case 'n': c = '\n'; break;
+            case 'r': c = '\r'; break;
+            case 't': c = '\t'; break;
+            case 'u':
+            {
+                const char *h = &tok->str[i + 1];
+                const uint16_t cp = (uint16_t)(json_hex_value(h[0]) << 12 | json_hex_value(h[1]) << 8 |
+                                               json_hex_value(h[2]) << 4 | json_hex_value(h[3]));
+                c = cp < 0x80 ? (char)cp : '?';
+                i += 4;
+                break;
+            }
+            default:
+                break; // '"', '\\' and '/' stand for themselves
+            }
+        }
+        if (n + 1 >= cap)
+        {
+            return false;
+        }
+        out[n++] = c;
+    }
+    out[n] = '\0';
+    return true;
+}
+
+bool json_tok_equals(const json_tok_t *tok, const char *text)
+{
+    return !tok->escaped && strncmp(tok->str, text, tok->len) == 0 && text[tok->len] == '\0';
+}
+
+static uint32_t json_tok_uint32(const json_tok_t *tok)
+{
+    if (tok->integral)
+    {
+        return tok->uint;
+    }
+    if (tok->num <= 0.0f)
+    {
+        return 0;
+    }
+    if (tok->num >= 4294967040.0f) // largest float below 2^32
+    {
+        return UINT32_MAX;
+    }
+    return (uint32_t)(tok->num + 0.5f);
+}
+
+// Element of a POINTS array: an object with numeric "x" and "y", other keys ignored
+static bool json_read_point(json_scan_t *scan, const json_tok_t *value, float *x, float *y)
+{
+    static const json_field_t fields[] = {
+        { .key = "x", .type = JSON_FIELD_FLOAT, .offset = 0 },
+        { .key = "y", .type = JSON_FIELD_FLOAT, .offset = sizeof(float) },
+    };
+    float xy[2];
+    uint32_t present = 0;
+    if (!json_scan_object(scan, value, fields, 2, xy, &present) || present != 0x3)
+    {
+        return false;
+    }
+    *x = xy[0];
+    *y = xy[1];
+    return true;
+}
+
+static bool json_read_array(json_scan_t *scan, const json_tok_t *value, const json_field_t *field, uint8_t *base)
+{
+    if (value->type != JSON_TOK_ARRAY_BEGIN)
+    {
+        return false;
+    }
+
+    uint32_t count = 0;
+    float *xs = (float *)(base + field->offset);
+    float *ys = (float *)(base + field->offset2);
+    for (;;)
+    {
+        json_tok_t tok;
+        const json_tok_type_t type = json_scan_next(scan, &tok);
+        if (type == JSON_TOK_ARRAY_END)
+        {
+            break;
+        }
+
+        if (field->type == JSON_FIELD_FLOATS)
+        {
+            if (type != JSON_TOK_NUMBER)
+            {
+                return false;
+            }
+            if (count < field->capacity)
+            {
+                xs[count++] = tok.num;
+            }
+        }
+        else if (count < field->capacity)
+        {
+            if (type != JSON_TOK_OBJECT_BEGIN || !json_read_point(scan, &tok, &xs[count], &ys[count]))
+            {
+                return false;
+            }
+            count++;
+        }
+        else if (!json_scan_skip(scan, &tok))
+        {
+            return false;
+        }
+    }
+
+    memcpy(base + field->count_offset, &count, sizeof(count));
+    return true;
+}
+
+static bool json_read_field(json_scan_t *scan, const json_field_t *field, uint8_t *base)
+{
+    json_tok_t tok;
+    const json_tok_type_t type = json_scan_next(scan, &tok);
+
+    switch (field->type)
+    {
+    case JSON_FIELD_FLOAT:
+        if (type != JSON_TOK_NUMBER)
+        {
+            return false;
+        }
+        memcpy(base + field->offset, &tok.num, sizeof(float));
+        return true;
+    case JSON_FIELD_UINT32:
+    {
+        if (type != JSON_TOK_NUMBER)
+        {
+            return false;
+        }
+        const uint32_t value = json_tok_uint32(&tok);
+        memcpy(base + field->offset, &value, sizeof(value));
+        return true;
+    }
+    case JSON_FIELD_STRING:
+        return type == JSON_TOK_STRING && json_tok_copy(&tok, (char *)(base + field->offset), field->capacity);
+    case JSON_FIELD_FLOATS:
+    case JSON_FIELD_POINTS:
+        return json_read_array(scan, &tok, field, base);
+    case JSON_FIELD_CUSTOM:
+        return type != JSON_TOK_ERROR && field->parse(scan, &tok, base);
+    default:
+        return false;
+    }
+}
+
+bool json_scan_object(json_scan_t *scan, const json_tok_t *value, const json_field_t *fields, size_t count,
+                      void *out, uint32_t *present)
+{
+    if (value->type != JSON_TOK_OBJECT_BEGIN)
+    {
+        return false;
+    }
+
+    for (;;)
+    {
+        json_tok_t key;
+        const json_tok_type_t type = json_scan_next(scan, &key);
+        if (type == JSON_TOK_OBJECT_END)
+        {
+            return true;
+        }
+        if (type != JSON_TOK_KEY)
+        {
+            return false;
+        }
+
+        size_t i = 0;
+        while (i < count && !json_tok_equals(&key, fields[i].key))
+        {
+            ++i;
+        }
+
+        if (i == count)
+        {
+            json_tok_t skipped;
+            if (json_scan_next(scan, &skipped) == JSON_TOK_ERROR || !json_scan_skip(scan, &skipped))
+            {
+                return false;
+            }
+            continue;
+        }
+
+        if (!json_read_field(scan, &fields[i], (uint8_t *)out))
+        {
+            return false;
+        }
+        if (present)
+        {
+            *present |= 1u << i;
+        }
+    }
+}
+
+bool json_scan_document(const char *json, size_t len, const json_field_t *fields, size_t count, void *out,
+                        uint32_t *present)
+{
+    json_scan_t scan;
+    json_tok_t tok;
+    json_scan_init(&scan, json, len);
+    return json_scan_next(&scan, &tok) == JSON_TOK_OBJECT_BEGIN &&
+           json_scan_object(&scan, &tok, fields, count, out, present) && json_scan_next(&scan, &tok) == JSON_TOK_END;
+}
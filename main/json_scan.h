@@ -0,0 +1,130 @@
+/*
+ * Single-pass JSON scanner for request bodies: a pull tokenizer over a buffer that allocates
+ * nothing, plus a reader that fills a request struct from a table of fields in the same pass.
+ *
+ * Strings are returned as slices of the buffer; numbers are parsed with a 9-digit integer
+ * mantissa and a float power of ten instead of strtod, which is plenty for coordinates and
+ * durations and avoids double-precision soft-float on the ESP32. A number that does not fit a
+ * finite float is malformed.
+ */
+
+#ifndef JSON_SCAN_H
+#define JSON_SCAN_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#define JSON_SCAN_MAX_DEPTH 32
+
+typedef enum {
+    JSON_TOK_ERROR = 0,         /*!< Malformed input; the scanner stays in this state */
+    JSON_TOK_END,               /*!< The whole document was consumed */
+    JSON_TOK_OBJECT_BEGIN,
+    JSON_TOK_OBJECT_END,
+    JSON_TOK_ARRAY_BEGIN,
+    JSON_TOK_ARRAY_END,
+    JSON_TOK_KEY,
+    JSON_TOK_STRING,
+    JSON_TOK_NUMBER,
+    JSON_TOK_TRUE,
+    JSON_TOK_FALSE,
+    JSON_TOK_NULL,
+} json_tok_type_t;
+
+typedef struct {
+    json_tok_type_t type;
+    const char *str;            /*!< KEY, STRING: raw text between the quotes */
+    size_t len;
+    bool escaped;               /*!< KEY, STRING: the raw text contains escapes */
+    float num;                  /*!< NUMBER */
+    bool integral;              /*!< NUMBER: a non-negative integer held exactly in uint */
+    uint32_t uint;
+} json_tok_t;
+
+typedef struct {
+    const char *p;
+    const char *end;
+    uint32_t objects;           /*!< Bit per open container, set for an object */
+    uint8_t depth;
+    uint8_t state;
+} json_scan_t;
+
+typedef enum {
+    JSON_FIELD_FLOAT,           /*!< float at offset */
+    JSON_FIELD_UINT32,          /*!< uint32_t at offset; negatives clamp to 0, fractions round */
+    JSON_FIELD_STRING,          /*!< char[capacity] at offset, NUL-terminated */
+    JSON_FIELD_FLOATS,          /*!< float[capacity] at offset, count at count_offset */
+    JSON_FIELD_POINTS,          /*!< [{"x":..,"y":..}]: xs at offset, ys at offset2, count at count_offset */
+    JSON_FIELD_CUSTOM,          /*!< parse() reads the value */
+} json_field_type_t;
+
+/**
+ * @brief Reads the value whose first token is value, consuming the rest of it.
+ */
+typedef bool (*json_field_parse_t)(json_scan_t *scan, const json_tok_t *value, void *out);
+
+/// One key of an object; extra array elements beyond capacity are skipped
+typedef struct {
+    const char *key;
+    json_field_type_t type;
+    uint16_t offset;
+    uint16_t offset2;
+    uint16_t count_offset;
+    uint16_t capacity;
+    json_field_parse_t parse;
+} json_field_t;
+
+#define JSON_FIELD_FLOAT_OF(k, st, m) { .key = (k), .type = JSON_FIELD_FLOAT, .offset = offsetof(st, m) }
+#define JSON_FIELD_UINT32_OF(k, st, m) { .key = (k), .type = JSON_FIELD_UINT32, .offset = offsetof(st, m) }
+#define JSON_FIELD_STRING_OF(k, st, m) \
+    { .key = (k), .type = JSON_FIELD_STRING, .offset = offsetof(st, m), .capacity = sizeof(((st *)0)->m) }
+#define JSON_FIELD_FLOATS_OF(k, st, m, n) \
+    { .key = (k), .type = JSON_FIELD_FLOATS, .offset = offsetof(st, m), .count_offset = offsetof(st, n), \
+      .capacity = sizeof(((st *)0)->m) / sizeof(float) }
+#define JSON_FIELD_POINTS_OF(k, st, xs, ys, n) \
+    { .key = (k), .type = JSON_FIELD_POINTS, .offset = offsetof(st, xs), .offset2 = offsetof(st, ys), \
+      .count_offset = offsetof(st, n), .capacity = sizeof(((st *)0)->xs) / sizeof(float) }
+#define JSON_FIELD_CUSTOM_OF(k, fn) { .key = (k), .type = JSON_FIELD_CUSTOM, .parse = (fn) }
+
+void json_scan_init(json_scan_t *scan, const char *json, size_t len);
+
+/**
+ * @brief Next token. Structure is validated as it goes: a missing ':' or ',', an unbalanced
+ *        bracket or trailing data is a JSON_TOK_ERROR.
+ */
+json_tok_type_t json_scan_next(json_scan_t *scan, json_tok_t *tok);
+
+/**
+ * @brief Skip the value whose first token is value, e.g. the value of an unknown key.
+ */
+bool json_scan_skip(json_scan_t *scan, const json_tok_t *value);
+
+/**
+ * @brief Copy a KEY or STRING token, decoding escapes. \u escapes outside ASCII become '?'.
+ *
+ * @return false if it does not fit in cap bytes with the terminating NUL
+ */
+bool json_tok_copy(const json_tok_t *tok, char *out, size_t cap);
+
+/**
+ * @brief Whether a KEY or STRING token is exactly text.
+ */
+bool json_tok_equals(const json_tok_t *tok, const char *text);
+
+/**
+ * @brief Read the object whose '{' is value into out. Keys match exactly and at this level
+ *        only; unknown keys are skipped. Bit i of *present is set for fields[i] (count <= 32).
+ *
+ * @return false on malformed JSON or a value of the wrong type
+ */
+bool json_scan_object(json_scan_t *scan, const json_tok_t *value, const json_field_t *fields, size_t count,
+                      void *out, uint32_t *present);
+
+/**
+ * @brief Parse a whole document that must be one object, see json_scan_object().
+ */
+bool json_scan_document(const char *json, size_t len, const json_field_t *fields, size_t count, void *out,
+                        uint32_t *present);
+
+#endif /* JSON_SCAN_H */
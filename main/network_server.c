@@ -4,7 +4,9 @@
 
 #include "network_server.h"
 
+#include <assert.h>
 #include <string.h>
+#include <strings.h>
 #include <stdlib.h>
 #include <stdio.h>
 #include <stdbool.h>
@@ -16,15 +18,28 @@
 #include "freertos/event_groups.h"
 #include "freertos/task.h"
 
+#include "esp_attr.h"
 #include "esp_event.h"
 #include "esp_check.h"
 #include "esp_log.h"
 #include "esp_netif.h"
+#include "esp_timer.h"
 #include "esp_wifi.h"
 #include "esp_http_server.h"
 #include "lwip/ip4_addr.h"
+#include "lwip/sockets.h"
 
+#include "esp_hidd_prf_api.h"
 #include "hid_actions.h"
+#include "hid_coalesce.h"
+#include "hid_dev.h"
+#include "hid_executor.h"
+#include "hid_gesture.h"
+#include "hid_link.h"
+#include "hid_keyboard.h"
+#include "hid_live.h"
+#include "hid_replay.h"
+#include "json_scan.h"
 
 #define WIFI_SSID "navy"
 #define WIFI_PASS "Whj5201314"
@@ -33,21 +48,41 @@
 
 #define WIFI_CONNECTED_BIT BIT0
 
+#define HTTP_BODY_MAX_BYTES CONFIG_HID_HTTP_BODY_MAX_BYTES // A longer body is answered 413 before any of it is read
+#define HTTP_BODY_BUFFERS 1 // Handlers run one at a time on the server task, so one buffer serves every socket
+#define BINARY_CONTENT_TYPE "application/octet-stream" // Selects binary command bodies, see decode_request()
+#define TEXT_STREAM_CHUNK_BYTES 256 // Body read per httpd_req_recv() when streaming text
+#define LIVE_WS_MAX_MESSAGE (32 * HID_LIVE_RECORD_LEN)
+#define LIVE_WS_SESSIONS 2 // Live input WebSockets open at once
+
+#define UDP_INPUT_PORT 4210 // Live touch state datagrams, see hid_live.h; 0 disables the listener
+#define UDP_INPUT_TASK_STACK 4096
+#define UDP_INPUT_TASK_PRIO 5 // Same as the HTTP server
+#define UDP_INPUT_POLL_MS 100 // Receive timeout, how often a silent sender is checked
+#define UDP_INPUT_SESSION_MS 5000 // A sender silent this long ends its session, freeing the link to relax
+
 static const char *TAG = "NET_SERVER";
 
 static EventGroupHandle_t s_wifi_event_group;
 static esp_netif_t *s_sta_netif;
 static bool s_static_ip_enabled = false;
-static uint16_t s_hid_conn_id = UINT16_MAX;
 static httpd_handle_t s_httpd = NULL;
+static TaskHandle_t s_udp_task = NULL;
+
+typedef struct
+{
+    char data[HTTP_BODY_MAX_BYTES + 1];
+    bool used;
+} body_buffer_t;
+
+static body_buffer_t s_body_buffers[HTTP_BODY_BUFFERS];
+static portMUX_TYPE s_body_lock = portMUX_INITIALIZER_UNLOCKED;
 
 static esp_err_t start_http_server(void);
 static esp_err_t stop_http_server(void);
-
-void network_server_set_hid_conn_id(uint16_t conn_id)
-{
-    s_hid_conn_id = conn_id;
-}
+#if UDP_INPUT_PORT
+static void start_udp_input(void);
+#endif
 
 static void log_current_ip(void)
 {
@@ -153,6 +188,56 @@ static esp_err_t init_wifi(void)
     return ESP_OK;
 }
 
+#if CONFIG_HID_REQUEST_HEAP_CHECK
+/*
+ * Debug check that the request path stays off the heap after boot, enabled by
+ * CONFIG_HID_REQUEST_HEAP_CHECK (which selects CONFIG_HEAP_USE_HOOKS). Allocations made by the
+ * HTTP server task are counted from the moment a body is read until its job is queued, and
+ * any there trip an assert. A request that ends in an error response is disarmed unchecked.
+ */
+static TaskHandle_t s_request_task;
+static volatile uint32_t s_request_allocs;
+
+void IRAM_ATTR esp_heap_trace_alloc_hook(void *ptr, size_t size, uint32_t caps)
+{
+    if (s_request_task && s_request_task == xTaskGetCurrentTaskHandle())
+    {
+        s_request_allocs++;
+    }
+}
+
+static void request_heap_begin(void)
+{
+    s_request_allocs = 0;
+    s_request_task = xTaskGetCurrentTaskHandle();
+}
+
+static void request_heap_end(void)
+{
+    s_request_task = NULL;
+}
+
+static void request_heap_check(void)
+{
+    request_heap_end();
+    if (s_request_allocs != 0)
+    {
+        ESP_LOGE(TAG, "%lu heap allocations on the request path", (unsigned long)s_request_allocs);
+    }
+    assert(s_request_allocs == 0);
+}
+#else
+static inline void request_heap_begin(void) {}
+static inline void request_heap_end(void) {}
+static inline void request_heap_check(void) {}
+#endif
+
+/*
+ * Receives the body into a pooled buffer, NUL-terminated; give it back with release_body().
+ *
+ * ESP_ERR_INVALID_SIZE: longer than HTTP_BODY_MAX_BYTES, nothing was read.
+ * ESP_ERR_NO_MEM: every buffer is in use.
+ */
 static esp_err_t read_body(httpd_req_t *req, char **out_buf, size_t *out_len)
 {
     size_t total_len = req->content_len;
@@ -162,20 +247,36 @@ static esp_err_t read_body(httpd_req_t *req, char **out_buf, size_t *out_len)
         *out_len = 0;
         return ESP_OK;
     }
+    if (total_len > HTTP_BODY_MAX_BYTES)
+    {
+        return ESP_ERR_INVALID_SIZE;
+    }
 
-    char *buf = (char *)malloc(total_len + 1);
-    if (!buf)
+    body_buffer_t *slot = NULL;
+    taskENTER_CRITICAL(&s_body_lock);
+    for (int i = 0; i < HTTP_BODY_BUFFERS; ++i)
+    {
+        if (!s_body_buffers[i].used)
+        {
+            s_body_buffers[i].used = true;
+            slot = &s_body_buffers[i];
+            break;
+        }
+    }
+    taskEXIT_CRITICAL(&s_body_lock);
+    if (!slot)
     {
         return ESP_ERR_NO_MEM;
     }
 
+    char *buf = slot->data;
     size_t received = 0;
     while (received < total_len)
     {
         int r = httpd_req_recv(req, buf + received, total_len - received);
         if (r <= 0)
         {
-            free(buf);
+            slot->used = false;
             return ESP_FAIL;
         }
         received += r;
@@ -187,354 +288,920 @@ static esp_err_t read_body(httpd_req_t *req, char **out_buf, size_t *out_len)
     return ESP_OK;
 }
 
-static esp_err_t respond_json_ok(httpd_req_t *req)
+static void release_body(char *buf)
 {
-    const char *resp = "{\"status\":\"ok\"}";
+    for (int i = 0; i < HTTP_BODY_BUFFERS; ++i)
+    {
+        if (s_body_buffers[i].data == buf)
+        {
+            taskENTER_CRITICAL(&s_body_lock);
+            s_body_buffers[i].used = false;
+            taskEXIT_CRITICAL(&s_body_lock);
+            return;
+        }
+    }
+}
+
+static const char *http_status_text(int status)
+{
+    switch (status)
+    {
+    case 404:
+        return "Not Found";
+    case 413:
+        return "Payload Too Large";
+    case 429:
+        return "Too Many Requests";
+    case 503:
+        return "Service Unavailable";
+    default:
+        return (status >= 500) ? "Server Error" : "Bad Request";
+    }
+}
+
+static esp_err_t respond_job_accepted(httpd_req_t *req, uint32_t job_id)
+{
+    char resp[48];
+    snprintf(resp, sizeof(resp), "{\"status\":\"queued\",\"job_id\":%lu}", (unsigned long)job_id);
+    httpd_resp_set_status(req, "202 Accepted");
     httpd_resp_set_type(req, "application/json");
     return httpd_resp_send(req, resp, HTTPD_RESP_USE_STRLEN);
 }
 
 static esp_err_t respond_error(httpd_req_t *req, int status, const char *message)
 {
+    request_heap_end(); // Every failed request, from read_command() on, ends here
     char status_str[40];
-    snprintf(status_str, sizeof(status_str), "%d %s", status, (status >= 500) ? "Server Error" : "Bad Request");
+    snprintf(status_str, sizeof(status_str), "%d %s", status, http_status_text(status));
     httpd_resp_set_status(req, status_str);
     httpd_resp_set_type(req, "text/plain");
     const char *body = message ? message : "error";
     return httpd_resp_send(req, body, HTTPD_RESP_USE_STRLEN);
 }
 
-static bool parse_number_field(const char *json, const char *field, double *out)
+/// Fills out from a binary body, the counterpart of a JSON field table
+typedef bool (*binary_decode_t)(const uint8_t *data, size_t len, void *out, uint32_t *present);
+
+static bool is_binary_body(httpd_req_t *req)
+{
+    char type[64];
+    return httpd_req_get_hdr_value_str(req, "Content-Type", type, sizeof(type)) == ESP_OK &&
+           strncasecmp(type, BINARY_CONTENT_TYPE, strlen(BINARY_CONTENT_TYPE)) == 0;
+}
+
+/*
+ * Receives the body and reads it into out: with decode when its Content-Type is
+ * BINARY_CONTENT_TYPE, otherwise as JSON with fields. On failure the error response has been
+ * sent and false is returned; an empty body is accepted when optional. *error, when error is
+ * given and it was set while reading, replaces the generic reason.
+ */
+static bool read_command(httpd_req_t *req, const json_field_t *fields, size_t count, binary_decode_t decode, void *out,
+                         uint32_t *present, bool optional, const char *const *error)
 {
-    char pattern[32];
-    snprintf(pattern, sizeof(pattern), "\"%s\"", field);
-    const char *pos = strstr(json, pattern);
-    if (!pos)
+    request_heap_begin();
+
+    char *body = NULL;
+    size_t len = 0;
+    esp_err_t err = read_body(req, &body, &len);
+    if (err == ESP_ERR_INVALID_SIZE)
     {
+        respond_error(req, 413, "Body too large");
         return false;
     }
-    pos += strlen(pattern);
-    pos = strchr(pos, ':');
-    if (!pos)
+    if (err == ESP_ERR_NO_MEM)
     {
+        respond_error(req, 429, "Body buffers busy");
         return false;
     }
-    pos++;
-    while (*pos && isspace((unsigned char)*pos))
+    if (err != ESP_OK)
     {
-        pos++;
+        respond_error(req, 500, "Failed to read body");
+        return false;
     }
-    char *endptr;
-    double value = strtod(pos, &endptr);
-    if (endptr == pos)
+    if (!body)
     {
-        return false;
+        if (!optional)
+        {
+            respond_error(req, 400, "Missing body");
+        }
+        return optional;
     }
-    *out = value;
-    return true;
+
+    const bool binary = is_binary_body(req);
+    bool ok = binary ? decode((const uint8_t *)body, len, out, present)
+                     : json_scan_document(body, len, fields, count, out, present);
+    release_body(body);
+
+    if (!ok)
+    {
+        const char *reason = binary ? "Malformed command" : "Malformed JSON";
+        respond_error(req, 400, (error && *error) ? *error : reason);
+    }
+    return ok;
+}
+
+/*
+ * Every field an action body may carry. A body is scanned once into this struct; keys match
+ * exactly and only at the top level of the object, so "x" never picks up "start_x" or a key
+ * inside a nested point. Which fields were present is bit REQ_* of present.
+ */
+typedef struct
+{
+    uint32_t present;
+    float x, y;
+    float start_x, start_y, end_x, end_y;
+    float spread, start_spread, end_spread;
+    float angle, start_angle, end_angle;
+    float distance, velocity;
+    uint32_t duration_ms;
+    uint32_t delay_ms;
+    uint32_t ms;
+    char action[24];
+    char curve[16];
+    char direction[8];
+    char mode[8];
+    uint32_t point_count;
+    float xs[HID_TRAJ_PATH_MAX_POINTS];
+    float ys[HID_TRAJ_PATH_MAX_POINTS];
+    uint32_t speed_count;
+    float speeds[HID_TRAJ_PATH_MAX_POINTS - 1];
+} api_request_t;
+
+_Static_assert(HID_TRAJ_PATH_MAX_POINTS >= HID_ACTION_MAX_POINTS, "points buffer too small for multi-touch");
+
+// Also the field numbers of binary bodies: append new fields, never reorder
+enum
+{
+    REQ_X,
+    REQ_Y,
+    REQ_START_X,
+    REQ_START_Y,
+    REQ_END_X,
+    REQ_END_Y,
+    REQ_SPREAD,
+    REQ_START_SPREAD,
+    REQ_END_SPREAD,
+    REQ_ANGLE,
+    REQ_START_ANGLE,
+    REQ_END_ANGLE,
+    REQ_DISTANCE,
+    REQ_VELOCITY,
+    REQ_DURATION_MS,
+    REQ_DELAY_MS,
+    REQ_MS,
+    REQ_ACTION,
+    REQ_CURVE,
+    REQ_DIRECTION,
+    REQ_MODE,
+    REQ_POINTS,
+    REQ_SPEEDS,
+    REQ_FIELD_COUNT,
+};
+
+#define REQ_BIT(field) (1u << (field))
+
+static const json_field_t s_request_fields[REQ_FIELD_COUNT] = {
+    [REQ_X] = JSON_FIELD_FLOAT_OF("x", api_request_t, x),
+    [REQ_Y] = JSON_FIELD_FLOAT_OF("y", api_request_t, y),
+    [REQ_START_X] = JSON_FIELD_FLOAT_OF("start_x", api_request_t, start_x),
+    [REQ_START_Y] = JSON_FIELD_FLOAT_OF("start_y", api_request_t, start_y),
+    [REQ_END_X] = JSON_FIELD_FLOAT_OF("end_x", api_request_t, end_x),
+    [REQ_END_Y] = JSON_FIELD_FLOAT_OF("end_y", api_request_t, end_y),
+    [REQ_SPREAD] = JSON_FIELD_FLOAT_OF("spread", api_request_t, spread),
+    [REQ_START_SPREAD] = JSON_FIELD_FLOAT_OF("start_spread", api_request_t, start_spread),
+    [REQ_END_SPREAD] = JSON_FIELD_FLOAT_OF("end_spread", api_request_t, end_spread),
+    [REQ_ANGLE] = JSON_FIELD_FLOAT_OF("angle", api_request_t, angle),
+    [REQ_START_ANGLE] = JSON_FIELD_FLOAT_OF("start_angle", api_request_t, start_angle),
+    [REQ_END_ANGLE] = JSON_FIELD_FLOAT_OF("end_angle", api_request_t, end_angle),
+    [REQ_DISTANCE] = JSON_FIELD_FLOAT_OF("distance", api_request_t, distance),
+    [REQ_VELOCITY] = JSON_FIELD_FLOAT_OF("velocity", api_request_t, velocity),
+    [REQ_DURATION_MS] = JSON_FIELD_UINT32_OF("duration_ms", api_request_t, duration_ms),
+    [REQ_DELAY_MS] = JSON_FIELD_UINT32_OF("delay_ms", api_request_t, delay_ms),
+    [REQ_MS] = JSON_FIELD_UINT32_OF("ms", api_request_t, ms),
+    [REQ_ACTION] = JSON_FIELD_STRING_OF("action", api_request_t, action),
+    [REQ_CURVE] = JSON_FIELD_STRING_OF("curve", api_request_t, curve),
+    [REQ_DIRECTION] = JSON_FIELD_STRING_OF("direction", api_request_t, direction),
+    [REQ_MODE] = JSON_FIELD_STRING_OF("mode", api_request_t, mode),
+    [REQ_POINTS] = JSON_FIELD_POINTS_OF("points", api_request_t, xs, ys, point_count),
+    [REQ_SPEEDS] = JSON_FIELD_FLOATS_OF("speeds", api_request_t, speeds, speed_count),
+};
+
+static bool request_has(const api_request_t *request, uint32_t bits)
+{
+    return (request->present & bits) == bits;
+}
+
+/*
+ * Binary bodies carry the same fields as JSON, each as its REQ_* number in one byte followed
+ * by a little-endian value of the field's wire kind:
+ *
+ *   COORD   u16  0..32767 for 0..1, the value hid_traj_map_normalized() gives; spreads and
+ *                distance use the same scale and may go above 32767
+ *   ANGLE   i16  tenths of a degree
+ *   SPEED   u16  thousandths of a normalized unit per second
+ *   MS      u32  milliseconds
+ *   STRING  u8 length, then the bytes
+ *   POINTS  u8 count, then count x { COORD x, COORD y }
+ *   SPEEDS  u8 count, then count x SPEED
+ *
+ * A tap is 6 bytes where its JSON is around 20, and no number is parsed from text.
+ */
+typedef enum
+{
+    WIRE_COORD,
+    WIRE_ANGLE,
+    WIRE_SPEED,
+    WIRE_MS,
+    WIRE_STRING,
+    WIRE_POINTS,
+    WIRE_SPEEDS,
+} wire_kind_t;
+
+static const uint8_t s_request_wire[REQ_FIELD_COUNT] = {
+    [REQ_X] = WIRE_COORD,
+    [REQ_Y] = WIRE_COORD,
+    [REQ_START_X] = WIRE_COORD,
+    [REQ_START_Y] = WIRE_COORD,
+    [REQ_END_X] = WIRE_COORD,
+    [REQ_END_Y] = WIRE_COORD,
+    [REQ_SPREAD] = WIRE_COORD,
+    [REQ_START_SPREAD] = WIRE_COORD,
+    [REQ_END_SPREAD] = WIRE_COORD,
+    [REQ_ANGLE] = WIRE_ANGLE,
+    [REQ_START_ANGLE] = WIRE_ANGLE,
+    [REQ_END_ANGLE] = WIRE_ANGLE,
+    [REQ_DISTANCE] = WIRE_COORD,
+    [REQ_VELOCITY] = WIRE_SPEED,
+    [REQ_DURATION_MS] = WIRE_MS,
+    [REQ_DELAY_MS] = WIRE_MS,
+    [REQ_MS] = WIRE_MS,
+    [REQ_ACTION] = WIRE_STRING,
+    [REQ_CURVE] = WIRE_STRING,
+    [REQ_DIRECTION] = WIRE_STRING,
+    [REQ_MODE] = WIRE_STRING,
+    [REQ_POINTS] = WIRE_POINTS,
+    [REQ_SPEEDS] = WIRE_SPEEDS,
+};
+
+static uint16_t wire_rd16(const uint8_t *p)
+{
+    return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+static uint32_t wire_rd32(const uint8_t *p)
+{
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
 }
 
-static bool parse_float_field(const char *json, const char *field, float *out)
+static float wire_coord(const uint8_t *p)
 {
-    double v;
-    if (!parse_number_field(json, field, &v))
+    return wire_rd16(p) / (float)HID_ABS_MAX_COORD;
+}
+
+static float wire_speed(const uint8_t *p)
+{
+    return wire_rd16(p) * 0.001f;
+}
+
+static bool decode_request(const uint8_t *data, size_t len, void *out, uint32_t *present)
+{
+    uint8_t *base = (uint8_t *)out;
+    const uint8_t *end = data + len;
+
+    while (data < end)
     {
-        return false;
+        const uint8_t id = *data++;
+        if (id >= REQ_FIELD_COUNT)
+        {
+            return false;
+        }
+        const json_field_t *field = &s_request_fields[id];
+        const size_t left = (size_t)(end - data);
+
+        switch (s_request_wire[id])
+        {
+        case WIRE_COORD:
+        case WIRE_ANGLE:
+        case WIRE_SPEED:
+        {
+            if (left < 2)
+            {
+                return false;
+            }
+            float value = wire_coord(data);
+            if (s_request_wire[id] == WIRE_ANGLE)
+            {
+                value = (int16_t)wire_rd16(data) * 0.1f;
+            }
+            else if (s_request_wire[id] == WIRE_SPEED)
+            {
+                value = wire_speed(data);
+            }
+            memcpy(base + field->offset, &value, sizeof(value));
+            data += 2;
+            break;
+        }
+        case WIRE_MS:
+        {
+            if (left < 4)
+            {
+                return false;
+            }
+            const uint32_t value = wire_rd32(data);
+            memcpy(base + field->offset, &value, sizeof(value));
+            data += 4;
+            break;
+        }
+        case WIRE_STRING:
+        {
+            if (left < 1 || data[0] >= field->capacity || left < 1u + data[0])
+            {
+                return false;
+            }
+            char *text = (char *)(base + field->offset);
+            memcpy(text, data + 1, data[0]);
+            text[data[0]] = '\0';
+            data += 1 + data[0];
+            break;
+        }
+        case WIRE_POINTS:
+        case WIRE_SPEEDS:
+        {
+            const size_t item = (s_request_wire[id] == WIRE_POINTS) ? 4 : 2;
+            if (left < 1 || left < 1 + data[0] * item)
+            {
+                return false;
+            }
+            // As in JSON, items beyond the capacity are ignored
+            const uint32_t count = (data[0] < field->capacity) ? data[0] : field->capacity;
+            float *xs = (float *)(base + field->offset);
+            float *ys = (float *)(base + field->offset2);
+            for (uint32_t i = 0; i < count; ++i)
+            {
+                const uint8_t *p = data + 1 + i * item;
+                if (item == 4)
+                {
+                    xs[i] = wire_coord(p);
+                    ys[i] = wire_coord(p + 2);
+                }
+                else
+                {
+                    xs[i] = wire_speed(p);
+                }
+            }
+            memcpy(base + field->count_offset, &count, sizeof(count));
+            data += 1 + data[0] * item;
+            break;
+        }
+        default:
+            return false;
+        }
+
+        *present |= 1u << id;
     }
-    *out = (float)v;
     return true;
 }
 
-static bool parse_uint32_field(const char *json, const char *field, uint32_t *out)
+// Values the planners cannot represent: gesture record times are uint32 microseconds
+static bool request_in_range(const api_request_t *request)
 {
-    double v;
-    if (!parse_number_field(json, field, &v))
+    return request->duration_ms <= HID_GESTURE_MAX_DURATION_MS;
+}
+
+static bool read_request(httpd_req_t *req, api_request_t *request, bool optional)
+{
+    memset(request, 0, sizeof(*request));
+    if (!read_command(req, s_request_fields, REQ_FIELD_COUNT, decode_request, request, &request->present, optional,
+                      NULL))
     {
         return false;
     }
-    if (v < 0)
+    if (!request_in_range(request))
     {
-        v = 0;
+        respond_error(req, 400, "Value out of range");
+        return false;
     }
-    *out = (uint32_t)(v + 0.5);
     return true;
 }
 
-static bool ensure_hid_ready(httpd_req_t *req)
+// "aa:bb:cc:dd:ee:ff", also with '-' or the URL-encoded "%3A" between octets
+static bool parse_bda(const char *str, esp_bd_addr_t out)
+{
+    const char *p = str;
+    for (int i = 0; i < ESP_BD_ADDR_LEN; ++i)
+    {
+        if (i > 0)
+        {
+            if (*p == ':' || *p == '-')
+            {
+                p++;
+            }
+            else if (strncasecmp(p, "%3A", 3) == 0)
+            {
+                p += 3;
+            }
+            else
+            {
+                return false;
+            }
+        }
+        if (!isxdigit((unsigned char)p[0]) || !isxdigit((unsigned char)p[1]))
+        {
+            return false;
+        }
+        char octet[3] = { p[0], p[1], '\0' };
+        out[i] = (uint8_t)strtoul(octet, NULL, 16);
+        p += 2;
+    }
+    return *p == '\0';
+}
+
+/*
+ * Resolves the target host from "?device=", either a conn_id, a BD address, or "all" to send
+ * the same action to every connected host. Without a selector the host that connected first
+ * is used, as when only one phone is paired.
+ *
+ * Returns 0, or the HTTP status to fail the request with.
+ */
+static int resolve_device(httpd_req_t *req, uint16_t *conn_id)
+{
+    esp_hidd_link_info_t links[HID_MAX_LINKS];
+    uint8_t count = esp_hidd_get_links(links, HID_MAX_LINKS);
+    if (count > HID_MAX_LINKS)
+    {
+        count = HID_MAX_LINKS;
+    }
+    if (count == 0)
+    {
+        return 503;
+    }
+
+    char query[64];
+    char device[32];
+    if (httpd_req_get_url_query_str(req, query, sizeof(query)) != ESP_OK ||
+        httpd_query_key_value(query, "device", device, sizeof(device)) != ESP_OK)
+    {
+        *conn_id = links[0].conn_id;
+        return 0;
+    }
+
+    if (strcmp(device, "all") == 0)
+    {
+        *conn_id = HID_LINK_ALL;
+        return 0;
+    }
+
+    esp_bd_addr_t bda;
+    const bool by_bda = parse_bda(device, bda);
+    char *endptr;
+    unsigned long id = strtoul(device, &endptr, 10);
+    const bool by_id = !by_bda && endptr != device && *endptr == '\0';
+    for (uint8_t i = 0; i < count; ++i)
+    {
+        if ((by_bda && memcmp(links[i].remote_bda, bda, sizeof(esp_bd_addr_t)) == 0) ||
+            (by_id && links[i].conn_id == id))
+        {
+            *conn_id = links[i].conn_id;
+            return 0;
+        }
+    }
+    return 404;
+}
+
+static bool ensure_hid_ready(httpd_req_t *req, uint16_t *conn_id)
 {
-    if (s_hid_conn_id == UINT16_MAX)
+    int status = resolve_device(req, conn_id);
+    if (status != 0)
     {
-        respond_error(req, 503, "HID not connected");
+        respond_error(req, status, status == 503 ? "HID not connected" : "Unknown device");
         return false;
     }
     return true;
 }
 
+static esp_err_t submit_action(httpd_req_t *req, uint16_t conn_id, const hid_action_t *action)
+{
+    uint32_t job_id = 0;
+    esp_err_t err = hid_executor_submit(conn_id, action, &job_id);
+    request_heap_check();
+    if (err == ESP_ERR_NO_MEM)
+    {
+        return respond_error(req, 429, "Job queue full");
+    }
+    if (err != ESP_OK)
+    {
+        return respond_error(req, 500, "Failed to queue job");
+    }
+    return respond_job_accepted(req, job_id);
+}
+
 static esp_err_t handle_touch_tap(httpd_req_t *req)
 {
-    if (!ensure_hid_ready(req))
+    uint16_t conn_id;
+    if (!ensure_hid_ready(req, &conn_id))
     {
         return ESP_OK;
     }
 
-    char *body = NULL;
-    size_t len = 0;
-    esp_err_t err = read_body(req, &body, &len);
-    if (err != ESP_OK)
+    api_request_t request;
+    if (!read_request(req, &request, true))
     {
-        return respond_error(req, 500, "Failed to read body");
+        return ESP_OK;
     }
 
     float x = 0.5f, y = 0.5f;
-    if (body)
+    if (req->content_len > 0)
     {
-        bool ok = parse_float_field(body, "x", &x) && parse_float_field(body, "y", &y);
-        if (!ok)
+        if (!request_has(&request, REQ_BIT(REQ_X) | REQ_BIT(REQ_Y)))
         {
-            free(body);
             return respond_error(req, 400, "Missing x/y");
         }
+        x = request.x;
+        y = request.y;
     }
 
-    hid_touch_tap(s_hid_conn_id, x, y);
-
-    free(body);
-    return respond_json_ok(req);
+    hid_action_t action = { .type = HID_ACTION_TAP };
+    action.touch.x = x;
+    action.touch.y = y;
+    return submit_action(req, conn_id, &action);
 }
 
 static esp_err_t handle_touch_long_press(httpd_req_t *req)
 {
-    if (!ensure_hid_ready(req))
+    uint16_t conn_id;
+    if (!ensure_hid_ready(req, &conn_id))
     {
         return ESP_OK;
     }
 
-    char *body = NULL;
-    size_t len = 0;
-    esp_err_t err = read_body(req, &body, &len);
-    if (err != ESP_OK)
+    api_request_t request;
+    if (!read_request(req, &request, false))
     {
-        return respond_error(req, 500, "Failed to read body");
+        return ESP_OK;
     }
 
-    float x = 0.0f, y = 0.0f;
-    uint32_t duration = 0;
-    if (!body)
+    if (!request_has(&request, REQ_BIT(REQ_X) | REQ_BIT(REQ_Y) | REQ_BIT(REQ_DURATION_MS)))
     {
-        return respond_error(req, 400, "Missing body");
+        return respond_error(req, 400, "Missing fields");
     }
 
-    bool ok = parse_float_field(body, "x", &x) && parse_float_field(body, "y", &y) && parse_uint32_field(body, "duration_ms", &duration);
-    free(body);
+    hid_action_t action = { .type = HID_ACTION_LONG_PRESS };
+    action.touch.x = request.x;
+    action.touch.y = request.y;
+    action.touch.duration_ms = request.duration_ms;
+    return submit_action(req, conn_id, &action);
+}
 
-    if (!ok)
+// Points beyond HID_ACTION_MAX_POINTS are ignored
+static bool parse_multi_action(const api_request_t *request, hid_action_type_t type, hid_action_t *action)
+{
+    const uint32_t count = (request->point_count < HID_ACTION_MAX_POINTS) ? request->point_count : HID_ACTION_MAX_POINTS;
+    if (count == 0)
     {
-        return respond_error(req, 400, "Missing fields");
+        return false;
     }
 
-    hid_touch_long_press(s_hid_conn_id, x, y, duration);
-    return respond_json_ok(req);
+    action->type = type;
+    action->multi.count = count;
+    action->multi.duration_ms = request->duration_ms;
+    memcpy(action->multi.xs, request->xs, count * sizeof(request->xs[0]));
+    memcpy(action->multi.ys, request->ys, count * sizeof(request->ys[0]));
+    return true;
 }
 
-static esp_err_t handle_touch_multi_tap(httpd_req_t *req)
+static esp_err_t handle_touch_multi(httpd_req_t *req, hid_action_type_t type)
 {
-    if (!ensure_hid_ready(req))
+    uint16_t conn_id;
+    if (!ensure_hid_ready(req, &conn_id))
     {
         return ESP_OK;
     }
 
-    char *body = NULL;
-    size_t len = 0;
-    esp_err_t err = read_body(req, &body, &len);
-    if (err != ESP_OK)
+    api_request_t request;
+    if (!read_request(req, &request, false))
     {
-        return respond_error(req, 500, "Failed to read body");
+        return ESP_OK;
     }
 
-    if (!body)
+    hid_action_t action = { 0 };
+    if (!parse_multi_action(&request, type, &action))
     {
-        return respond_error(req, 400, "Missing body");
+        return respond_error(req, 400, "Invalid points");
     }
+    return submit_action(req, conn_id, &action);
+}
+
+static esp_err_t handle_touch_multi_tap(httpd_req_t *req) { return handle_touch_multi(req, HID_ACTION_MULTI_TAP); }
+static esp_err_t handle_touch_multi_long_press(httpd_req_t *req) { return handle_touch_multi(req, HID_ACTION_MULTI_LONG_PRESS); }
 
-    float coords[10] = {0};
-    uint32_t count = 0;
-    const char *ptr = strstr(body, "points");
-    if (ptr)
+static bool parse_swipe_action(const api_request_t *request, hid_action_t *action)
+{
+    action->type = HID_ACTION_SWIPE;
+    action->swipe.start_x = request->start_x;
+    action->swipe.start_y = request->start_y;
+    action->swipe.end_x = request->end_x;
+    action->swipe.end_y = request->end_y;
+    action->swipe.duration_ms = request->duration_ms;
+    return request_has(request, REQ_BIT(REQ_START_X) | REQ_BIT(REQ_START_Y) | REQ_BIT(REQ_END_X) | REQ_BIT(REQ_END_Y));
+}
+
+static esp_err_t handle_touch_swipe(httpd_req_t *req)
+{
+    uint16_t conn_id;
+    if (!ensure_hid_ready(req, &conn_id))
     {
-        const char *p = strchr(ptr, '[');
-        const char *end = strchr(ptr, ']');
-        if (p && end && end > p)
-        {
-            p++;
-            while (p < end && count < 5)
-            {
-                double vx, vy;
-                if (!parse_number_field(p, "x", &vx) || !parse_number_field(p, "y", &vy))
-                {
-                    break;
-                }
-                coords[count * 2] = (float)vx;
-                coords[count * 2 + 1] = (float)vy;
-                count++;
-                p = strchr(p, '}');
-                if (!p)
-                {
-                    break;
-                }
-                p++;
-            }
-        }
+        return ESP_OK;
     }
 
-    free(body);
+    api_request_t request;
+    if (!read_request(req, &request, false))
+    {
+        return ESP_OK;
+    }
 
-    if (count == 0)
+    hid_action_t action = { 0 };
+    if (!parse_swipe_action(&request, &action))
     {
-        return respond_error(req, 400, "Invalid points");
+        return respond_error(req, 400, "Missing fields");
     }
+    return submit_action(req, conn_id, &action);
+}
 
-    if (count > 5)
+// Pinch: x, y, start_spread, end_spread, optional angle. Rotate: x, y, spread, optional start_angle, end_angle.
+static bool parse_pair_action(const api_request_t *request, hid_action_type_t type, hid_action_t *action)
+{
+    action->type = type;
+    action->pair.duration_ms = request->duration_ms;
+    action->pair.center_x = request->x;
+    action->pair.center_y = request->y;
+    if (!request_has(request, REQ_BIT(REQ_X) | REQ_BIT(REQ_Y)))
     {
-        count = 5;
+        return false;
     }
 
-    float xs[5];
-    float ys[5];
-    for (uint32_t i = 0; i < count; ++i)
+    if (type == HID_ACTION_PINCH)
     {
-        xs[i] = coords[i * 2];
-        ys[i] = coords[i * 2 + 1];
+        action->pair.start_deg = request->angle;
+        action->pair.end_deg = request->angle;
+        action->pair.start_spread = request->start_spread;
+        action->pair.end_spread = request->end_spread;
+        return request_has(request, REQ_BIT(REQ_START_SPREAD) | REQ_BIT(REQ_END_SPREAD));
     }
 
-    hid_touch_multi_tap(s_hid_conn_id, count, xs, ys);
-    return respond_json_ok(req);
+    action->pair.start_deg = request->start_angle;
+    action->pair.end_deg = request->end_angle;
+    action->pair.start_spread = request->spread;
+    action->pair.end_spread = request->spread;
+    return request_has(request, REQ_BIT(REQ_SPREAD) | REQ_BIT(REQ_END_ANGLE));
 }
 
-static esp_err_t handle_touch_multi_long_press(httpd_req_t *req)
+static esp_err_t handle_touch_pair(httpd_req_t *req, hid_action_type_t type)
 {
-    if (!ensure_hid_ready(req))
+    uint16_t conn_id;
+    if (!ensure_hid_ready(req, &conn_id))
     {
         return ESP_OK;
     }
 
-    char *body = NULL;
-    size_t len = 0;
-    esp_err_t err = read_body(req, &body, &len);
-    if (err != ESP_OK)
+    api_request_t request;
+    if (!read_request(req, &request, false))
     {
-        return respond_error(req, 500, "Failed to read body");
+        return ESP_OK;
     }
 
-    if (!body)
+    hid_action_t action = { 0 };
+    if (!parse_pair_action(&request, type, &action))
     {
-        return respond_error(req, 400, "Missing body");
+        return respond_error(req, 400, "Missing fields");
     }
+    return submit_action(req, conn_id, &action);
+}
+
+// "curve": polyline (default), catmull_rom or bezier; "points"; "duration_ms" or per-segment "speeds"
+static bool parse_path_action(const api_request_t *request, hid_action_t *action)
+{
+    hid_traj_path_t *path = &action->path.points;
+    action->type = HID_ACTION_PATH;
+    memset(path, 0, sizeof(*path));
+    action->path.duration_ms = request->duration_ms;
 
-    float coords[10] = {0};
-    uint32_t count = 0;
-    const char *ptr = strstr(body, "points");
-    if (ptr)
+    const char *curve = request_has(request, REQ_BIT(REQ_CURVE)) ? request->curve : "polyline";
+    if (strcmp(curve, "polyline") == 0)
     {
-        const char *p = strchr(ptr, '[');
-        const char *end = strchr(ptr, ']');
-        if (p && end && end > p)
-        {
-            p++;
-            while (p < end && count < 5)
-            {
-                double vx, vy;
-                if (!parse_number_field(p, "x", &vx) || !parse_number_field(p, "y", &vy))
-                {
-                    break;
-                }
-                coords[count * 2] = (float)vx;
-                coords[count * 2 + 1] = (float)vy;
-                count++;
-                p = strchr(p, '}');
-                if (!p)
-                {
-                    break;
-                }
-                p++;
-            }
-        }
+        path->kind = HID_TRAJ_PATH_POLYLINE;
     }
-
-    uint32_t duration = 0;
-    parse_uint32_field(body, "duration_ms", &duration);
-
-    free(body);
-
-    if (count == 0)
+    else if (strcmp(curve, "catmull_rom") == 0)
     {
-        return respond_error(req, 400, "Invalid points");
+        path->kind = HID_TRAJ_PATH_CATMULL_ROM;
     }
-
-    if (count > 5)
+    else if (strcmp(curve, "bezier") == 0)
+    {
+        path->kind = HID_TRAJ_PATH_BEZIER;
+    }
+    else
     {
-        count = 5;
+        return false;
     }
 
-    float xs[5];
-    float ys[5];
-    for (uint32_t i = 0; i < count; ++i)
+    path->count = (uint8_t)request->point_count;
+    for (uint32_t i = 0; i < path->count; ++i)
     {
-        xs[i] = coords[i * 2];
-        ys[i] = coords[i * 2 + 1];
+        path->xs[i] = hid_traj_map_normalized(request->xs[i]);
+        path->ys[i] = hid_traj_map_normalized(request->ys[i]);
     }
+    memcpy(path->speeds, request->speeds, request->speed_count * sizeof(request->speeds[0]));
 
-    hid_touch_multi_long_press(s_hid_conn_id, count, xs, ys, duration);
-    return respond_json_ok(req);
+    return hid_traj_path_segments(path) > 0;
 }
-static esp_err_t handle_touch_swipe(httpd_req_t *req)
+
+static esp_err_t handle_touch_path(httpd_req_t *req)
 {
-    if (!ensure_hid_ready(req))
+    uint16_t conn_id;
+    if (!ensure_hid_ready(req, &conn_id))
     {
         return ESP_OK;
     }
 
-    char *body = NULL;
-    size_t len = 0;
-    esp_err_t err = read_body(req, &body, &len);
-    if (err != ESP_OK)
+    api_request_t request;
+    if (!read_request(req, &request, false))
     {
-        return respond_error(req, 500, "Failed to read body");
+        return ESP_OK;
     }
 
-    float sx = 0, sy = 0, ex = 0, ey = 0;
-    uint32_t duration = 0;
-    if (!body)
+    hid_action_t action = { 0 };
+    if (!parse_path_action(&request, &action))
+    {
+        return respond_error(req, 400, "Invalid path");
+    }
+    return submit_action(req, conn_id, &action);
+}
+
+static const struct
+{
+    const char *name;
+    float angle_deg;
+} s_fling_directions[] = {
+    { "right", 0.0f },
+    { "down", 90.0f },
+    { "left", 180.0f },
+    { "up", 270.0f },
+};
+
+/*
+ * "direction" (up/down/left/right) or "angle" in degrees is the finger's motion, "distance" and
+ * "velocity" are normalized units and units/s, "mode" is fling (default) or stop. "x"/"y" are the
+ * start point, by default the stroke is centered on the screen. A distance over
+ * HID_TRAJ_FLING_MAX_DISTANCE is rejected rather than clamped.
+ */
+static bool parse_fling_action(const api_request_t *request, hid_action_t *action)
+{
+    action->type = HID_ACTION_FLING;
+
+    bool have_angle = request_has(request, REQ_BIT(REQ_ANGLE));
+    action->fling.angle_deg = request->angle;
+    if (!have_angle && request_has(request, REQ_BIT(REQ_DIRECTION)))
+    {
+        for (size_t i = 0; i < sizeof(s_fling_directions) / sizeof(s_fling_directions[0]); ++i)
+        {
+            if (strcmp(request->direction, s_fling_directions[i].name) == 0)
+            {
+                action->fling.angle_deg = s_fling_directions[i].angle_deg;
+                have_angle = true;
+                break;
+            }
+        }
+    }
+    action->fling.distance = request->distance;
+    action->fling.velocity = request->velocity;
+    if (!have_angle || !request_has(request, REQ_BIT(REQ_DISTANCE) | REQ_BIT(REQ_VELOCITY)) ||
+        action->fling.distance <= 0.0f || action->fling.distance > HID_TRAJ_FLING_MAX_DISTANCE ||
+        action->fling.velocity <= 0.0f)
+    {
+        return false;
+    }
+
+    action->fling.fling = true;
+    if (request_has(request, REQ_BIT(REQ_MODE)))
+    {
+        if (strcmp(request->mode, "stop") == 0)
+        {
+            action->fling.fling = false;
+        }
+        else if (strcmp(request->mode, "fling") != 0)
+        {
+            return false;
+        }
+    }
+
+    const float rad = action->fling.angle_deg * (float)M_PI / 180.0f;
+    action->fling.start_x = request_has(request, REQ_BIT(REQ_X)) ? request->x
+                                                                  : 0.5f - 0.5f * action->fling.distance * cosf(rad);
+    action->fling.start_y = request_has(request, REQ_BIT(REQ_Y)) ? request->y
+                                                                  : 0.5f - 0.5f * action->fling.distance * sinf(rad);
+    return true;
+}
+
+static esp_err_t handle_touch_fling(httpd_req_t *req)
+{
+    uint16_t conn_id;
+    if (!ensure_hid_ready(req, &conn_id))
+    {
+        return ESP_OK;
+    }
+
+    api_request_t request;
+    if (!read_request(req, &request, false))
+    {
+        return ESP_OK;
+    }
+
+    hid_action_t action = { 0 };
+    if (!parse_fling_action(&request, &action))
+    {
+        return respond_error(req, 400, "Invalid fling");
+    }
+    return submit_action(req, conn_id, &action);
+}
+
+/*
+ * Recordings are received straight into a replay slot instead of a body buffer; the
+ * slot belongs to the job once it is queued and is released by the executor after playback.
+ */
+static esp_err_t handle_touch_replay(httpd_req_t *req)
+{
+    uint16_t conn_id;
+    if (!ensure_hid_ready(req, &conn_id))
+    {
+        return ESP_OK;
+    }
+    if (conn_id == HID_LINK_ALL)
+    {
+        return respond_error(req, 400, "Replay needs a single device");
+    }
+
+    size_t total_len = req->content_len;
+    if (total_len == 0)
     {
         return respond_error(req, 400, "Missing body");
     }
+    if (total_len > HID_REPLAY_MAX_BYTES)
+    {
+        return respond_error(req, 413, "Recording too large");
+    }
+
+    int slot = hid_replay_acquire();
+    if (slot < 0)
+    {
+        return respond_error(req, 429, "Replay slots busy");
+    }
 
-    bool ok = parse_float_field(body, "start_x", &sx) && parse_float_field(body, "start_y", &sy) && parse_float_field(body, "end_x", &ex) && parse_float_field(body, "end_y", &ey);
-    if (ok)
+    uint8_t *buf = hid_replay_buffer(slot);
+    size_t received = 0;
+    while (received < total_len)
     {
-        if (!parse_uint32_field(body, "duration_ms", &duration))
+        int r = httpd_req_recv(req, (char *)buf + received, total_len - received);
+        if (r <= 0)
         {
-            duration = 0;
+            hid_replay_release(slot);
+            return respond_error(req, 500, "Failed to read body");
         }
+        received += r;
     }
-    free(body);
 
-    if (!ok)
+    if (hid_replay_commit(slot, total_len, NULL) != ESP_OK)
     {
-        return respond_error(req, 400, "Missing fields");
+        hid_replay_release(slot);
+        return respond_error(req, 400, "Invalid recording");
     }
 
-    hid_touch_swipe(s_hid_conn_id, sx, sy, ex, ey, duration);
-    return respond_json_ok(req);
+    hid_action_t action = { .type = HID_ACTION_REPLAY };
+    action.replay.slot = slot;
+
+    uint32_t job_id = 0;
+    esp_err_t err = hid_executor_submit(conn_id, &action, &job_id);
+    if (err != ESP_OK)
+    {
+        hid_replay_release(slot);
+        return (err == ESP_ERR_NO_MEM) ? respond_error(req, 429, "Job queue full")
+                                       : respond_error(req, 500, "Failed to queue job");
+    }
+    return respond_job_accepted(req, job_id);
 }
 
-static esp_err_t handle_key_action(httpd_req_t *req, void (*action)(uint16_t conn_id))
+static esp_err_t handle_touch_pinch(httpd_req_t *req) { return handle_touch_pair(req, HID_ACTION_PINCH); }
+static esp_err_t handle_touch_rotate(httpd_req_t *req) { return handle_touch_pair(req, HID_ACTION_ROTATE); }
+
+static esp_err_t handle_key_action(httpd_req_t *req, hid_key_action_fn_t press)
 {
-    if (!ensure_hid_ready(req))
+    uint16_t conn_id;
+    if (!ensure_hid_ready(req, &conn_id))
     {
         return ESP_OK;
     }
-    action(s_hid_conn_id);
-    return respond_json_ok(req);
+
+    hid_action_t action = { .type = HID_ACTION_KEY };
+    action.key.press = press;
+    return submit_action(req, conn_id, &action);
 }
 
 static esp_err_t handle_volume_up(httpd_req_t *req) { return handle_key_action(req, hid_press_volume_up); }
@@ -543,6 +1210,610 @@ static esp_err_t handle_home(httpd_req_t *req) { return handle_key_action(req, h
 static esp_err_t handle_back(httpd_req_t *req) { return handle_key_action(req, hid_press_back); }
 static esp_err_t handle_power(httpd_req_t *req) { return handle_key_action(req, hid_press_power); }
 
+/*
+ * The body is raw UTF-8, received straight into a text slot like /touch/replay. The counts in
+ * the response come from decoding the text before it is queued.
+ */
+static esp_err_t handle_key_text(httpd_req_t *req)
+{
+    uint16_t conn_id;
+    if (!ensure_hid_ready(req, &conn_id))
+    {
+        return ESP_OK;
+    }
+
+    size_t total_len = req->content_len;
+    if (total_len == 0)
+    {
+        return respond_error(req, 400, "Missing body");
+    }
+    if (total_len > HID_TEXT_MAX_BYTES)
+    {
+        return respond_error(req, 413, "Text too large");
+    }
+
+    int slot = hid_text_acquire();
+    if (slot < 0)
+    {
+        return respond_error(req, 429, "Text slots busy");
+    }
+
+    uint8_t *buf = hid_text_buffer(slot);
+    size_t received = 0;
+    while (received < total_len)
+    {
+        int r = httpd_req_recv(req, (char *)buf + received, total_len - received);
+        if (r <= 0)
+        {
+            hid_text_release(slot);
+            return respond_error(req, 500, "Failed to read body");
+        }
+        received += r;
+    }
+
+    hid_text_stats_t stats;
+    if (hid_text_commit(slot, total_len, &stats) != ESP_OK || stats.chars == 0)
+    {
+        hid_text_release(slot);
+        return respond_error(req, 400, "Nothing to type");
+    }
+
+    hid_action_t action = { .type = HID_ACTION_TEXT };
+    action.text.slot = slot;
+
+    uint32_t job_id = 0;
+    esp_err_t err = hid_executor_submit(conn_id, &action, &job_id);
+    if (err != ESP_OK)
+    {
+        hid_text_release(slot);
+        return (err == ESP_ERR_NO_MEM) ? respond_error(req, 429, "Job queue full")
+                                       : respond_error(req, 500, "Failed to queue job");
+    }
+
+    char resp[96];
+    snprintf(resp, sizeof(resp), "{\"status\":\"queued\",\"job_id\":%lu,\"chars\":%lu,\"unsupported\":%lu}",
+             (unsigned long)job_id, (unsigned long)stats.chars, (unsigned long)stats.unsupported);
+    httpd_resp_set_status(req, "202 Accepted");
+    httpd_resp_set_type(req, "application/json");
+    return httpd_resp_send(req, resp, HTTPD_RESP_USE_STRLEN);
+}
+
+/*
+ * Same body as /key/text without the size limit: the job is queued first, then each chunk is
+ * decoded into the key-stroke ring as it arrives, so typing starts with the first chunk and
+ * only a chunk buffer is held here. The response comes once the body is read, while the tail
+ * of the text may still be typing. If the typist takes nothing for HID_TEXT_STREAM_WRITE_MS,
+ * e.g. because the job waits behind a long one, the request fails with 503 rather than hold
+ * the server task.
+ */
+static esp_err_t handle_key_text_stream(httpd_req_t *req)
+{
+    uint16_t conn_id;
+    if (!ensure_hid_ready(req, &conn_id))
+    {
+        return ESP_OK;
+    }
+
+    size_t remaining = req->content_len;
+    if (remaining == 0)
+    {
+        return respond_error(req, 400, "Missing body");
+    }
+    if (hid_text_stream_open() != ESP_OK)
+    {
+        return respond_error(req, 429, "Text stream busy");
+    }
+
+    hid_utf8_t dec = { 0 };
+    hid_text_stats_t stats = { 0 };
+
+    hid_action_t action = { .type = HID_ACTION_TEXT_STREAM };
+    uint32_t job_id = 0;
+    esp_err_t err = hid_executor_submit(conn_id, &action, &job_id);
+    if (err != ESP_OK)
+    {
+        hid_text_stream_close(&dec, &stats, false);
+        hid_text_stream_release(); // the typist's hold, its job never runs
+        return (err == ESP_ERR_NO_MEM) ? respond_error(req, 429, "Job queue full")
+                                       : respond_error(req, 500, "Failed to queue job");
+    }
+
+    char chunk[TEXT_STREAM_CHUNK_BYTES];
+    while (remaining > 0)
+    {
+        int r = httpd_req_recv(req, chunk, remaining < sizeof(chunk) ? remaining : sizeof(chunk));
+        if (r <= 0)
+        {
+            hid_text_stream_close(&dec, &stats, false);
+            return respond_error(req, 500, "Failed to read body");
+        }
+        remaining -= r;
+
+        if (hid_text_stream_write(&dec, (const uint8_t *)chunk, r, &stats) != ESP_OK)
+        {
+            hid_text_stream_close(&dec, &stats, false);
+            return respond_error(req, 503, "Typing stalled");
+        }
+    }
+    hid_text_stream_close(&dec, &stats, true);
+
+    char resp[96];
+    snprintf(resp, sizeof(resp), "{\"status\":\"streamed\",\"job_id\":%lu,\"chars\":%lu,\"unsupported\":%lu}",
+             (unsigned long)job_id, (unsigned long)stats.chars, (unsigned long)stats.unsupported);
+    httpd_resp_set_status(req, "202 Accepted");
+    httpd_resp_set_type(req, "application/json");
+    return httpd_resp_send(req, resp, HTTPD_RESP_USE_STRLEN);
+}
+
+#ifdef CONFIG_HTTPD_WS_SUPPORT
+// Sessions are opened and freed by the server task only
+static hid_live_t s_live_sessions[LIVE_WS_SESSIONS];
+static bool s_live_session_used[LIVE_WS_SESSIONS];
+
+static hid_live_t *open_live_session(void)
+{
+    for (int i = 0; i < LIVE_WS_SESSIONS; ++i)
+    {
+        if (!s_live_session_used[i])
+        {
+            s_live_session_used[i] = true;
+            return &s_live_sessions[i];
+        }
+    }
+    return NULL;
+}
+
+static void free_live_session(void *ctx)
+{
+    hid_live_t *live = (hid_live_t *)ctx;
+    hid_live_end(live);
+    s_live_session_used[live - s_live_sessions] = false;
+}
+
+/*
+ * Live input over a WebSocket: each binary message carries hid_live records (see hid_live.h)
+ * that are sent as reports right away, without going through the job queue. The device is
+ * chosen once by "?device=" on the handshake; the session lifts everything it still holds
+ * when the socket closes.
+ */
+static esp_err_t handle_live_ws(httpd_req_t *req)
+{
+    if (req->method == HTTP_GET)
+    {
+        // The handshake is already answered, so a bad device can only close the socket
+        uint16_t conn_id;
+        int status = resolve_device(req, &conn_id);
+        if (status != 0)
+        {
+            ESP_LOGW(TAG, "Live input rejected: %s", status == 503 ? "HID not connected" : "unknown device");
+            return ESP_FAIL;
+        }
+
+        hid_live_t *live = open_live_session();
+        if (!live)
+        {
+            ESP_LOGW(TAG, "Live input rejected: all %d sessions in use", LIVE_WS_SESSIONS);
+            return ESP_ERR_NO_MEM;
+        }
+        hid_live_begin(live, conn_id);
+        req->sess_ctx = live;
+        req->free_ctx = free_live_session;
+        ESP_LOGI(TAG, "Live input session opened for device %u", conn_id);
+        return ESP_OK;
+    }
+
+    hid_live_t *live = (hid_live_t *)req->sess_ctx;
+    if (!live)
+    {
+        return ESP_FAIL;
+    }
+
+    uint8_t buf[LIVE_WS_MAX_MESSAGE];
+    httpd_ws_frame_t frame = { .payload = buf };
+    esp_err_t err = httpd_ws_recv_frame(req, &frame, 0);
+    if (err != ESP_OK)
+    {
+        return err;
+    }
+    if (frame.len > sizeof(buf))
+    {
+        ESP_LOGW(TAG, "Live input message of %u bytes too large", (unsigned)frame.len);
+        return ESP_FAIL;
+    }
+    err = httpd_ws_recv_frame(req, &frame, frame.len);
+    if (err != ESP_OK)
+    {
+        return err;
+    }
+    if (frame.type != HTTPD_WS_TYPE_BINARY)
+    {
+        return ESP_OK;
+    }
+
+    if (hid_live_feed(live, buf, frame.len) != ESP_OK)
+    {
+        ESP_LOGW(TAG, "Live input message of %u bytes is not whole records", (unsigned)frame.len);
+        return ESP_OK;
+    }
+
+    uint8_t reply[HID_LIVE_RECORD_LEN];
+    if (hid_live_take_sync(live, reply))
+    {
+        httpd_ws_frame_t out = {
+            .final = true,
+            .type = HTTPD_WS_TYPE_BINARY,
+            .payload = reply,
+            .len = sizeof(reply),
+        };
+        return httpd_ws_send_frame(req, &out);
+    }
+    return ESP_OK;
+}
+#endif
+
+static const struct
+{
+    const char *name;
+    hid_key_action_fn_t press;
+} s_key_actions[] = {
+    { "volume_up", hid_press_volume_up },
+    { "volume_down", hid_press_volume_down },
+    { "home", hid_press_home },
+    { "back", hid_press_back },
+    { "power", hid_press_power },
+};
+
+// Fills one batch step from a single step object; "wait" steps are folded into the next step's delay by the caller
+static bool parse_batch_step(const api_request_t *request, hid_batch_step_t *step)
+{
+    memset(step, 0, sizeof(*step));
+    step->delay_ms = request->delay_ms;
+
+    const char *name = request->action;
+    hid_action_t *action = &step->action;
+    if (strcmp(name, "tap") == 0)
+    {
+        action->type = HID_ACTION_TAP;
+        action->touch.x = request->x;
+        action->touch.y = request->y;
+        return request_has(request, REQ_BIT(REQ_X) | REQ_BIT(REQ_Y));
+    }
+    if (strcmp(name, "long_press") == 0)
+    {
+        action->type = HID_ACTION_LONG_PRESS;
+        action->touch.x = request->x;
+        action->touch.y = request->y;
+        action->touch.duration_ms = request->duration_ms;
+        return request_has(request, REQ_BIT(REQ_X) | REQ_BIT(REQ_Y) | REQ_BIT(REQ_DURATION_MS));
+    }
+    if (strcmp(name, "swipe") == 0)
+    {
+        return parse_swipe_action(request, action);
+    }
+    if (strcmp(name, "multi_tap") == 0 || strcmp(name, "multi_long_press") == 0)
+    {
+        return parse_multi_action(request, (name[6] == 't') ? HID_ACTION_MULTI_TAP : HID_ACTION_MULTI_LONG_PRESS, action);
+    }
+    if (strcmp(name, "path") == 0)
+    {
+        return parse_path_action(request, action);
+    }
+    if (strcmp(name, "fling") == 0)
+    {
+        return parse_fling_action(request, action);
+    }
+    if (strcmp(name, "pinch") == 0 || strcmp(name, "rotate") == 0)
+    {
+        return parse_pair_action(request, (name[0] == 'p') ? HID_ACTION_PINCH : HID_ACTION_ROTATE, action);
+    }
+    for (size_t i = 0; i < sizeof(s_key_actions) / sizeof(s_key_actions[0]); ++i)
+    {
+        if (strcmp(name, s_key_actions[i].name) == 0)
+        {
+            action->type = HID_ACTION_KEY;
+            action->key.press = s_key_actions[i].press;
+            return true;
+        }
+    }
+    return false;
+}
+
+typedef struct
+{
+    hid_batch_step_t steps[HID_BATCH_MAX_STEPS];
+    uint32_t count;
+    uint32_t pending_delay_ms;
+    const char *error;                  /*!< Why the steps were rejected, NULL for a malformed body */
+} batch_request_t;
+
+// Appends one step, or folds a wait into the next step's delay
+static bool add_batch_step(batch_request_t *batch, const api_request_t *request)
+{
+    if (!request_has(request, REQ_BIT(REQ_ACTION)))
+    {
+        batch->error = "Step without action";
+    }
+    else if (strcmp(request->action, "wait") == 0)
+    {
+        batch->pending_delay_ms += request_has(request, REQ_BIT(REQ_MS)) ? request->ms : request->delay_ms;
+    }
+    else if (batch->count >= HID_BATCH_MAX_STEPS)
+    {
+        batch->error = "Too many steps";
+    }
+    else if (!request_in_range(request) || !parse_batch_step(request, &batch->steps[batch->count]))
+    {
+        batch->error = "Invalid step";
+    }
+    else
+    {
+        batch->steps[batch->count].delay_ms += batch->pending_delay_ms;
+        batch->pending_delay_ms = 0;
+        batch->count++;
+    }
+    return batch->error == NULL;
+}
+
+// Value of "steps": each element is scanned into its own api_request_t and converted on the spot
+static bool parse_batch_steps(json_scan_t *scan, const json_tok_t *value, void *out)
+{
+    batch_request_t *batch = (batch_request_t *)out;
+    if (value->type != JSON_TOK_ARRAY_BEGIN)
+    {
+        batch->error = "Malformed steps";
+        return false;
+    }
+
+    for (;;)
+    {
+        json_tok_t tok;
+        const json_tok_type_t type = json_scan_next(scan, &tok);
+        if (type == JSON_TOK_ARRAY_END)
+        {
+            return true;
+        }
+
+        api_request_t request = { 0 };
+        if (type != JSON_TOK_OBJECT_BEGIN ||
+            !json_scan_object(scan, &tok, s_request_fields, REQ_FIELD_COUNT, &request, &request.present))
+        {
+            batch->error = "Malformed steps";
+            return false;
+        }
+        if (!add_batch_step(batch, &request))
+        {
+            return false;
+        }
+    }
+}
+
+// Binary /batch: each step is a u8 length followed by that many bytes of fields, see decode_request()
+static bool decode_batch(const uint8_t *data, size_t len, void *out, uint32_t *present)
+{
+    batch_request_t *batch = (batch_request_t *)out;
+    const uint8_t *end = data + len;
+
+    while (data < end)
+    {
+        const uint8_t step_len = *data++;
+        api_request_t request = { 0 };
+        if ((size_t)(end - data) < step_len || !decode_request(data, step_len, &request, &request.present))
+        {
+            batch->error = "Malformed steps";
+            return false;
+        }
+        data += step_len;
+        if (!add_batch_step(batch, &request))
+        {
+            return false;
+        }
+    }
+
+    *present = 1; // "steps"
+    return true;
+}
+
+static const json_field_t s_batch_fields[] = {
+    JSON_FIELD_CUSTOM_OF("steps", parse_batch_steps),
+};
+
+static batch_request_t s_batch; // Only touched by the server task
+
+/*
+ * POST /batch {"steps":[{"action":"tap","x":0.5,"y":0.5},{"action":"wait","ms":300},
+ *                       {"action":"swipe",...,"delay_ms":100},{"action":"back"}]}
+ * delay_ms (or a preceding wait step) is measured from the end of the previous step.
+ */
+static esp_err_t handle_batch(httpd_req_t *req)
+{
+    uint16_t conn_id;
+    if (!ensure_hid_ready(req, &conn_id))
+    {
+        return ESP_OK;
+    }
+
+    memset(&s_batch, 0, sizeof(s_batch));
+    uint32_t present = 0;
+    if (!read_command(req, s_batch_fields, 1, decode_batch, &s_batch, &present, false, &s_batch.error))
+    {
+        return ESP_OK;
+    }
+    if (!present)
+    {
+        return respond_error(req, 400, "Missing steps");
+    }
+    if (s_batch.count == 0)
+    {
+        return respond_error(req, 400, "Empty batch");
+    }
+
+    uint32_t job_id = 0;
+    esp_err_t err = hid_executor_submit_batch(conn_id, s_batch.steps, s_batch.count, &job_id);
+    request_heap_check();
+    if (err == ESP_ERR_NO_MEM)
+    {
+        return respond_error(req, 429, "Job queue full");
+    }
+    if (err != ESP_OK)
+    {
+        return respond_error(req, 500, "Failed to queue job");
+    }
+    return respond_job_accepted(req, job_id);
+}
+
+static esp_err_t handle_job_status(httpd_req_t *req)
+{
+    const char *id_str = req->uri + strlen("/jobs/");
+    char *endptr;
+    unsigned long job_id = strtoul(id_str, &endptr, 10);
+    if (endptr == id_str || (*endptr != '\0' && *endptr != '?'))
+    {
+        return respond_error(req, 400, "Invalid job id");
+    }
+
+    hid_job_info_t info;
+    if (hid_executor_get_job((uint32_t)job_id, &info) != ESP_OK)
+    {
+        return respond_error(req, 404, "Unknown job");
+    }
+
+    char resp[512];
+    snprintf(resp, sizeof(resp),
+             "{\"job_id\":%lu,\"action\":\"%s\",\"state\":\"%s\",\"queued_us\":%lld,\"started_us\":%lld,\"finished_us\":%lld,"
+             "\"timing\":{\"samples\":%lu,\"planned_us\":%lld,\"actual_us\":%lld,\"error_us\":%lld,\"max_late_us\":%ld,\"avg_late_us\":%ld,"
+             "\"stalled_us\":%lld,\"max_skew_us\":%ld,\"avg_skew_us\":%ld}",
+             (unsigned long)info.id, hid_action_type_name(info.type), hid_job_state_name(info.state),
+             (long long)info.queued_us, (long long)info.started_us, (long long)info.finished_us,
+             (unsigned long)info.timing.samples, (long long)info.timing.planned_us, (long long)info.timing.actual_us,
+             (long long)(info.timing.actual_us - info.timing.planned_us),
+             (long)info.timing.max_late_us, (long)info.timing.avg_late_us, (long long)info.timing.stalled_us,
+             (long)info.timing.max_skew_us, (long)info.timing.avg_skew_us);
+    httpd_resp_set_type(req, "application/json");
+
+    httpd_resp_send_chunk(req, resp, HTTPD_RESP_USE_STRLEN);
+
+    // Batches append one entry per step; chunks keep the response buffer small
+    hid_batch_step_result_t steps[HID_BATCH_MAX_STEPS];
+    uint32_t step_count = 0;
+    if (info.type == HID_ACTION_BATCH &&
+        hid_executor_get_batch_results(info.id, steps, HID_BATCH_MAX_STEPS, &step_count) == ESP_OK)
+    {
+        httpd_resp_send_chunk(req, ",\"steps\":[", HTTPD_RESP_USE_STRLEN);
+        for (uint32_t i = 0; i < step_count; ++i)
+        {
+            const hid_batch_step_result_t *step = &steps[i];
+            snprintf(resp, sizeof(resp),
+                     "%s{\"action\":\"%s\",\"planned_us\":%lld,\"started_us\":%lld,\"finished_us\":%lld,"
+                     "\"samples\":%lu,\"max_late_us\":%ld,\"avg_late_us\":%ld,\"stalled_us\":%lld,"
+                     "\"max_skew_us\":%ld,\"avg_skew_us\":%ld}",
+                     i ? "," : "", hid_action_type_name(step->type), (long long)step->planned_us,
+                     (long long)step->started_us, (long long)step->finished_us, (unsigned long)step->timing.samples,
+                     (long)step->timing.max_late_us, (long)step->timing.avg_late_us,
+                     (long long)step->timing.stalled_us, (long)step->timing.max_skew_us,
+                     (long)step->timing.avg_skew_us);
+            httpd_resp_send_chunk(req, resp, HTTPD_RESP_USE_STRLEN);
+        }
+        httpd_resp_send_chunk(req, "]", HTTPD_RESP_USE_STRLEN);
+    }
+
+    httpd_resp_send_chunk(req, "}", HTTPD_RESP_USE_STRLEN);
+    return httpd_resp_send_chunk(req, NULL, 0);
+}
+
+static const struct
+{
+    const char *name;
+    uint8_t id;
+} s_stat_reports[] = {
+    { "touch", HID_RPT_ID_TOUCH_IN },
+    { "keyboard", HID_RPT_ID_KEY_IN },
+    { "consumer", HID_RPT_ID_CC_IN },
+    { "mouse", HID_RPT_ID_MOUSE_IN },
+};
+
+// GET /hid/stats: sent/deferred/dropped counters of each input report since the service started,
+// and how many touch frames were coalesced before reaching the sender
+static esp_err_t handle_hid_stats(httpd_req_t *req)
+{
+    char resp[512];
+    size_t len = snprintf(resp, sizeof(resp), "{");
+    for (size_t i = 0; i < sizeof(s_stat_reports) / sizeof(s_stat_reports[0]); ++i)
+    {
+        hid_report_stats_t stats = { 0 };
+        hid_dev_get_report_stats(s_stat_reports[i].id, HID_REPORT_TYPE_INPUT, &stats);
+        len += snprintf(resp + len, sizeof(resp) - len,
+                        "%s\"%s\":{\"report_id\":%u,\"sent\":%lu,\"deferred\":%lu,\"dropped\":%lu}",
+                        i ? "," : "", s_stat_reports[i].name, s_stat_reports[i].id, (unsigned long)stats.sent,
+                        (unsigned long)stats.deferred, (unsigned long)stats.dropped);
+    }
+
+    hid_coalesce_stats_t co;
+    hid_coalesce_get_stats(&co);
+    snprintf(resp + len, sizeof(resp) - len, ",\"touch_frames\":{\"sent\":%lu,\"superseded\":%lu,\"duplicates\":%lu}}",
+             (unsigned long)co.sent, (unsigned long)co.superseded, (unsigned long)co.duplicates);
+
+    httpd_resp_set_type(req, "application/json");
+    return httpd_resp_send(req, resp, HTTPD_RESP_USE_STRLEN);
+}
+
+// GET /hid/link?device=: requested profile and the connection parameters the host settled on
+static esp_err_t handle_hid_link(httpd_req_t *req)
+{
+    uint16_t conn_id;
+    if (!ensure_hid_ready(req, &conn_id))
+    {
+        return ESP_OK;
+    }
+    if (conn_id == HID_LINK_ALL)
+    {
+        return respond_error(req, 400, "Select a single device");
+    }
+
+    hid_link_params_t link = { 0 };
+    hid_link_get_params(conn_id, &link);
+
+    char resp[208];
+    snprintf(resp, sizeof(resp),
+             "{\"conn_id\":%u,\"profile\":\"%s\",\"interval_us\":%lu,\"latency\":%u,\"timeout_ms\":%lu,"
+             "\"last_status\":%d,\"updates\":%lu}",
+             conn_id, hid_link_profile_name(link.requested), (unsigned long)link.interval * 1250, link.latency,
+             (unsigned long)link.timeout * 10, link.last_status, (unsigned long)link.updates);
+
+    httpd_resp_set_type(req, "application/json");
+    return httpd_resp_send(req, resp, HTTPD_RESP_USE_STRLEN);
+}
+
+// GET /devices: connected hosts in connection order; the first one is the default target
+static esp_err_t handle_devices(httpd_req_t *req)
+{
+    esp_hidd_link_info_t links[HID_MAX_LINKS];
+    uint8_t count = esp_hidd_get_links(links, HID_MAX_LINKS);
+    if (count > HID_MAX_LINKS)
+    {
+        count = HID_MAX_LINKS;
+    }
+
+    char resp[192];
+    httpd_resp_set_type(req, "application/json");
+    httpd_resp_send_chunk(req, "{\"devices\":[", HTTPD_RESP_USE_STRLEN);
+    for (uint8_t i = 0; i < count; ++i)
+    {
+        const esp_hidd_link_info_t *link = &links[i];
+        hid_link_params_t params = { 0 };
+        hid_link_get_params(link->conn_id, &params);
+        snprintf(resp, sizeof(resp),
+                 "%s{\"conn_id\":%u,\"address\":\"" ESP_BD_ADDR_STR "\",\"secured\":%s,\"notify_mask\":%u,"
+                 "\"profile\":\"%s\",\"interval_us\":%lu}",
+                 i ? "," : "", link->conn_id, ESP_BD_ADDR_HEX(link->remote_bda), link->secured ? "true" : "false",
+                 link->notify_mask, hid_link_profile_name(params.requested),
+                 (unsigned long)params.interval * 1250);
+        httpd_resp_send_chunk(req, resp, HTTPD_RESP_USE_STRLEN);
+    }
+    snprintf(resp, sizeof(resp), "],\"max\":%d}", HID_MAX_LINKS);
+    httpd_resp_send_chunk(req, resp, HTTPD_RESP_USE_STRLEN);
+    return httpd_resp_send_chunk(req, NULL, 0);
+}
+
 static void register_http_handlers(httpd_handle_t server)
 {
     const httpd_uri_t tap_uri = {
@@ -585,6 +1856,46 @@ static void register_http_handlers(httpd_handle_t server)
     };
     httpd_register_uri_handler(server, &multi_press_uri);
 
+    const httpd_uri_t path_uri = {
+        .uri = "/touch/path",
+        .method = HTTP_POST,
+        .handler = handle_touch_path,
+        .user_ctx = NULL,
+    };
+    httpd_register_uri_handler(server, &path_uri);
+
+    const httpd_uri_t replay_uri = {
+        .uri = "/touch/replay",
+        .method = HTTP_POST,
+        .handler = handle_touch_replay,
+        .user_ctx = NULL,
+    };
+    httpd_register_uri_handler(server, &replay_uri);
+
+    const httpd_uri_t fling_uri = {
+        .uri = "/touch/fling",
+        .method = HTTP_POST,
+        .handler = handle_touch_fling,
+        .user_ctx = NULL,
+    };
+    httpd_register_uri_handler(server, &fling_uri);
+
+    const httpd_uri_t pinch_uri = {
+        .uri = "/touch/pinch",
+        .method = HTTP_POST,
+        .handler = handle_touch_pinch,
+        .user_ctx = NULL,
+    };
+    httpd_register_uri_handler(server, &pinch_uri);
+
+    const httpd_uri_t rotate_uri = {
+        .uri = "/touch/rotate",
+        .method = HTTP_POST,
+        .handler = handle_touch_rotate,
+        .user_ctx = NULL,
+    };
+    httpd_register_uri_handler(server, &rotate_uri);
+
     const httpd_uri_t volume_up_uri = {
         .uri = "/key/volume_up",
         .method = HTTP_POST,
@@ -624,6 +1935,73 @@ static void register_http_handlers(httpd_handle_t server)
         .user_ctx = NULL,
     };
     httpd_register_uri_handler(server, &power_uri);
+
+    const httpd_uri_t text_uri = {
+        .uri = "/key/text",
+        .method = HTTP_POST,
+        .handler = handle_key_text,
+        .user_ctx = NULL,
+    };
+    httpd_register_uri_handler(server, &text_uri);
+
+    const httpd_uri_t text_stream_uri = {
+        .uri = "/key/text/stream",
+        .method = HTTP_POST,
+        .handler = handle_key_text_stream,
+        .user_ctx = NULL,
+    };
+    httpd_register_uri_handler(server, &text_stream_uri);
+
+#ifdef CONFIG_HTTPD_WS_SUPPORT
+    const httpd_uri_t live_uri = {
+        .uri = "/live",
+        .method = HTTP_GET,
+        .handler = handle_live_ws,
+        .user_ctx = NULL,
+        .is_websocket = true,
+    };
+    httpd_register_uri_handler(server, &live_uri);
+#endif
+
+    const httpd_uri_t batch_uri = {
+        .uri = "/batch",
+        .method = HTTP_POST,
+        .handler = handle_batch,
+        .user_ctx = NULL,
+    };
+    httpd_register_uri_handler(server, &batch_uri);
+
+    const httpd_uri_t job_status_uri = {
+        .uri = "/jobs/*",
+        .method = HTTP_GET,
+        .handler = handle_job_status,
+        .user_ctx = NULL,
+    };
+    httpd_register_uri_handler(server, &job_status_uri);
+
+    const httpd_uri_t hid_stats_uri = {
+        .uri = "/hid/stats",
+        .method = HTTP_GET,
+        .handler = handle_hid_stats,
+        .user_ctx = NULL,
+    };
+    httpd_register_uri_handler(server, &hid_stats_uri);
+
+    const httpd_uri_t hid_link_uri = {
+        .uri = "/hid/link",
+        .method = HTTP_GET,
+        .handler = handle_hid_link,
+        .user_ctx = NULL,
+    };
+    httpd_register_uri_handler(server, &hid_link_uri);
+
+    const httpd_uri_t devices_uri = {
+        .uri = "/devices",
+        .method = HTTP_GET,
+        .handler = handle_devices,
+        .user_ctx = NULL,
+    };
+    httpd_register_uri_handler(server, &devices_uri);
 }
 
 static esp_err_t start_http_server(void)
@@ -636,6 +2014,9 @@ static esp_err_t start_http_server(void)
     httpd_config_t config = HTTPD_DEFAULT_CONFIG();
     config.lru_purge_enable = true;
     config.server_port = 80;
+    config.max_uri_handlers = 24;
+    config.stack_size = 6144; // /batch scans each step object on the handler stack
+    config.uri_match_fn = httpd_uri_match_wildcard;
 
     esp_err_t err = httpd_start(&s_httpd, &config);
     if (err != ESP_OK)
@@ -646,9 +2027,135 @@ static esp_err_t start_http_server(void)
 
     register_http_handlers(s_httpd);
     ESP_LOGI(TAG, "HTTP server started on port %u", config.server_port);
+
+#if UDP_INPUT_PORT
+    // Live input survives without it, so a failure here does not fail the HTTP server
+    start_udp_input();
+#endif
     return ESP_OK;
 }
 
+#if UDP_INPUT_PORT
+// Target of UDP input: the host that connected first, as for a request without ?device=
+static bool udp_input_device(uint16_t *conn_id)
+{
+    esp_hidd_link_info_t links[HID_MAX_LINKS];
+    if (esp_hidd_get_links(links, HID_MAX_LINKS) == 0)
+    {
+        return false;
+    }
+    *conn_id = links[0].conn_id;
+    return true;
+}
+
+/*
+ * Live touch over UDP: one hid_live session follows the latest sender, and a datagram from
+ * another address or port starts a new session, lifting what the previous sender held. Nothing
+ * waits for a retransmission, so a congested link loses samples instead of stalling on them.
+ * Like a WebSocket session it holds the link busy and takes the touch report per stroke (see
+ * hid_live.h), so it never interleaves with executor playback; since UDP has no close, the
+ * session ends after UDP_INPUT_SESSION_MS without datagrams.
+ */
+static void udp_input_task(void *arg)
+{
+    int sock = socket(AF_INET, SOCK_DGRAM, IPPROTO_IP);
+    if (sock < 0)
+    {
+        ESP_LOGE(TAG, "Failed to create UDP socket: errno %d", errno);
+        s_udp_task = NULL;
+        vTaskDelete(NULL);
+        return;
+    }
+
+    struct sockaddr_in addr = { 0 };
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(UDP_INPUT_PORT);
+    addr.sin_addr.s_addr = htonl(INADDR_ANY);
+    if (bind(sock, (struct sockaddr *)&addr, sizeof(addr)) < 0)
+    {
+        ESP_LOGE(TAG, "Failed to bind UDP port %d: errno %d", UDP_INPUT_PORT, errno);
+        close(sock);
+        s_udp_task = NULL;
+        vTaskDelete(NULL);
+        return;
+    }
+
+    struct timeval timeout = { .tv_sec = 0, .tv_usec = UDP_INPUT_POLL_MS * 1000 };
+    setsockopt(sock, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+    ESP_LOGI(TAG, "UDP live input listening on port %d", UDP_INPUT_PORT);
+
+    static hid_live_t live;
+    bool active = false;
+    int64_t last_rx_us = 0;
+    struct sockaddr_in peer = { 0 };
+    uint8_t buf[HID_LIVE_STATE_MAX_LEN];
+
+    for (;;)
+    {
+        struct sockaddr_in from;
+        socklen_t from_len = sizeof(from);
+        int len = recvfrom(sock, buf, sizeof(buf), 0, (struct sockaddr *)&from, &from_len);
+        const int64_t now = esp_timer_get_time();
+        if (len < 0 && active && now - last_rx_us > UDP_INPUT_SESSION_MS * 1000LL)
+        {
+            hid_live_end(&live);
+            active = false;
+        }
+        // Every pass, not only on a timeout: late or malformed datagrams keep recvfrom() returning
+        // without refreshing the state, and a finger must still be lifted after the hold time
+        if (active)
+        {
+            hid_live_poll_state(&live, now);
+        }
+        if (len < 0)
+        {
+            continue;
+        }
+
+        uint16_t conn_id;
+        const bool same_peer = active && from.sin_addr.s_addr == peer.sin_addr.s_addr && from.sin_port == peer.sin_port;
+        // A host that reconnected has a new conn_id, so the session follows it
+        if (!same_peer || hid_link_hosts(live.conn_id, &conn_id) == 0)
+        {
+            if (!udp_input_device(&conn_id))
+            {
+                continue;
+            }
+            if (active)
+            {
+                hid_live_end(&live);
+            }
+            hid_live_begin(&live, conn_id);
+            peer = from;
+            active = true;
+            const esp_ip4_addr_t ip = { .addr = from.sin_addr.s_addr };
+            ESP_LOGI(TAG, "UDP live input from " IPSTR ":%u to device %u", IP2STR(&ip), ntohs(from.sin_port), conn_id);
+        }
+
+        last_rx_us = now;
+        esp_err_t err = hid_live_feed_state(&live, buf, (size_t)len, now);
+        if (err != ESP_OK)
+        {
+            ESP_LOGD(TAG, "Dropped malformed UDP datagram of %d bytes: %s", len, esp_err_to_name(err));
+        }
+    }
+}
+
+static void start_udp_input(void)
+{
+    if (s_udp_task)
+    {
+        return;
+    }
+    if (xTaskCreate(udp_input_task, "udp_input", UDP_INPUT_TASK_STACK, NULL, UDP_INPUT_TASK_PRIO, &s_udp_task) !=
+        pdPASS)
+    {
+        s_udp_task = NULL;
+        ESP_LOGE(TAG, "Failed to create UDP input task");
+    }
+}
+#endif
+
 static esp_err_t stop_http_server(void)
 {
     if (s_httpd)
@@ -675,6 +2182,7 @@ esp_err_t network_server_start(void)
         log_current_ip();
     }
 
+    ESP_ERROR_CHECK(hid_executor_start());
     ESP_ERROR_CHECK(start_http_server());
     return ESP_OK;
 }
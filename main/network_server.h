@@ -9,7 +9,6 @@
 #include "esp_err.h"
 
 esp_err_t network_server_start(void);
-void network_server_set_hid_conn_id(uint16_t conn_id);
 
 #endif /* NETWORK_SERVER_H */
 
@@ -0,0 +1,197 @@
+/*
+ * Request body throughput: json_scan_document() against the per-field strstr + strtod lookup it
+ * replaced, which searched the whole body once for every field and parsed in double precision.
+ *
+ * Usage: bench_json_scan <corpus dir>
+ */
+
+#include <dirent.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "host_test.h"
+#include "json_scan.h"
+
+#define BENCH_MAX_BODIES 64
+#define BENCH_MAX_BYTES 4096
+#define BENCH_ROUNDS 20000
+
+typedef struct {
+    uint32_t present;
+    float x, y;
+    float start_x, start_y, end_x, end_y;
+    float spread, start_spread, end_spread;
+    float angle, start_angle, end_angle;
+    float distance, velocity;
+    uint32_t duration_ms;
+    uint32_t delay_ms;
+} bench_request_t;
+
+static const json_field_t s_fields[] = {
+    JSON_FIELD_FLOAT_OF("x", bench_request_t, x),
+    JSON_FIELD_FLOAT_OF("y", bench_request_t, y),
+    JSON_FIELD_FLOAT_OF("start_x", bench_request_t, start_x),
+    JSON_FIELD_FLOAT_OF("start_y", bench_request_t, start_y),
+    JSON_FIELD_FLOAT_OF("end_x", bench_request_t, end_x),
+    JSON_FIELD_FLOAT_OF("end_y", bench_request_t, end_y),
+    JSON_FIELD_FLOAT_OF("spread", bench_request_t, spread),
+    JSON_FIELD_FLOAT_OF("start_spread", bench_request_t, start_spread),
+    JSON_FIELD_FLOAT_OF("end_spread", bench_request_t, end_spread),
+    JSON_FIELD_FLOAT_OF("angle", bench_request_t, angle),
+    JSON_FIELD_FLOAT_OF("start_angle", bench_request_t, start_angle),
+    JSON_FIELD_FLOAT_OF("end_angle", bench_request_t, end_angle),
+    JSON_FIELD_FLOAT_OF("distance", bench_request_t, distance),
+    JSON_FIELD_FLOAT_OF("velocity", bench_request_t, velocity),
+    JSON_FIELD_UINT32_OF("duration_ms", bench_request_t, duration_ms),
+    JSON_FIELD_UINT32_OF("delay_ms", bench_request_t, delay_ms),
+};
+#define FIELD_COUNT (sizeof(s_fields) / sizeof(s_fields[0]))
+
+// The old lookup: find "key", then the colon, then strtod
+static bool legacy_number_field(const char *json, const char *key, float *out)
+{
+    char pattern[32];
+    snprintf(pattern, sizeof(pattern), "\"%s\"", key);
+    const char *pos = strstr(json, pattern);
+    if (!pos)
+    {
+        return false;
+    }
+    pos = strchr(pos + strlen(pattern), ':');
+    if (!pos)
+    {
+        return false;
+    }
+    pos++;
+    while (*pos == ' ' || *pos == '\t' || *pos == '\n' || *pos == '\r')
+    {
+        pos++;
+    }
+    char *end;
+    const double value = strtod(pos, &end);
+    if (end == pos)
+    {
+        return false;
+    }
+    *out = (float)value;
+    return true;
+}
+
+static void legacy_parse(const char *json, bench_request_t *r)
+{
+    for (size_t i = 0; i < FIELD_COUNT; ++i)
+    {
+        float value;
+        if (legacy_number_field(json, s_fields[i].key, &value))
+        {
+            r->present |= 1u << i;
+            if (s_fields[i].type == JSON_FIELD_UINT32)
+            {
+                const uint32_t u = (uint32_t)value;
+                memcpy((char *)r + s_fields[i].offset, &u, sizeof(u));
+            }
+            else
+            {
+                memcpy((char *)r + s_fields[i].offset, &value, sizeof(value));
+            }
+        }
+    }
+}
+
+typedef struct {
+    char *data;
+    size_t len;
+} body_t;
+
+static size_t load_bodies(const char *dir_path, body_t *bodies)
+{
+    DIR *dir = opendir(dir_path);
+    if (!dir)
+    {
+        return 0;
+    }
+
+    size_t count = 0;
+    struct dirent *entry;
+    while ((entry = readdir(dir)) != NULL && count < BENCH_MAX_BODIES)
+    {
+        if (entry->d_name[0] == '.')
+        {
+            continue;
+        }
+        char path[1024];
+        snprintf(path, sizeof(path), "%s/%s", dir_path, entry->d_name);
+        FILE *f = fopen(path, "rb");
+        if (!f)
+        {
+            continue;
+        }
+        char *data = malloc(BENCH_MAX_BYTES + 1);
+        const size_t len = fread(data, 1, BENCH_MAX_BYTES, f);
+        fclose(f);
+        data[len] = '\0'; // The old lookup needs a terminated body
+        bodies[count].data = data;
+        bodies[count].len = len;
+        count++;
+    }
+    closedir(dir);
+    return count;
+}
+
+int main(int argc, char **argv)
+{
+    if (argc < 2)
+    {
+        fprintf(stderr, "usage: %s <corpus dir>\n", argv[0]);
+        return 2;
+    }
+
+    body_t bodies[BENCH_MAX_BODIES];
+    const size_t count = load_bodies(argv[1], bodies);
+    HOST_CHECK(count > 0, "no bodies in %s", argv[1]);
+
+    size_t bytes = 0;
+    for (size_t i = 0; i < count; ++i)
+    {
+        bytes += bodies[i].len;
+    }
+
+    volatile uint32_t sink = 0;
+    double t0 = host_now_s();
+    for (uint32_t round = 0; round < BENCH_ROUNDS; ++round)
+    {
+        for (size_t i = 0; i < count; ++i)
+        {
+            bench_request_t r;
+            memset(&r, 0, sizeof(r));
+            json_scan_document(bodies[i].data, bodies[i].len, s_fields, FIELD_COUNT, &r, &r.present);
+            sink += r.present;
+        }
+    }
+    const double scan_s = host_now_s() - t0;
+
+    t0 = host_now_s();
+    for (uint32_t round = 0; round < BENCH_ROUNDS; ++round)
+    {
+        for (size_t i = 0; i < count; ++i)
+        {
+            bench_request_t r;
+            memset(&r, 0, sizeof(r));
+            legacy_parse(bodies[i].data, &r);
+            sink += r.present;
+        }
+    }
+    const double legacy_s = host_now_s() - t0;
+
+    const double parses = (double)BENCH_ROUNDS * count;
+    const double total_mb = (double)BENCH_ROUNDS * bytes / 1e6;
+    printf("json_scan: %.0f ns/body, %.1f MB/s\n", scan_s * 1e9 / parses, total_mb / scan_s);
+    printf("strstr/strtod: %.0f ns/body, %.1f MB/s (%.1fx)\n", legacy_s * 1e9 / parses, total_mb / legacy_s,
+           legacy_s / scan_s);
+
+    for (size_t i = 0; i < count; ++i)
+    {
+        free(bodies[i].data);
+    }
+    return 0;
+}
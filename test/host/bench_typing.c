@@ -0,0 +1,183 @@
+/*
+ * Text typing rate: the rollover typist against tapping each key, a down and an up report per
+ * character. Reports go to a simulated host that registers a press when a usage appears in a
+ * report, so a character the rollover loses fails the run instead of inflating the rate.
+ * The pacer is replaced by a timeline, so the rates are per connection interval, not measured.
+ * A /touch/tap job per key of an on-screen keyboard is slower still: its down and up are
+ * HID_TAP_HOLD_MS apart, and capitals and most symbols need a shift or layout tap as well.
+ */
+
+#include <string.h>
+
+#include "host_test.h"
+#include "hid_keyboard.h"
+
+#define BENCH_ROUNDS 2000
+#define BENCH_TAP_HOLD_MS 50 // HID_TAP_HOLD_MS: a /touch/tap job holds the contact this long
+
+static const char s_text[] =
+    "The quick brown fox jumps over the lazy dog. THE QUICK BROWN FOX, 1234567890!\n"
+    "aA Aa 1! ';\" ,< .> -_ /? Hello, World: {\"key\": [1, 2, 3]} ~`@#$%^&*()+=|\\\n"
+    "\tbookkeeper committee 2024-01-01 x=y+z; return (a < b) ? a : b;\r\n";
+
+/// The host side: keys of the last report and the text typed so far
+typedef struct {
+    uint8_t modifiers;
+    uint8_t keys[HID_KEYBOARD_KEY_SLOTS];
+    uint8_t count;
+    char typed[sizeof(s_text)];
+    size_t len;
+    bool overflow;
+    uint32_t reports;
+} bench_host_t;
+
+static bench_host_t s_host;
+static char s_reverse[2][256]; // [shift][usage] -> character
+
+void esp_hidd_send_keyboard_value(uint16_t conn_id, key_mask_t special_key_mask, uint8_t *keyboard_cmd, uint8_t num_key)
+{
+    (void)conn_id;
+    s_host.reports++;
+    for (uint8_t i = 0; i < num_key; ++i)
+    {
+        if (memchr(s_host.keys, keyboard_cmd[i], s_host.count))
+        {
+            continue;
+        }
+        const char c = s_reverse[(special_key_mask & LEFT_SHIFT_KEY_MASK) ? 1 : 0][keyboard_cmd[i]];
+        if (s_host.len < sizeof(s_host.typed) - 1)
+        {
+            s_host.typed[s_host.len++] = c ? c : '?';
+        }
+        else
+        {
+            s_host.overflow = true;
+        }
+    }
+    s_host.modifiers = special_key_mask;
+    memcpy(s_host.keys, keyboard_cmd, num_key);
+    s_host.count = num_key;
+}
+
+// Timeline only: every deadline is met at once
+void hid_pacer_begin(hid_pacer_t *pacer)
+{
+    memset(pacer, 0, sizeof(*pacer));
+}
+
+void hid_pacer_wait_until(hid_pacer_t *pacer, int64_t offset_us)
+{
+    pacer->last_planned_us = offset_us;
+    pacer->waits++;
+}
+
+void hid_pacer_sent(hid_pacer_t *pacer)
+{
+    (void)pacer;
+}
+
+void hid_pacer_skew(hid_pacer_t *pacer, int64_t skew_us)
+{
+    (void)pacer;
+    (void)skew_us;
+}
+
+void hid_pacer_finish(const hid_pacer_t *pacer, hid_pacer_stats_t *out)
+{
+    memset(out, 0, sizeof(*out));
+    out->samples = pacer->waits;
+    out->planned_us = pacer->last_planned_us;
+}
+
+static void build_reverse_map(void)
+{
+    for (uint32_t cp = 0; cp < 0x7F; ++cp)
+    {
+        hid_key_stroke_t stroke;
+        if (hid_keyboard_map_char(cp, &stroke))
+        {
+            s_reverse[stroke.modifiers ? 1 : 0][stroke.usage] = (char)cp;
+        }
+    }
+}
+
+// The text as the host should see it: CR has no stroke
+static size_t expected_text(char *out)
+{
+    size_t len = 0;
+    for (const char *p = s_text; *p; ++p)
+    {
+        if (*p != '\r')
+        {
+            out[len++] = *p;
+        }
+    }
+    out[len] = '\0';
+    return len;
+}
+
+static int bench_interval(uint32_t interval_us, const char *expected, size_t expected_len)
+{
+    const uint16_t conn_id = 0;
+    hid_pacer_stats_t timing;
+    hid_text_stats_t stats;
+
+    memset(&s_host, 0, sizeof(s_host));
+    hid_typist_t typist;
+    hid_typist_begin(&typist, &conn_id, 1, interval_us);
+    hid_typist_feed(&typist, (const uint8_t *)s_text, strlen(s_text));
+    hid_typist_finish(&typist, &timing);
+    stats = typist.stats;
+
+    HOST_CHECK(!s_host.overflow && s_host.len == expected_len && memcmp(s_host.typed, expected, expected_len) == 0,
+               "host typed \"%.*s\"", (int)s_host.len, s_host.typed);
+    HOST_CHECK(s_host.count == 0 && s_host.modifiers == 0, "keys left held");
+    HOST_CHECK(stats.chars == expected_len && stats.reports == s_host.reports, "%u chars, %u reports",
+               (unsigned)stats.chars, (unsigned)stats.reports);
+
+    // The last report still occupies its interval
+    const double rollover_s = (double)(timing.planned_us + interval_us) * 1e-6;
+    const double tap_s = 2.0 * stats.chars * interval_us * 1e-6;
+    const uint32_t hold_intervals = (BENCH_TAP_HOLD_MS * 1000 + interval_us - 1) / interval_us;
+    const double tap_job_s = (double)stats.chars * (hold_intervals + 1) * interval_us * 1e-6;
+    const double rollover_cps = stats.chars / rollover_s;
+    const double tap_cps = stats.chars / tap_s;
+    const double tap_job_cps = stats.chars / tap_job_s;
+    printf("%4.1f ms: rollover %6.1f chars/s (%.2f reports/char), tap %6.1f chars/s (%.2fx), "
+           "tap job %5.1f chars/s (%.1fx)\n",
+           interval_us * 1e-3, rollover_cps, (double)stats.reports / stats.chars, tap_cps, rollover_cps / tap_cps,
+           tap_job_cps, rollover_cps / tap_job_cps);
+    return 0;
+}
+
+int main(void)
+{
+    static const uint32_t intervals_us[] = { 7500, 15000, 30000 };
+    char expected[sizeof(s_text)];
+    const size_t expected_len = expected_text(expected);
+
+    build_reverse_map();
+    for (size_t i = 0; i < sizeof(intervals_us) / sizeof(intervals_us[0]); ++i)
+    {
+        if (bench_interval(intervals_us[i], expected, expected_len) != 0)
+        {
+            return 1;
+        }
+    }
+
+    // Planner cost on this machine, for comparison with the interval it has to fit in
+    const uint16_t conn_id = 0;
+    double t0 = host_now_s();
+    for (uint32_t round = 0; round < BENCH_ROUNDS; ++round)
+    {
+        hid_pacer_stats_t timing;
+        hid_typist_t typist;
+        memset(&s_host, 0, sizeof(s_host));
+        hid_typist_begin(&typist, &conn_id, 1, 15000);
+        hid_typist_feed(&typist, (const uint8_t *)s_text, strlen(s_text));
+        hid_typist_finish(&typist, &timing);
+    }
+    const double elapsed = host_now_s() - t0;
+    printf("planner: %.0f ns/char\n", elapsed * 1e9 / ((double)BENCH_ROUNDS * expected_len));
+    return 0;
+}
@@ -0,0 +1,49 @@
+/*
+ * Minimal helpers shared by the host tests: a fixed-seed generator so failures reproduce,
+ * and a monotonic clock for the timing lines.
+ */
+
+#ifndef HOST_TEST_H
+#define HOST_TEST_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include <time.h>
+
+static uint32_t s_host_rng = 0x2545F491u;
+
+static inline uint32_t host_rand(void)
+{
+    // xorshift32
+    s_host_rng ^= s_host_rng << 13;
+    s_host_rng ^= s_host_rng >> 17;
+    s_host_rng ^= s_host_rng << 5;
+    return s_host_rng;
+}
+
+// Uniform in [lo, hi)
+static inline float host_randf(float lo, float hi)
+{
+    return lo + (hi - lo) * (float)(host_rand() >> 8) / 16777216.0f;
+}
+
+static inline double host_now_s(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+#define HOST_CHECK(cond, ...)                                                                                \
+    do                                                                                                       \
+    {                                                                                                        \
+        if (!(cond))                                                                                         \
+        {                                                                                                    \
+            fprintf(stderr, "%s:%d: check failed: %s: ", __FILE__, __LINE__, #cond);                          \
+            fprintf(stderr, __VA_ARGS__);                                                                    \
+            fprintf(stderr, "\n");                                                                           \
+            return 1;                                                                                        \
+        }                                                                                                    \
+    } while (0)
+
+#endif /* HOST_TEST_H */
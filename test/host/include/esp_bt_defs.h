@@ -0,0 +1,6 @@
+/* Host build: only the Bluetooth types the HID profile API names. */
+#pragma once
+
+#include <stdint.h>
+
+typedef uint8_t esp_bd_addr_t[6];
@@ -0,0 +1,6 @@
+/* Host build: only the GATT types the HID profile API names. */
+#pragma once
+
+#include <stdint.h>
+
+typedef uint8_t esp_gatt_if_t;
@@ -0,0 +1,40 @@
+/* Host build: queues never hold anything; the host tests do not exercise the streaming paths. */
+#pragma once
+
+#include "freertos/FreeRTOS.h"
+
+typedef void *QueueHandle_t;
+typedef struct {
+    int unused;
+} StaticQueue_t;
+
+static inline QueueHandle_t xQueueCreateStatic(uint32_t length, uint32_t item_size, uint8_t *storage,
+                                               StaticQueue_t *queue)
+{
+    (void)length;
+    (void)item_size;
+    (void)storage;
+    return queue;
+}
+
+static inline BaseType_t xQueueReset(QueueHandle_t queue)
+{
+    (void)queue;
+    return pdTRUE;
+}
+
+static inline BaseType_t xQueueSend(QueueHandle_t queue, const void *item, TickType_t wait)
+{
+    (void)queue;
+    (void)item;
+    (void)wait;
+    return pdFALSE;
+}
+
+static inline BaseType_t xQueueReceive(QueueHandle_t queue, void *item, TickType_t wait)
+{
+    (void)queue;
+    (void)item;
+    (void)wait;
+    return pdFALSE;
+}
@@ -0,0 +1,4 @@
+/* Host build: see FreeRTOS.h. */
+#pragma once
+
+#include "freertos/FreeRTOS.h"
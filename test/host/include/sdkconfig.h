@@ -0,0 +1,2 @@
+/* Host build: no ESP-IDF configuration, both trajectory kernels are compiled and compared. */
+#pragma once
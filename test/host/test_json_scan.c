@@ -0,0 +1,348 @@
+/*
+ * json_scan against hand-written cases, then a mutation fuzz seeded from corpus/json: every
+ * mutated body is scanned from an exactly sized heap copy, so the sanitizers this target is
+ * built with catch any read past the end, and every float a successful scan stores must be finite.
+ *
+ * Usage: test_json_scan <corpus dir> [iterations]
+ */
+
+#include <dirent.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "host_test.h"
+#include "json_scan.h"
+
+#define FUZZ_ITERATIONS 2000000
+#define FUZZ_MAX_BYTES 4096 // HTTP body limit
+#define FUZZ_MAX_SEEDS 64
+#define FUZZ_MAX_MUTATIONS 4
+
+#define REQ_MAX_POINTS 12
+
+/// A reduced api_request_t with one field of every kind
+typedef struct {
+    uint32_t present;
+    float x, y;
+    float start_x;
+    uint32_t duration_ms;
+    char action[24];
+    char mode[8];
+    uint32_t point_count;
+    float xs[REQ_MAX_POINTS];
+    float ys[REQ_MAX_POINTS];
+    uint32_t speed_count;
+    float speeds[REQ_MAX_POINTS - 1];
+    uint32_t steps;
+} request_t;
+
+static bool parse_steps(json_scan_t *scan, const json_tok_t *value, void *out);
+
+static const json_field_t s_fields[] = {
+    JSON_FIELD_FLOAT_OF("x", request_t, x),
+    JSON_FIELD_FLOAT_OF("y", request_t, y),
+    JSON_FIELD_FLOAT_OF("start_x", request_t, start_x),
+    JSON_FIELD_UINT32_OF("duration_ms", request_t, duration_ms),
+    JSON_FIELD_STRING_OF("action", request_t, action),
+    JSON_FIELD_STRING_OF("mode", request_t, mode),
+    JSON_FIELD_POINTS_OF("points", request_t, xs, ys, point_count),
+    JSON_FIELD_FLOATS_OF("speeds", request_t, speeds, speed_count),
+    JSON_FIELD_CUSTOM_OF("steps", parse_steps),
+};
+#define FIELD_COUNT (sizeof(s_fields) / sizeof(s_fields[0]))
+
+static bool request_finite(const request_t *r)
+{
+    bool ok = isfinite(r->x) && isfinite(r->y) && isfinite(r->start_x);
+    for (uint32_t i = 0; i < r->point_count && i < REQ_MAX_POINTS; ++i)
+    {
+        ok = ok && isfinite(r->xs[i]) && isfinite(r->ys[i]);
+    }
+    for (uint32_t i = 0; i < r->speed_count && i < REQ_MAX_POINTS - 1; ++i)
+    {
+        ok = ok && isfinite(r->speeds[i]);
+    }
+    return ok;
+}
+
+static bool request_sane(const request_t *r)
+{
+    return request_finite(r) && r->point_count <= REQ_MAX_POINTS && r->speed_count <= REQ_MAX_POINTS - 1 &&
+           memchr(r->action, '\0', sizeof(r->action)) && memchr(r->mode, '\0', sizeof(r->mode));
+}
+
+// Like the batch endpoint: each element of "steps" is read with the same table
+static bool parse_steps(json_scan_t *scan, const json_tok_t *value, void *out)
+{
+    request_t *outer = (request_t *)out;
+    if (value->type != JSON_TOK_ARRAY_BEGIN)
+    {
+        return false;
+    }
+    for (;;)
+    {
+        json_tok_t tok;
+        const json_tok_type_t type = json_scan_next(scan, &tok);
+        if (type == JSON_TOK_ARRAY_END)
+        {
+            return true;
+        }
+        request_t step;
+        memset(&step, 0, sizeof(step));
+        if (type != JSON_TOK_OBJECT_BEGIN || !json_scan_object(scan, &tok, s_fields, FIELD_COUNT, &step, &step.present) ||
+            !request_sane(&step))
+        {
+            return false;
+        }
+        outer->steps++;
+    }
+}
+
+static bool scan(const char *json, request_t *r)
+{
+    memset(r, 0, sizeof(*r));
+    return json_scan_document(json, strlen(json), s_fields, FIELD_COUNT, r, &r->present);
+}
+
+static int check_cases(void)
+{
+    static const struct {
+        const char *json;
+        bool ok;
+    } cases[] = {
+        { "{}", true },
+        { " { \"x\" : 0.5 , \"y\" : 1 } ", true },
+        { "{\"x\":0.5,}", false },
+        { "{\"x\" 0.5}", false },
+        { "{\"x\":0.5} {}", false },
+        { "{\"x\":01}", false },
+        { "{\"x\":.5}", false },
+        { "{\"x\":1.}", false },
+        { "{\"x\":1e}", false },
+        { "{\"x\":-}", false },
+        { "{\"x\":3.4e38}", true },
+        { "{\"x\":0.5e39}", false },
+        { "{\"x\":-0.5e39}", false },
+        { "{\"x\":400000000000000000000000000000000000000}", false },
+        { "{\"x\":1e-60}", true },
+        { "{\"x\":\"0.5\"}", false },
+        { "{\"action\":\"tap\\u0041\"}", true },
+        { "{\"action\":\"tap\\x\"}", false },
+        { "{\"action\":\"unterminated}", false },
+        { "{\"mode\":\"far too long\"}", false },
+        { "{\"points\":[{\"x\":0.1,\"y\":0.2}]]}", false },
+        { "[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]", false },
+        { "{\"steps\":[{\"x\":1},{\"points\":[]}]}", true },
+        { "{\"steps\":[{\"x\":1},2]}", false },
+    };
+
+    request_t r;
+    for (size_t i = 0; i < sizeof(cases) / sizeof(cases[0]); ++i)
+    {
+        HOST_CHECK(scan(cases[i].json, &r) == cases[i].ok, "%s should %s", cases[i].json,
+                   cases[i].ok ? "parse" : "be rejected");
+    }
+
+    // Keys match exactly and at the top level only
+    HOST_CHECK(scan("{\"start_x\":0.25,\"extra\":{\"x\":9},\"y\":0.75}", &r), "nested keys");
+    HOST_CHECK(r.present == ((1u << 1) | (1u << 2)) && r.start_x == 0.25f && r.y == 0.75f, "nested keys: present %#x",
+               (unsigned)r.present);
+
+    HOST_CHECK(scan("{\"duration_ms\":600,\"points\":[{\"x\":0.5,\"y\":0.125},{\"y\":1,\"x\":0}]}", &r), "points");
+    HOST_CHECK(r.duration_ms == 600 && r.point_count == 2 && r.xs[0] == 0.5f && r.ys[0] == 0.125f && r.xs[1] == 0.0f &&
+                   r.ys[1] == 1.0f,
+               "points: %u", (unsigned)r.point_count);
+
+    HOST_CHECK(scan("{\"action\":\"a\\\"b\\\\c\\/d\"}", &r) && strcmp(r.action, "a\"b\\c/d") == 0, "escapes: %s",
+               r.action);
+    printf("cases: %zu passed\n", sizeof(cases) / sizeof(cases[0]) + 3);
+    return 0;
+}
+
+typedef struct {
+    char *data;
+    size_t len;
+} seed_t;
+
+static size_t load_seeds(const char *dir_path, seed_t *seeds)
+{
+    DIR *dir = opendir(dir_path);
+    if (!dir)
+    {
+        return 0;
+    }
+
+    size_t count = 0;
+    struct dirent *entry;
+    while ((entry = readdir(dir)) != NULL && count < FUZZ_MAX_SEEDS)
+    {
+        if (entry->d_name[0] == '.')
+        {
+            continue;
+        }
+        char path[1024];
+        snprintf(path, sizeof(path), "%s/%s", dir_path, entry->d_name);
+        FILE *f = fopen(path, "rb");
+        if (!f)
+        {
+            continue;
+        }
+        char *data = malloc(FUZZ_MAX_BYTES);
+        const size_t len = fread(data, 1, FUZZ_MAX_BYTES, f);
+        fclose(f);
+        seeds[count].data = data;
+        seeds[count].len = len;
+        count++;
+    }
+    closedir(dir);
+    return count;
+}
+
+// Bytes that move the scanner between states, more useful than uniform noise
+static char fuzz_byte(void)
+{
+    static const char alphabet[] = "{}[]\":,.-+eE0123456789 \\u/tfnrlsa\n\x7f\x80";
+    return (host_rand() % 4 == 0) ? (char)host_rand() : alphabet[host_rand() % (sizeof(alphabet) - 1)];
+}
+
+static size_t fuzz_mutate(char *buf, size_t len, const seed_t *seeds, size_t seed_count)
+{
+    const uint32_t mutations = 1 + host_rand() % FUZZ_MAX_MUTATIONS;
+    for (uint32_t m = 0; m < mutations; ++m)
+    {
+        const size_t at = len ? host_rand() % len : 0;
+        switch (host_rand() % 6)
+        {
+        case 0: // overwrite
+            if (len)
+            {
+                buf[at] = fuzz_byte();
+            }
+            break;
+        case 1: // insert
+            if (len < FUZZ_MAX_BYTES)
+            {
+                memmove(&buf[at + 1], &buf[at], len - at);
+                buf[at] = fuzz_byte();
+                len++;
+            }
+            break;
+        case 2: // delete a run
+        {
+            const size_t n = len ? 1 + host_rand() % (len - at < 8 ? len - at : 8) : 0;
+            memmove(&buf[at], &buf[at + n], len - at - n);
+            len -= n;
+            break;
+        }
+        case 3: // truncate
+            len = at;
+            break;
+        case 4: // duplicate a run, e.g. an array element or a nesting level
+        {
+            const size_t n = len ? 1 + host_rand() % (len - at < 32 ? len - at : 32) : 0;
+            if (len + n <= FUZZ_MAX_BYTES)
+            {
+                memmove(&buf[at + n], &buf[at], len - at);
+                len += n;
+            }
+            break;
+        }
+        default: // splice the tail of another seed
+        {
+            const seed_t *other = &seeds[host_rand() % seed_count];
+            if (other->len)
+            {
+                const size_t from = host_rand() % other->len;
+                const size_t n = (other->len - from < FUZZ_MAX_BYTES - at) ? other->len - from : FUZZ_MAX_BYTES - at;
+                memcpy(&buf[at], &other->data[from], n);
+                len = at + n;
+            }
+            break;
+        }
+        }
+    }
+    return len;
+}
+
+// Pull every token: slices stay inside the body and the scan ends in at most one token per byte
+static int fuzz_tokens(const char *body, size_t len)
+{
+    json_scan_t scan;
+    json_scan_init(&scan, body, len);
+    json_tok_t tok;
+    for (size_t n = 0;; ++n)
+    {
+        HOST_CHECK(n <= len + 1, "scanner does not terminate on a %zu byte body", len);
+        const json_tok_type_t type = json_scan_next(&scan, &tok);
+        if (type == JSON_TOK_END || type == JSON_TOK_ERROR)
+        {
+            return 0;
+        }
+        if (type == JSON_TOK_KEY || type == JSON_TOK_STRING)
+        {
+            HOST_CHECK(tok.str >= body && tok.str + tok.len <= body + len, "string slice outside the body");
+        }
+        if (type == JSON_TOK_NUMBER)
+        {
+            HOST_CHECK(isfinite(tok.num), "non-finite number in %.*s", (int)len, body);
+        }
+    }
+}
+
+static int fuzz(const char *corpus, uint32_t iterations)
+{
+    seed_t seeds[FUZZ_MAX_SEEDS];
+    const size_t seed_count = load_seeds(corpus, seeds);
+    HOST_CHECK(seed_count > 0, "no seeds in %s", corpus);
+
+    char *buf = malloc(FUZZ_MAX_BYTES);
+    uint32_t accepted = 0;
+    for (uint32_t i = 0; i < iterations; ++i)
+    {
+        const seed_t *seed = &seeds[host_rand() % seed_count];
+        memcpy(buf, seed->data, seed->len);
+        const size_t len = fuzz_mutate(buf, seed->len, seeds, seed_count);
+
+        // Exactly sized, unterminated: a read past len is a heap overflow
+        char *body = malloc(len ? len : 1);
+        memcpy(body, buf, len);
+
+        request_t r;
+        memset(&r, 0, sizeof(r));
+        if (json_scan_document(body, len, s_fields, FIELD_COUNT, &r, &r.present))
+        {
+            accepted++;
+            HOST_CHECK(request_sane(&r), "accepted body %.*s left an invalid request", (int)len, body);
+        }
+        if (fuzz_tokens(body, len) != 0)
+        {
+            return 1;
+        }
+        free(body);
+    }
+
+    printf("fuzz: %u bodies from %zu seeds, %u accepted\n", iterations, seed_count, accepted);
+    free(buf);
+    for (size_t i = 0; i < seed_count; ++i)
+    {
+        free(seeds[i].data);
+    }
+    return 0;
+}
+
+int main(int argc, char **argv)
+{
+    if (argc < 2)
+    {
+        fprintf(stderr, "usage: %s <corpus dir> [iterations]\n", argv[0]);
+        return 2;
+    }
+    const uint32_t iterations = (argc > 2) ? (uint32_t)strtoul(argv[2], NULL, 10) : FUZZ_ITERATIONS;
+
+    if (check_cases() != 0 || fuzz(argv[1], iterations) != 0)
+    {
+        return 1;
+    }
+    return 0;
+}
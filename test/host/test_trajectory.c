@@ -0,0 +1,132 @@
+/*
+ * Fixed-point trajectory kernels against the float reference: every mapped coordinate must
+ * agree to within 1 LSB, over random swipes and pinch/rotate gestures inside [0, 1]. Also times
+ * both kernels per point; on the host that only shows the relative cost, not ESP32 cycles.
+ */
+
+#include <stdlib.h>
+
+#include "host_test.h"
+#include "hid_trajectory.h"
+
+#define SWIPE_CASES 200000
+#define PAIR_CASES 200000
+#define TIMING_POINTS 20000000
+
+static int check_swipe(void)
+{
+    int worst = 0;
+    for (int i = 0; i < SWIPE_CASES; ++i)
+    {
+        const float sx = host_randf(0.0f, 1.0f), sy = host_randf(0.0f, 1.0f);
+        const float ex = host_randf(0.0f, 1.0f), ey = host_randf(0.0f, 1.0f);
+        const uint32_t steps = 1 + host_rand() % 120;
+
+        hid_traj_swipe_f_t f;
+        hid_traj_swipe_fx_t fx;
+        hid_traj_swipe_init_f(&f, sx, sy, ex, ey, steps);
+        hid_traj_swipe_init_fx(&fx, sx, sy, ex, ey, steps);
+
+        for (uint32_t step = 0; step <= steps; ++step)
+        {
+            uint16_t xf, yf, xq, yq;
+            hid_traj_swipe_point_f(&f, step, &xf, &yf);
+            hid_traj_swipe_point_fx(&fx, step, &xq, &yq);
+            const int dx = abs(xf - xq), dy = abs(yf - yq);
+            worst = dx > worst ? dx : worst;
+            worst = dy > worst ? dy : worst;
+            HOST_CHECK(dx <= 1 && dy <= 1, "swipe (%.9g, %.9g) -> (%.9g, %.9g) steps %u step %u: float (%u, %u) fixed (%u, %u)",
+                       sx, sy, ex, ey, steps, step, xf, yf, xq, yq);
+        }
+    }
+    printf("swipe: %d cases, worst difference %d LSB\n", SWIPE_CASES, worst);
+    return 0;
+}
+
+// Worst difference over every step of one pinch/rotate, or -1 past 1 LSB
+static int pair_case(float cx, float cy, float s0, float s1, float a0, float a1, uint32_t steps)
+{
+    hid_traj_pair_f_t f;
+    hid_traj_pair_fx_t fx;
+    hid_traj_pair_init_f(&f, cx, cy, s0, s1, a0, a1, steps);
+    hid_traj_pair_init_fx(&fx, cx, cy, s0, s1, a0, a1, steps);
+
+    int worst = 0;
+    for (uint32_t step = 0; step <= steps; ++step)
+    {
+        uint16_t xf[2], yf[2], xq[2], yq[2];
+        hid_traj_pair_point_f(&f, step, xf, yf);
+        hid_traj_pair_point_fx(&fx, step, xq, yq);
+        for (int c = 0; c < 2; ++c)
+        {
+            const int dx = abs(xf[c] - xq[c]), dy = abs(yf[c] - yq[c]);
+            worst = dx > worst ? dx : worst;
+            worst = dy > worst ? dy : worst;
+            if (dx > 1 || dy > 1)
+            {
+                fprintf(stderr, "FAIL pair center (%.9g, %.9g) spread %.9g -> %.9g angle %.9g -> %.9g steps %u step %u "
+                                "contact %d: float (%u, %u) fixed (%u, %u)\n",
+                        cx, cy, s0, s1, a0, a1, steps, step, c, xf[c], yf[c], xq[c], yq[c]);
+                return -1;
+            }
+        }
+    }
+    return worst;
+}
+
+static int check_pair(void)
+{
+    // 2 LSB off while the tables were Q15: a large rotation amplifies the ease table error
+    HOST_CHECK(pair_case(0.306341648f, 0.687343061f, 0.232361555f, 0.89064914f, -179.853729f, 117.532745f, 49) >= 0,
+               "pair regression case");
+
+    int worst = 0;
+    for (int i = 0; i < PAIR_CASES; ++i)
+    {
+        const float cx = host_randf(0.0f, 1.0f), cy = host_randf(0.0f, 1.0f);
+        const float s0 = host_randf(0.0f, 1.0f), s1 = host_randf(0.0f, 1.0f);
+        const float a0 = host_randf(-180.0f, 180.0f), a1 = host_randf(-180.0f, 180.0f);
+        const int diff = pair_case(cx, cy, s0, s1, a0, a1, 1 + host_rand() % 120);
+        HOST_CHECK(diff >= 0, "pair case %d", i);
+        worst = diff > worst ? diff : worst;
+    }
+    printf("pair: %d cases, worst difference %d LSB\n", PAIR_CASES, worst);
+    return 0;
+}
+
+static void time_swipe(void)
+{
+    hid_traj_swipe_f_t f;
+    hid_traj_swipe_fx_t fx;
+    hid_traj_swipe_init_f(&f, 0.1f, 0.8f, 0.9f, 0.2f, 1000);
+    hid_traj_swipe_init_fx(&fx, 0.1f, 0.8f, 0.9f, 0.2f, 1000);
+
+    volatile uint32_t sink = 0;
+    uint16_t x, y;
+    double t0 = host_now_s();
+    for (uint32_t i = 0; i < TIMING_POINTS; ++i)
+    {
+        hid_traj_swipe_point_f(&f, i % 1001, &x, &y);
+        sink += x + y;
+    }
+    double t1 = host_now_s();
+    for (uint32_t i = 0; i < TIMING_POINTS; ++i)
+    {
+        hid_traj_swipe_point_fx(&fx, i % 1001, &x, &y);
+        sink += x + y;
+    }
+    double t2 = host_now_s();
+    (void)sink;
+    printf("swipe point: float %.1f ns, fixed %.1f ns\n", (t1 - t0) * 1e9 / TIMING_POINTS,
+           (t2 - t1) * 1e9 / TIMING_POINTS);
+}
+
+int main(void)
+{
+    if (check_swipe() != 0 || check_pair() != 0)
+    {
+        return 1;
+    }
+    time_swipe();
+    return 0;
+}